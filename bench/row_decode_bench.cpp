@@ -0,0 +1,246 @@
+#include <yotta.token.client.hpp>
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Benchmark of the native client's row decoding against JSON decoding of the same rows.
+ *
+ * It generates `accounts` and `acclock` rows and serializes each table twice: as the binary rows
+ * the client decodes, in one buffer as state history and snapshots deliver them, and as the JSON
+ * of `get_table_rows` with ABI serialization, large integers quoted as nodeos does. Both are
+ * decoded into the client's row structs, the best of `--rounds` rounds is reported, and
+ * allocations are counted through the global allocator.
+ *
+ * Usage: row_decode_bench [--rows N] [--rounds N]
+ *
+ * Exits 1 when the two decodings disagree.
+ */
+using namespace yotta;
+
+namespace {
+
+   uint64_t allocations = 0;
+
+}
+
+void* operator new( std::size_t size )
+{
+   allocations++;
+   if ( void* p = std::malloc( size ? size : 1 ) ) return p;
+   throw std::bad_alloc();
+}
+
+void operator delete( void* p ) noexcept { std::free( p ); }
+void operator delete( void* p, std::size_t ) noexcept { std::free( p ); }
+
+namespace {
+
+   const char* const codes[] = { "AAA", "BBB", "CCC", "YTA" };
+   constexpr uint8_t precision = 4;
+
+   /// Rows of one table, in one buffer.
+   struct binary_rows {
+      std::vector<char>                      bytes;
+      std::vector<std::pair<size_t, size_t>> rows; //offset, size
+   };
+
+   void add_row( binary_rows& out, data_writer& w ) {
+      auto row = w.release();
+      out.rows.emplace_back( out.bytes.size(), row.size() );
+      out.bytes.insert( out.bytes.end(), row.begin(), row.end() );
+   }
+
+   /// A uint64 as nodeos writes it, quoted above 32 bits.
+   std::string json_uint( uint64_t v ) {
+      return v > 0xffffffff ? "\"" + std::to_string( v ) + "\"" : std::to_string( v );
+   }
+
+   uint64_t json_to_uint( const Json::Value& v ) {
+      return v.isString() ? std::strtoull( v.asCString(), nullptr, 10 ) : v.asUInt64();
+   }
+
+   /// Parses an asset string like "12.3456 AAA".
+   asset_t json_to_asset( const Json::Value& v ) {
+      std::string s = v.asString();
+      asset_t a;
+      size_t space = s.find( ' ' );
+      size_t dot = s.find( '.' );
+      uint8_t prec = dot < space ? space - dot - 1 : 0;
+      bool negative = !s.empty() && s[0] == '-';
+      for( size_t i = negative; i < space; i++ ) {
+         if ( s[i] != '.' ) a.amount = a.amount * 10 + ( s[i] - '0' );
+      }
+      if ( negative ) a.amount = -a.amount;
+      a.symbol = string_to_symbol( prec, std::string_view( s ).substr( space + 1 ) );
+      return a;
+   }
+
+   struct tables {
+      binary_rows accounts;
+      binary_rows acclocks;
+      std::string accounts_json;
+      std::string acclocks_json;
+   };
+
+   tables generate( size_t count ) {
+      std::mt19937_64 rng( 1 );
+      tables out;
+      out.accounts_json = "{\"rows\":[";
+      out.acclocks_json = "{\"rows\":[";
+      for( size_t i = 0; i < count; i++ ) {
+         asset_t balance{ (int64_t)( rng() % 100000000000LL ), string_to_symbol( precision, codes[rng() % 4] ) };
+         data_writer w;
+         w.write_asset( balance );
+         add_row( out.accounts, w );
+         out.accounts_json += ( i ? "," : "" ) + std::string( "{\"balance\":\"" ) + asset_to_string( balance ) + "\"}";
+
+         acclock_row lock;
+         lock.no_ruleid = ( ( 1 + rng() % 4 ) << 32 ) + 101 + rng() % 20;
+         lock.quantity = asset_t{ (int64_t)( rng() % 1000000000 ), balance.symbol };
+         lock.user = rng() & ~0xfULL;
+         lock.time = 1600000000 + rng() % 100000000;
+         w.write( lock.no_ruleid ).write_asset( lock.quantity ).write( lock.user ).write( lock.time );
+         add_row( out.acclocks, w );
+         out.acclocks_json += ( i ? "," : "" ) + std::string( "{\"no_ruleid\":" ) + json_uint( lock.no_ruleid )
+                            + ",\"quantity\":\"" + asset_to_string( lock.quantity ) + "\",\"user\":\""
+                            + name_to_string( lock.user ) + "\",\"time\":" + json_uint( lock.time ) + "}";
+      }
+      out.accounts_json += "],\"more\":false,\"next_key\":\"\"}";
+      out.acclocks_json += "],\"more\":false,\"next_key\":\"\"}";
+      return out;
+   }
+
+   /// Folds the fields of a row, to check that both decodings agree.
+   uint64_t fold( uint64_t sum, const account_row& r ) { return sum * 31 + r.balance.amount + r.balance.symbol; }
+   uint64_t fold( uint64_t sum, const acclock_row& r ) {
+      return sum * 31 + r.no_ruleid + r.quantity.amount + r.quantity.symbol + r.user + r.time;
+   }
+
+   template<typename Row>
+   uint64_t decode_binary( const binary_rows& in ) {
+      uint64_t sum = 0;
+      for( const auto& [offset, size] : in.rows ) {
+         Row r;
+         if ( !decode( in.bytes.data() + offset, size, r ) ) {
+            std::fprintf( stderr, "malformed row\n" );
+            std::exit( 1 );
+         }
+         sum = fold( sum, r );
+      }
+      return sum;
+   }
+
+   Json::Value parse( const std::string& doc ) {
+      Json::CharReaderBuilder builder;
+      std::unique_ptr<Json::CharReader> reader( builder.newCharReader() );
+      Json::Value root;
+      std::string errors;
+      if ( !reader->parse( doc.data(), doc.data() + doc.size(), &root, &errors ) ) {
+         std::fprintf( stderr, "malformed json: %s\n", errors.c_str() );
+         std::exit( 1 );
+      }
+      return root;
+   }
+
+   uint64_t decode_json_accounts( const std::string& doc ) {
+      uint64_t    sum = 0;
+      Json::Value root = parse( doc );
+      for( const auto& row : root["rows"] ) {
+         account_row r;
+         r.balance = json_to_asset( row["balance"] );
+         sum = fold( sum, r );
+      }
+      return sum;
+   }
+
+   uint64_t decode_json_acclocks( const std::string& doc ) {
+      uint64_t    sum = 0;
+      Json::Value root = parse( doc );
+      for( const auto& row : root["rows"] ) {
+         acclock_row r;
+         r.no_ruleid = json_to_uint( row["no_ruleid"] );
+         r.quantity = json_to_asset( row["quantity"] );
+         r.user = string_to_name( row["user"].asString() );
+         r.time = json_to_uint( row["time"] );
+         sum = fold( sum, r );
+      }
+      return sum;
+   }
+
+   struct timing {
+      double   seconds = 0; //of the best round
+      uint64_t allocations = 0; //per round
+      uint64_t sum = 0;
+   };
+
+   template<typename F>
+   timing measure( size_t rounds, F&& decode_all ) {
+      timing t;
+      for( size_t i = 0; i < rounds; i++ ) {
+         uint64_t allocated = allocations;
+         auto begin = std::chrono::steady_clock::now();
+         t.sum = decode_all();
+         double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+         t.allocations = allocations - allocated;
+         if ( i == 0 || seconds < t.seconds ) t.seconds = seconds;
+      }
+      return t;
+   }
+
+   void report( const char* table, const char* decoder, size_t rows, size_t bytes, const timing& t ) {
+      std::printf( "%-8s %-7s %12.0f rows/s %8.1f ns/row %8.1f MB/s %6.2f allocations/row\n", table, decoder,
+                   rows / t.seconds, t.seconds * 1e9 / rows, bytes / t.seconds / 1e6, (double)t.allocations / rows );
+   }
+
+} /// namespace
+
+int main( int argc, char** argv )
+{
+   size_t rows = 1000000;
+   size_t rounds = 5;
+   for( int i = 1; i + 1 < argc; i += 2 ) {
+      if ( std::strcmp( argv[i], "--rows" ) == 0 ) {
+         rows = std::strtoull( argv[i + 1], nullptr, 10 );
+      } else if ( std::strcmp( argv[i], "--rounds" ) == 0 ) {
+         rounds = std::max<size_t>( 1, std::strtoull( argv[i + 1], nullptr, 10 ) );
+      } else {
+         std::fprintf( stderr, "usage: %s [--rows N] [--rounds N]\n", argv[0] );
+         return 2;
+      }
+   }
+   if ( rows == 0 ) return 0;
+
+   tables t = generate( rows );
+   bool agree = true;
+
+   timing accounts_binary = measure( rounds, [&] { return decode_binary<account_row>( t.accounts ); } );
+   timing accounts_json = measure( rounds, [&] { return decode_json_accounts( t.accounts_json ); } );
+   report( "accounts", "client", rows, t.accounts.bytes.size(), accounts_binary );
+   report( "accounts", "json", rows, t.accounts_json.size(), accounts_json );
+   agree &= accounts_binary.sum == accounts_json.sum;
+
+   timing acclocks_binary = measure( rounds, [&] { return decode_binary<acclock_row>( t.acclocks ); } );
+   timing acclocks_json = measure( rounds, [&] { return decode_json_acclocks( t.acclocks_json ); } );
+   report( "acclock", "client", rows, t.acclocks.bytes.size(), acclocks_binary );
+   report( "acclock", "json", rows, t.acclocks_json.size(), acclocks_json );
+   agree &= acclocks_binary.sum == acclocks_json.sum;
+
+   std::printf( "client speedup: accounts %.1fx, acclock %.1fx\n", accounts_json.seconds / accounts_binary.seconds,
+                acclocks_json.seconds / acclocks_binary.seconds );
+   if ( !agree ) {
+      std::fprintf( stderr, "the client and json decodings differ\n" );
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,320 @@
+#include "exporter.hpp"
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+namespace yotta::exporter {
+
+   namespace {
+
+      constexpr uint64_t stat_table      = string_to_name( "stat" );
+      constexpr uint64_t accounts_table  = string_to_name( "accounts" );
+      constexpr uint64_t tokenpool_table = string_to_name( "tokenpool" );
+      constexpr uint64_t lockrule_table  = string_to_name( "lockrule" );
+      constexpr uint64_t lockrule2_table = string_to_name( "lockrule2" );
+      constexpr uint64_t acclock_table   = string_to_name( "acclock" );
+      constexpr uint64_t acclock2_table  = string_to_name( "acclock2" );
+      constexpr uint64_t numlock_table   = string_to_name( "numlock" );
+      constexpr uint64_t numlock2_table  = string_to_name( "numlock2" );
+      constexpr uint64_t loanpool_table  = string_to_name( "loanpool" );
+      constexpr uint64_t loanpool2_table = string_to_name( "loanpool2" );
+      constexpr uint64_t subledger_table = string_to_name( "subledger" );
+
+      bool is_exported_table( uint64_t table )
+      {
+         switch( table ) {
+            case stat_table: case accounts_table: case tokenpool_table: case lockrule_table: case lockrule2_table:
+            case acclock_table: case acclock2_table: case numlock_table: case numlock2_table: case loanpool_table:
+            case loanpool2_table: case subledger_table:
+               return true;
+         }
+         return false;
+      }
+
+      std::string symbol_code_to_string( uint64_t code )
+      {
+         std::string s;
+         for( ; code; code >>= 8 ) s.push_back( (char)( code & 0xff ) );
+         return s;
+      }
+
+      template<typename T>
+      std::string join( const array_view<T>& a )
+      {
+         std::string s;
+         for( uint32_t i = 0; i < a.size(); i++ ) {
+            if ( i ) s.push_back( ' ' );
+            s += std::to_string( a[i] );
+         }
+         return s;
+      }
+
+      struct token_counts {
+         uint64_t    holders = 0;
+         uint64_t    rows = 0;
+         uint64_t    skipped = 0;
+      };
+
+      /// Writes the files of the token of `st` to `dir`.
+      class token_export {
+         public:
+            token_export( const contract_rows& rows, const currency_stat_row& st, const std::string& dir,
+                          output_format format, uint32_t time )
+            : rows(rows), st(st), code(st.supply.code()), dir(dir), format(format), time(time) {}
+
+            token_counts run() {
+               std::filesystem::create_directories( dir );
+               write_stat();
+               write_accounts();
+               write_numlock();
+               write_acclock();
+               write_lockrule();
+               write_loanpool();
+               write_tokenpool();
+               write_subledger();
+               return counts;
+            }
+
+         private:
+            std::unique_ptr<table_writer> open( const char* table, std::vector<column> columns ) {
+               return make_table_writer( format, dir + "/" + table, std::move( columns ) );
+            }
+
+            void close( table_writer& w ) {
+               w.finish();
+               counts.rows += w.rows();
+            }
+
+            /// Calls `f( row )` on the rows of `table` in the token's scope, counting those that do not decode.
+            template<typename Row, typename Decode, typename F>
+            void each_scope_row( uint64_t table, Decode&& decode_row, F&& f ) {
+               auto [begin, end] = rows.scope_rows( table, code );
+               Row r;
+               for( auto it = begin; it != end; ++it ) {
+                  if ( decode_row( it->value.data(), it->value.size(), r ) ) f( r );
+                  else counts.skipped++;
+               }
+            }
+
+            void write_stat() {
+               auto w = open( "stat", { { "symbol", column_type::string }, { "precision", column_type::int64 },
+                                        { "supply", column_type::int64 }, { "max_supply", column_type::int64 },
+                                        { "issuer", column_type::name }, { "poolsetter", column_type::name },
+                                        { "unlocker", column_type::name }, { "time", column_type::int64 },
+                                        { "tokenno", column_type::int64 } } );
+               w->add( std::string_view( symbol_code_to_string( code ) ) );
+               w->add( (int64_t)st.supply.precision() );
+               w->add( st.supply.amount );
+               w->add( st.max_supply.amount );
+               w->add_name( st.issuer );
+               w->add_name( st.poolsetter );
+               w->add_name( st.unlocker );
+               w->add( (int64_t)st.time );
+               w->add( (int64_t)st.tokenno );
+               w->end_row();
+               close( *w );
+            }
+
+            void write_accounts() {
+               auto w = open( "accounts", { { "owner", column_type::name }, { "balance", column_type::int64 },
+                                            { "locked", column_type::int64 }, { "loaned", column_type::int64 },
+                                            { "allocated", column_type::int64 }, { "available", column_type::int64 } } );
+               for( const auto& r : rows.accounts_of( code ) ) {
+                  holder_state h;
+                  if ( !holder_from_tables( rows, r.scope, code, time, h ) ) {
+                     counts.skipped++;
+                     continue;
+                  }
+                  w->add_name( r.scope );
+                  w->add( h.balance );
+                  w->add( h.locked );
+                  w->add( h.loaned );
+                  w->add( h.allocated );
+                  w->add( h.available() );
+                  w->end_row();
+                  counts.holders++;
+               }
+               close( *w );
+            }
+
+            void write_numlock() {
+               auto w = open( "numlock", { { "table", column_type::string }, { "user", column_type::name },
+                                           { "amount", column_type::int64 } } );
+               auto add = [&]( std::string_view table, const numlock_row& r ) {
+                  w->add( table );
+                  w->add_name( r.user );
+                  w->add( r.quantity.amount );
+                  w->end_row();
+               };
+               uint64_t symbol = st.supply.symbol;
+               each_scope_row<numlock_row>( numlock2_table, [&]( const char* d, size_t s, numlock_row& r ) {
+                  return decode_numlock2( d, s, symbol, r );
+               }, [&]( const numlock_row& r ) { add( "numlock2", r ); } );
+               each_scope_row<numlock_row>( numlock_table, []( const char* d, size_t s, numlock_row& r ) {
+                  return decode( d, s, r );
+               }, [&]( const numlock_row& r ) { add( "numlock", r ); } );
+               close( *w );
+            }
+
+            void write_acclock() {
+               auto w = open( "acclock", { { "table", column_type::string }, { "user", column_type::name },
+                                           { "lockruleid", column_type::int64 }, { "amount", column_type::int64 },
+                                           { "time", column_type::int64 } } );
+               auto add = [&]( std::string_view table, const acclock_row& r ) {
+                  w->add( table );
+                  w->add_name( r.user );
+                  w->add( (int64_t)r.lockruleid() );
+                  w->add( r.quantity.amount );
+                  w->add( (int64_t)r.time );
+                  w->end_row();
+               };
+               acclock_row lock;
+               for( const auto& r : rows.acclocks2_of( st.tokenno ) ) {
+                  if ( decode_acclock2( r.value.data(), r.value.size(), r.scope, lock ) ) add( "acclock2", lock );
+                  else counts.skipped++;
+               }
+               for( const auto& r : rows.acclocks_of( code ) ) {
+                  if ( decode( r.value.data(), r.value.size(), lock ) ) add( "acclock", lock );
+               }
+               close( *w );
+            }
+
+            void write_lockrule() {
+               auto w = open( "lockrule", { { "table", column_type::string }, { "lockruleid", column_type::int64 },
+                                            { "times", column_type::string }, { "pcts", column_type::string },
+                                            { "base", column_type::int64 }, { "period", column_type::int64 },
+                                            { "desc", column_type::string } } );
+               auto add = [&]( std::string_view table, const auto& r ) {
+                  w->add( table );
+                  w->add( (int64_t)r.lockruleid );
+                  w->add( std::string_view( join( r.times ) ) );
+                  w->add( std::string_view( join( r.pcts ) ) );
+                  w->add( (int64_t)r.base );
+                  w->add( (int64_t)r.period );
+                  w->add( r.desc );
+                  w->end_row();
+               };
+               auto decode_rule = []( const char* d, size_t s, auto& r ) { return decode( d, s, r ); };
+               each_scope_row<lockrule2_row>( lockrule2_table, decode_rule, [&]( const lockrule2_row& r ) { add( "lockrule2", r ); } );
+               each_scope_row<lockrule_row>( lockrule_table, decode_rule, [&]( const lockrule_row& r ) { add( "lockrule", r ); } );
+               close( *w );
+            }
+
+            void write_loanpool() {
+               auto w = open( "loanpool", { { "table", column_type::string }, { "from", column_type::name },
+                                            { "manager", column_type::name }, { "amount", column_type::int64 } } );
+               auto add = [&]( std::string_view table, const loanpool_row& r ) {
+                  w->add( table );
+                  w->add_name( r.from );
+                  w->add_name( r.manager );
+                  w->add( r.quantity.amount );
+                  w->end_row();
+               };
+               uint64_t symbol = st.supply.symbol;
+               each_scope_row<loanpool_row>( loanpool2_table, [&]( const char* d, size_t s, loanpool_row& r ) {
+                  return decode_loanpool2( d, s, symbol, r );
+               }, [&]( const loanpool_row& r ) { add( "loanpool2", r ); } );
+               each_scope_row<loanpool_row>( loanpool_table, []( const char* d, size_t s, loanpool_row& r ) {
+                  return decode( d, s, r );
+               }, [&]( const loanpool_row& r ) { add( "loanpool", r ); } );
+               close( *w );
+            }
+
+            void write_tokenpool() {
+               auto w = open( "tokenpool", { { "user", column_type::name }, { "pool_name", column_type::string },
+                                             { "memo", column_type::string } } );
+               each_scope_row<tokenpool_row>( tokenpool_table, []( const char* d, size_t s, tokenpool_row& r ) {
+                  return decode( d, s, r );
+               }, [&]( const tokenpool_row& r ) {
+                  w->add_name( r.user );
+                  w->add( r.pool_name );
+                  w->add( r.memo );
+                  w->end_row();
+               } );
+               close( *w );
+            }
+
+            void write_subledger() {
+               auto w = open( "subledger", { { "owner", column_type::name }, { "allocated", column_type::int64 } } );
+               each_scope_row<subledger_row>( subledger_table, []( const char* d, size_t s, subledger_row& r ) {
+                  return decode( d, s, r );
+               }, [&]( const subledger_row& r ) {
+                  w->add_name( r.owner );
+                  w->add( r.allocated );
+                  w->end_row();
+               } );
+               close( *w );
+            }
+
+            const contract_rows&       rows;
+            const currency_stat_row&   st;
+            uint64_t                   code;
+            std::string                dir;
+            output_format              format;
+            uint32_t                   time;
+            token_counts               counts;
+      };
+
+   } /// namespace
+
+   export_stats export_snapshot( std::string_view data, const std::string& out_dir, const export_options& opt )
+   {
+      export_stats stats;
+      contract_rows rows;
+      stats.snapshot = read_snapshot( data, opt.contract, is_exported_table, rows );
+      if ( opt.time ) {
+         stats.time = *opt.time;
+      } else if ( stats.snapshot.block_time ) {
+         stats.time = *stats.snapshot.block_time;
+      } else {
+         throw std::runtime_error( "cannot read the block time of chain snapshot version " +
+                                   std::to_string( stats.snapshot.chain_version ) + ", give the time of the balances" );
+      }
+      unsigned threads = opt.threads ? opt.threads : 1;
+      rows.seal( threads );
+      stats.contract_rows = rows.size();
+
+      //the tokens are the stat rows, each in the scope of its symbol code
+      std::vector<currency_stat_row> tokens;
+      for( const auto& r : rows.table_rows( stat_table ) ) {
+         currency_stat_row st;
+         if ( r.scope == r.pk && decode( r.value.data(), r.value.size(), st ) && st.supply.code() == r.pk ) tokens.push_back( st );
+         else stats.skipped++;
+      }
+      stats.tokens = tokens.size();
+
+      std::atomic<size_t>  next{ 0 };
+      std::mutex           mutex;
+      std::exception_ptr   error;
+      auto export_tokens = [&]() {
+         token_counts total;
+         try {
+            for( size_t i = next++; i < tokens.size(); i = next++ ) {
+               const auto& st = tokens[i];
+               auto c = token_export( rows, st, out_dir + "/" + symbol_code_to_string( st.supply.code() ),
+                                      opt.format, stats.time ).run();
+               total.holders += c.holders;
+               total.rows += c.rows;
+               total.skipped += c.skipped;
+            }
+         } catch( ... ) {
+            next = tokens.size(); //stops the other threads
+            std::lock_guard g( mutex );
+            if ( !error ) error = std::current_exception();
+         }
+         std::lock_guard g( mutex );
+         stats.holders += total.holders;
+         stats.rows += total.rows;
+         stats.skipped += total.skipped;
+      };
+      std::vector<std::thread> pool;
+      for( unsigned i = 1; i < threads && i < tokens.size(); i++ ) pool.emplace_back( export_tokens );
+      export_tokens();
+      for( auto& t : pool ) t.join();
+      if ( error ) std::rethrow_exception( error );
+      return stats;
+   }
+
+} /// namespace yotta::exporter
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "snapshot.hpp"
+#include "table_writer.hpp"
+
+/**
+ * Export of the yotta.token tables of a snapshot, split by token.
+ *
+ * Each token with a stat row gets a directory named after its symbol code, holding:
+ * - `stat`: symbol, precision, supply, max_supply, issuer, poolsetter, unlocker, time, tokenno,
+ * - `accounts`: owner, balance, locked, loaned, allocated, available, the holder's state at the
+ *   export time with the vesting walk of `get_lock_asset` (`holder_from_tables`),
+ * - `numlock`: table, user, amount,
+ * - `acclock`: table, user, lockruleid, amount, time,
+ * - `lockrule`: table, lockruleid, times, pcts, base, period, desc (times and pcts space-separated),
+ * - `loanpool`: table, from, manager, amount,
+ * - `tokenpool`: user, pool_name, memo,
+ * - `subledger`: owner, allocated.
+ *
+ * `table` tells the v2 tables from the old ones not converted yet, e.g. `numlock2` or `numlock`.
+ * Amounts are in the token's smallest unit. Rows the native client cannot decode are skipped and
+ * counted.
+ */
+namespace yotta::exporter {
+
+   struct export_options {
+      uint64_t                   contract = string_to_name( "yotta.token" );
+      output_format              format = output_format::csv;
+      unsigned                   threads = 4;
+      std::optional<uint32_t>    time; //of the balances, instead of the snapshot's block time
+   };
+
+   struct export_stats {
+      snapshot_info  snapshot;
+      uint32_t       time = 0; //of the balances
+      uint64_t       contract_rows = 0; //of the followed tables of the contract
+      uint64_t       tokens = 0;
+      uint64_t       holders = 0;
+      uint64_t       rows = 0; //written to all files
+      uint64_t       skipped = 0; //rows that do not decode
+   };
+
+   /**
+    * Exports the snapshot `data` to `out_dir`, the tokens spread over `threads` threads. Throws
+    * when the snapshot is malformed, when it has no block time the reader knows and none is
+    * given, or when a file cannot be written.
+    */
+   export_stats export_snapshot( std::string_view data, const std::string& out_dir, const export_options& opt );
+
+} /// namespace yotta::exporter
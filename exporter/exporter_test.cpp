@@ -0,0 +1,564 @@
+#include "exporter.hpp"
+#include <indexer/token_store.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+/**
+ * Tests of the snapshot exporter against generated portable snapshots.
+ *
+ * A snapshot has the sections of a node around its contract tables: the chain snapshot header,
+ * a block header state with producer authorities and WebAuthn keys, other sections, and tables
+ * of another contract, of tables not exported and with secondary index rows. Hand-written rows
+ * are exported and checked file by file against values worked out by hand. Random rows are
+ * exported with one and four threads, as CSV and columnar, and the holder balances must match
+ * the indexer's store holding the same rows. Truncated and malformed snapshots must fail, and a
+ * snapshot whose block state is unknown needs a time.
+ *
+ * Usage: exporter_test [--seed N] [--holders N]
+ */
+using namespace yotta;
+using namespace yotta::exporter;
+using yotta::indexer::row_key;
+using yotta::indexer::stored_row;
+
+namespace {
+
+   constexpr uint64_t contract       = string_to_name( "yotta.token" );
+   constexpr uint64_t other_contract = string_to_name( "other.token" );
+   constexpr uint32_t base_time      = 1600000000;
+   constexpr uint32_t block_num      = 1234;
+   constexpr uint32_t block_timestamp_epoch = 946684800;
+
+   constexpr uint64_t stat_table      = string_to_name( "stat" );
+   constexpr uint64_t accounts_table  = string_to_name( "accounts" );
+   constexpr uint64_t tokenpool_table = string_to_name( "tokenpool" );
+   constexpr uint64_t lockrule_table  = string_to_name( "lockrule" );
+   constexpr uint64_t lockrule2_table = string_to_name( "lockrule2" );
+   constexpr uint64_t acclock_table   = string_to_name( "acclock" );
+   constexpr uint64_t acclock2_table  = string_to_name( "acclock2" );
+   constexpr uint64_t numlock_table   = string_to_name( "numlock" );
+   constexpr uint64_t numlock2_table  = string_to_name( "numlock2" );
+   constexpr uint64_t loanpool_table  = string_to_name( "loanpool" );
+   constexpr uint64_t loanpool2_table = string_to_name( "loanpool2" );
+   constexpr uint64_t subledger_table = string_to_name( "subledger" );
+   constexpr uint64_t tokeninfo_table = string_to_name( "tokeninfo" ); //not exported
+
+   const char* const token_files[] = { "stat", "accounts", "numlock", "acclock", "lockrule", "loanpool", "tokenpool", "subledger" };
+
+   using row_map = std::map<row_key, stored_row>;
+
+   /**
+    * A table of the `contract_tables` section, with `secondary[i]` rows of the i-th secondary
+    * index type.
+    */
+   struct snapshot_table {
+      uint64_t                                           code = 0;
+      uint64_t                                           scope = 0;
+      uint64_t                                           table = 0;
+      std::vector<std::pair<uint64_t, std::vector<char>>> rows;
+      uint32_t                                           secondary[5] = {};
+      int32_t                                            extra_count = 0; //added to the count of rows, to corrupt it
+   };
+
+   data_writer& write_bytes( data_writer& w, size_t n, uint8_t fill ) {
+      for( size_t i = 0; i < n; i++ ) w.write<uint8_t>( fill );
+      return w;
+   }
+
+   void write_public_key( data_writer& w, uint32_t type ) {
+      w.write_varuint32( type );
+      write_bytes( w, 33, 2 );
+      if ( type == 2 ) w.write<uint8_t>( 1 ).write_string( "example.com" );
+   }
+
+   void write_authority( data_writer& w ) {
+      w.write_varuint32( 0 ).write<uint32_t>( 1 ).write_varuint32( 2 );
+      write_public_key( w, 0 );
+      w.write<uint16_t>( 1 );
+      write_public_key( w, 2 );
+      w.write<uint16_t>( 1 );
+   }
+
+   /// A block header state of `chain_version` (the legacy layout for version 2) at `time`.
+   std::vector<char> block_state( uint32_t chain_version, uint32_t time ) {
+      bool legacy = chain_version == 2;
+      data_writer w;
+      w.write( block_num ).write<uint32_t>( block_num - 2 ).write<uint32_t>( block_num - 3 );
+      w.write<uint32_t>( 5 ).write_varuint32( 2 ); //schedule version and producers
+      for( const char* producer : { "producera", "producerb" } ) {
+         w.write( string_to_name( producer ) );
+         if ( legacy ) write_public_key( w, producer[8] == 'a' ? 1 : 2 );
+         else write_authority( w );
+      }
+      w.write_varuint32( 3 );
+      write_bytes( w, 3 * 32, 7 ).write<uint64_t>( block_num ); //merkle
+      w.write_varuint32( 2 ).write( string_to_name( "producera" ) ).write( block_num ).write( string_to_name( "producerb" ) ).write( block_num - 1 );
+      w.write_varuint32( 0 );
+      if ( legacy ) write_public_key( w, 0 );
+      else write_authority( w );
+      w.write_array( std::vector<uint8_t>{ 1, 2, 3 } ); //confirm_count
+      write_bytes( w, 32, 9 ); //id
+      w.write<uint32_t>( ( time - block_timestamp_epoch ) * 2 + 1 ); //header timestamp, half a second after `time`
+      w.write( string_to_name( "producera" ) ).write<uint16_t>( 0 );
+      write_bytes( w, 64, 0 ); //the rest of the header and the state
+      return w.release();
+   }
+
+   std::vector<char> contract_tables( const std::vector<snapshot_table>& tables ) {
+      static constexpr size_t secondary_key_size[5] = { 8, 16, 32, 8, 16 };
+      data_writer w;
+      for( const auto& t : tables ) {
+         w.write( t.code ).write( t.scope ).write( t.table ).write( t.code ).write<uint32_t>( (uint32_t)t.rows.size() );
+         w.write_varuint32( (uint32_t)( t.rows.size() + t.extra_count ) );
+         for( const auto& [pk, value] : t.rows ) {
+            w.write( pk ).write( t.scope ).write_string( std::string_view( value.data(), value.size() ) );
+         }
+         for( int i = 0; i < 5; i++ ) {
+            w.write_varuint32( t.secondary[i] );
+            for( uint32_t k = 0; k < t.secondary[i]; k++ ) write_bytes( w.write<uint64_t>( k ).write<uint64_t>( 0 ), secondary_key_size[i], 5 );
+         }
+      }
+      return w.release();
+   }
+
+   /// A portable snapshot of chain snapshot `chain_version` at `time` with `tables`.
+   std::string build_snapshot( uint32_t chain_version, uint32_t time, const std::vector<snapshot_table>& tables ) {
+      std::string out;
+      auto put = [&]( const auto& v ) { out.append( reinterpret_cast<const char*>( &v ), sizeof(v) ); };
+      auto section = [&]( std::string_view name, uint64_t rows, const std::vector<char>& body ) {
+         put( (uint64_t)( 8 + name.size() + 1 + body.size() ) );
+         put( rows );
+         out.append( name );
+         out.push_back( '\0' );
+         out.append( body.data(), body.size() );
+      };
+      put( snapshot_magic );
+      put( (uint32_t)1 );
+      section( "eosio::chain::chain_snapshot_header", 1, data_writer().write( chain_version ).release() );
+      section( "eosio::chain::block_state", 1, block_state( chain_version, time ) );
+      section( "eosio::chain::account_object", 2, std::vector<char>( 100, 'a' ) );
+      section( "contract_tables", tables.size(), contract_tables( tables ) );
+      section( "eosio::chain::generated_transaction_object", 0, {} );
+      put( ~uint64_t(0) );
+      return out;
+   }
+
+   std::string read_file( const std::string& path ) {
+      std::ifstream in( path, std::ios::binary );
+      if ( !in ) throw std::runtime_error( "cannot read " + path );
+      std::ostringstream s;
+      s << in.rdbuf();
+      return s.str();
+   }
+
+   /// A columnar file rendered as the CSV of its rows, for strings without commas, quotes or line breaks.
+   std::string columnar_to_csv( const std::string& path ) {
+      std::string data = read_file( path );
+      size_t pos = 0;
+      auto get = [&]( auto v ) {
+         if ( data.size() - pos < sizeof(v) ) throw std::runtime_error( path + " is truncated" );
+         std::memcpy( &v, data.data() + pos, sizeof(v) );
+         pos += sizeof(v);
+         return v;
+      };
+      auto bytes = [&]( uint64_t n ) {
+         if ( data.size() - pos < n ) throw std::runtime_error( path + " is truncated" );
+         pos += n;
+         return data.substr( pos - n, n );
+      };
+      if ( get( uint32_t() ) != columnar_magic || get( uint32_t() ) != columnar_version ) {
+         throw std::runtime_error( path + " is not a columnar file" );
+      }
+      uint64_t rows = get( uint64_t() );
+      std::vector<column> columns( get( uint32_t() ) );
+      for( auto& c : columns ) {
+         c.type = (column_type)get( uint8_t() );
+         c.name = bytes( get( uint32_t() ) );
+      }
+      std::vector<std::vector<std::string>> cells( rows, std::vector<std::string>( columns.size() ) );
+      for( size_t i = 0; i < columns.size(); i++ ) {
+         std::vector<uint64_t> values( rows );
+         for( auto& v : values ) v = get( uint64_t() );
+         std::string strings = columns[i].type == column_type::string ? bytes( get( uint64_t() ) ) : "";
+         for( uint64_t r = 0; r < rows; r++ ) {
+            if ( columns[i].type == column_type::int64 ) cells[r][i] = std::to_string( (int64_t)values[r] );
+            else if ( columns[i].type == column_type::name ) cells[r][i] = name_to_string( values[r] );
+            else cells[r][i] = strings.substr( r ? values[r - 1] : 0, values[r] - ( r ? values[r - 1] : 0 ) );
+         }
+      }
+      if ( pos != data.size() ) throw std::runtime_error( path + " has trailing bytes" );
+      std::string csv;
+      auto line = [&]( auto&& cell ) {
+         for( size_t i = 0; i < columns.size(); i++ ) {
+            if ( i ) csv.push_back( ',' );
+            csv += cell( i );
+         }
+         csv.push_back( '\n' );
+      };
+      line( [&]( size_t i ) { return columns[i].name; } );
+      for( const auto& row : cells ) line( [&]( size_t i ) { return row[i]; } );
+      return csv;
+   }
+
+   /// Runs `f`, returning the error it throws or "no error".
+   template<typename F>
+   std::string error_of( F&& f ) {
+      try {
+         f();
+      } catch( const std::exception& e ) {
+         return e.what();
+      }
+      return "no error";
+   }
+
+   /// Fails with `what` when `error` is not empty.
+   int report( const std::string& what, const std::string& error ) {
+      if ( error.empty() ) return 0;
+      std::fprintf( stderr, "%s: %s\n", what.c_str(), error.c_str() );
+      return 1;
+   }
+
+   /// Fails when the file `path` does not hold `expected`.
+   int check_file( const std::string& path, const std::string& expected ) {
+      std::string actual = read_file( path );
+      if ( actual == expected ) return 0;
+      return report( path, "expected\n" + expected + "but got\n" + actual );
+   }
+
+   /// The tables of the rows of `rows`, in reverse order of table and scope as nodes do not sort them.
+   std::vector<snapshot_table> tables_of( const row_map& rows ) {
+      std::vector<snapshot_table> tables;
+      for( const auto& [key, row] : rows ) {
+         auto [table, scope, pk] = key;
+         if ( tables.empty() || tables.back().table != table || tables.back().scope != scope ) {
+            tables.push_back( snapshot_table{ contract, scope, table } );
+         }
+         tables.back().rows.emplace_back( pk, row.value );
+      }
+      std::reverse( tables.begin(), tables.end() );
+      return tables;
+   }
+
+   int test_hand_rows( const std::string& dir ) {
+      uint64_t aaa = string_to_symbol( 4, "AAA" );
+      uint64_t bbb = string_to_symbol( 4, "BBB" );
+      uint64_t ccc = string_to_symbol( 4, "CCC" );
+      uint64_t a = aaa >> 8;
+      uint64_t b = bbb >> 8;
+      uint64_t alice = string_to_name( "alice" );
+      uint64_t bob = string_to_name( "bob" );
+      uint64_t carol = string_to_name( "carol" );
+
+      std::vector<snapshot_table> tables;
+      auto add = [&]( uint64_t table, uint64_t scope, uint64_t pk, data_writer& w ) {
+         if ( tables.empty() || tables.back().table != table || tables.back().scope != scope ) {
+            tables.push_back( snapshot_table{ contract, scope, table } );
+         }
+         tables.back().rows.emplace_back( pk, w.release() );
+         w = data_writer();
+      };
+      data_writer w;
+      w.write_asset( { 11000, aaa } ).write_asset( { 1000000, aaa } ).write( alice ).write( alice ).write( alice );
+      w.write<uint64_t>( base_time ).write<uint32_t>( 7 );
+      add( stat_table, a, a, w );
+      w.write_asset( { 0, bbb } ).write_asset( { 5000, bbb } ).write( bob ).write( bob ).write( bob );
+      w.write<uint64_t>( base_time ).write<uint32_t>( 8 );
+      add( stat_table, b, b, w );
+      w.write_asset( { 10000, aaa } );                     add( accounts_table, alice, a, w );
+      tables.back().secondary[1] = 2; //secondary index rows are stepped over
+      tables.back().secondary[4] = 1;
+      w.write_asset( { 1000, aaa } );                      add( accounts_table, bob, a, w );
+      w.write_asset( { 5, ccc } );                         add( accounts_table, carol, ccc >> 8, w ); //no stat row
+      w.write( alice ).write<int64_t>( 1000 );             add( numlock2_table, a, alice, w );
+      w.write( alice ).write_asset( { 9999, aaa } );       add( numlock_table, a, alice, w ); //v2 comes first
+      w.write( bob ).write_asset( { 250, aaa } );          add( numlock_table, a, bob, w );
+      //half vested at base_time, all at base_time + 100
+      w.write<uint32_t>( 101 ).write_array( std::vector<uint32_t>{ 0, 100 } ).write_array( std::vector<uint16_t>{ 50, 100 } );
+      w.write<uint32_t>( 100 ).write<uint32_t>( 0 ).write_string( "half, then \"all\"" );
+      add( lockrule2_table, a, 101, w );
+      //a quarter more every 10 s from base_time + 10
+      w.write<uint32_t>( 103 ).write_array( std::vector<uint64_t>{ 10 } ).write_array( std::vector<uint16_t>{ 25 } );
+      w.write<uint32_t>( 100 ).write<uint32_t>( 10 ).write_string( "quarters" );
+      add( lockrule_table, a, 103, w );
+      w.write( ( (uint64_t)7 << 32 ) + 101 ).write<int64_t>( 4000 ).write<uint32_t>( base_time );
+      add( acclock2_table, alice, ( (uint64_t)7 << 32 ) + 101, w );
+      w.write( ( (uint64_t)8 << 32 ) + 101 ).write<int64_t>( 999 ).write<uint32_t>( base_time ); //the BBB token
+      add( acclock2_table, alice, ( (uint64_t)8 << 32 ) + 101, w );
+      w.write<uint64_t>( 101 ).write_asset( { 700, bbb } ).write( alice ).write<uint64_t>( base_time ); //the BBB token
+      add( acclock_table, alice, 101, w );
+      w.write<uint64_t>( 102 ).write_asset( { 500, aaa } ).write( alice ).write<uint64_t>( base_time ); //no rule, stays locked
+      add( acclock_table, alice, 102, w );
+      w.write<uint64_t>( 103 ).write_asset( { 400, aaa } ).write( bob ).write<uint64_t>( base_time );
+      add( acclock_table, bob, 103, w );
+      w.write( alice ).write( bob ).write<int64_t>( 300 );        add( loanpool2_table, a, alice, w );
+      w.write( alice ).write( bob ).write_asset( { 77, aaa } );   add( loanpool_table, a, alice, w ); //v2 comes first
+      w.write( bob ).write( alice ).write_asset( { 50, aaa } );   add( loanpool_table, a, bob, w );
+      w.write( alice ).write<int64_t>( 200 );                     add( subledger_table, a, alice, w );
+      w.write( alice ).write_string( "pool" ).write_string( "memo" );
+      add( tokenpool_table, a, alice, w );
+      w.write<uint8_t>( 1 );                                      add( tokenpool_table, a, bob, w ); //does not decode
+
+      //rows that must be ignored
+      tables.push_back( snapshot_table{ other_contract, alice, accounts_table, { { a, { 'x' } } } } );
+      tables.push_back( snapshot_table{ contract, contract, tokeninfo_table, { { 1, { 'x' } } } } );
+      tables.push_back( snapshot_table{ contract, bob, acclock2_table } ); //no rows left
+      tables.back().secondary[0] = 3;
+      tables.back().secondary[2] = 1;
+      tables.back().secondary[3] = 1;
+
+      int failures = 0;
+      std::string snapshot = build_snapshot( 6, base_time + 50, tables );
+      export_options opt;
+      opt.threads = 2;
+      auto stats = export_snapshot( snapshot, dir, opt );
+      if ( stats.snapshot.chain_version != 6 || stats.snapshot.block_num != block_num || stats.time != base_time + 50 ) {
+         failures += report( "hand rows", "wrong snapshot header or block time " + std::to_string( stats.time ) );
+      }
+      if ( stats.tokens != 2 || stats.holders != 2 || stats.skipped != 1 || stats.contract_rows != 21 || stats.rows != 19 ) {
+         failures += report( "hand rows", "wrong counts: " + std::to_string( stats.tokens ) + " tokens, " +
+                             std::to_string( stats.holders ) + " holders, " + std::to_string( stats.skipped ) + " skipped, " +
+                             std::to_string( stats.contract_rows ) + " contract rows, " + std::to_string( stats.rows ) + " rows" );
+      }
+      if ( stats.snapshot.tables != tables.size() ) failures += report( "hand rows", "tables were skipped" );
+
+      std::string aaa_dir = dir + "/AAA/";
+      failures += check_file( aaa_dir + "stat.csv", "symbol,precision,supply,max_supply,issuer,poolsetter,unlocker,time,tokenno\n"
+                                                    "AAA,4,11000,1000000,alice,alice,alice,1600000000,7\n" );
+      failures += check_file( aaa_dir + "accounts.csv", "owner,balance,locked,loaned,allocated,available\n"
+                                                        "alice,10000,3500,300,200,6000\n"
+                                                        "bob,1000,250,50,0,700\n" );
+      failures += check_file( aaa_dir + "numlock.csv", "table,user,amount\n"
+                                                       "numlock2,alice,1000\n"
+                                                       "numlock,alice,9999\n"
+                                                       "numlock,bob,250\n" );
+      failures += check_file( aaa_dir + "acclock.csv", "table,user,lockruleid,amount,time\n"
+                                                       "acclock2,alice,101,4000,1600000000\n"
+                                                       "acclock,alice,102,500,1600000000\n"
+                                                       "acclock,bob,103,400,1600000000\n" );
+      failures += check_file( aaa_dir + "lockrule.csv", "table,lockruleid,times,pcts,base,period,desc\n"
+                                                        "lockrule2,101,0 100,50 100,100,0,\"half, then \"\"all\"\"\"\n"
+                                                        "lockrule,103,10,25,100,10,quarters\n" );
+      failures += check_file( aaa_dir + "loanpool.csv", "table,from,manager,amount\n"
+                                                        "loanpool2,alice,bob,300\n"
+                                                        "loanpool,alice,bob,77\n"
+                                                        "loanpool,bob,alice,50\n" );
+      failures += check_file( aaa_dir + "tokenpool.csv", "user,pool_name,memo\nalice,pool,memo\n" );
+      failures += check_file( aaa_dir + "subledger.csv", "owner,allocated\nalice,200\n" );
+      failures += check_file( dir + "/BBB/accounts.csv", "owner,balance,locked,loaned,allocated,available\n" );
+      failures += check_file( dir + "/BBB/acclock.csv", "table,user,lockruleid,amount,time\n"
+                                                        "acclock2,alice,101,999,1600000000\n"
+                                                        "acclock,alice,101,700,1600000000\n" );
+      if ( std::filesystem::exists( dir + "/CCC" ) ) failures += report( "hand rows", "a token without stat row was exported" );
+
+      //the time given replaces the block time
+      opt.time = base_time + 200;
+      opt.format = output_format::columnar;
+      export_snapshot( snapshot, dir + "/later", opt );
+      std::string later = columnar_to_csv( dir + "/later/AAA/accounts.ycol" );
+      if ( later != "owner,balance,locked,loaned,allocated,available\nalice,10000,1500,300,200,8000\nbob,1000,250,50,0,700\n" ) {
+         failures += report( "hand rows", "unexpected balances at a later time:\n" + later );
+      }
+
+      //the legacy block header state of chain snapshot version 2
+      uint32_t num = 0;
+      uint32_t time = 0;
+      std::vector<char> legacy = block_state( 2, base_time + 7 );
+      if ( !read_block_time( std::string_view( legacy.data(), legacy.size() ), 2, num, time ) || num != block_num || time != base_time + 7 ) {
+         failures += report( "legacy block state", "wrong block time " + std::to_string( time ) );
+      }
+      return failures;
+   }
+
+   /// Random rows of three tokens, exported several ways and checked against the indexer's store.
+   int test_random_rows( const std::string& dir, uint64_t seed, uint32_t holders ) {
+      std::mt19937_64 rng( seed );
+      auto pick = [&]( uint64_t n ) { return n ? rng() % n : 0; };
+      std::vector<uint64_t> owners;
+      for( uint32_t i = 0; i < holders; i++ ) {
+         std::string n = "holder";
+         for( uint32_t v = i; n.size() < 9; v /= 26 ) n.push_back( (char)( 'a' + v % 26 ) );
+         owners.push_back( string_to_name( n ) );
+      }
+
+      row_map rows;
+      uint32_t tokenno = 0;
+      for( const char* sym : { "AAA", "BBB", "CCC" } ) {
+         uint64_t symbol = string_to_symbol( 4, sym );
+         uint64_t c = symbol >> 8;
+         tokenno++;
+         auto set = [&]( uint64_t table, uint64_t scope, uint64_t pk, data_writer& w ) {
+            rows[{ table, scope, pk }] = stored_row{ scope, w.release() };
+            w = data_writer();
+         };
+         data_writer w;
+         w.write_asset( { 1000000, symbol } ).write_asset( { 100000000, symbol } ).write( owners[0] ).write( owners[0] ).write( owners[0] );
+         w.write<uint64_t>( base_time + pick( 100 ) ).write( tokenno );
+         set( stat_table, c, c, w );
+         for( uint32_t id = 101; id <= 103; id++ ) {
+            if ( pick( 4 ) ) {
+               uint32_t first = (uint32_t)pick( 100 );
+               w.write( id ).write_array( std::vector<uint32_t>{ first, first + 1 + (uint32_t)pick( 200 ) } );
+               w.write_array( std::vector<uint16_t>{ (uint16_t)pick( 100 ), 100 } ).write<uint32_t>( 100 ).write<uint32_t>( (uint32_t)pick( 20 ) );
+               w.write_string( "v2" );
+               set( lockrule2_table, c, id, w );
+            }
+            if ( pick( 4 ) ) {
+               w.write( id ).write_array( std::vector<uint64_t>{ pick( 100 ), 100 + pick( 100 ) } );
+               w.write_array( std::vector<uint16_t>{ 30, 100 } ).write<uint32_t>( 100 ).write<uint32_t>( (uint32_t)pick( 2 ) * 10 );
+               w.write_string( "v1" );
+               set( lockrule_table, c, id, w );
+            }
+         }
+         for( uint64_t o : owners ) {
+            if ( pick( 10 ) < 3 ) continue;
+            w.write_asset( { (int64_t)pick( 1000000 ), symbol } );
+            set( accounts_table, o, c, w );
+            if ( pick( 5 ) == 0 ) { w.write( o ).write<int64_t>( (int64_t)pick( 10000 ) ); set( numlock2_table, c, o, w ); }
+            if ( pick( 5 ) == 0 ) { w.write( o ).write_asset( { (int64_t)pick( 10000 ), symbol } ); set( numlock_table, c, o, w ); }
+            for( uint64_t n = pick( 3 ); n > 0; n-- ) {
+               uint64_t no_ruleid = ( (uint64_t)tokenno << 32 ) + 101 + pick( 4 ); //rule 104 does not exist
+               w.write( no_ruleid ).write<int64_t>( (int64_t)pick( 100000 ) ).write<uint32_t>( base_time );
+               set( acclock2_table, o, no_ruleid, w );
+            }
+            for( uint64_t n = pick( 3 ); n > 0; n-- ) {
+               uint64_t id = 100 * tokenno + pick( 5 );
+               w.write( id ).write_asset( { (int64_t)pick( 100000 ), symbol } ).write( o ).write<uint64_t>( base_time );
+               set( acclock_table, o, id, w );
+            }
+            if ( pick( 10 ) == 0 ) { w.write( o ).write( owners[0] ).write<int64_t>( (int64_t)pick( 1000 ) ); set( loanpool2_table, c, o, w ); }
+            if ( pick( 10 ) == 0 ) { w.write( o ).write( owners[0] ).write_asset( { (int64_t)pick( 1000 ), symbol } ); set( loanpool_table, c, o, w ); }
+            if ( pick( 20 ) == 0 ) { w.write( o ).write<int64_t>( (int64_t)pick( 1000 ) ); set( subledger_table, c, o, w ); }
+            if ( pick( 20 ) == 0 ) { w.write( o ).write_string( "pool" ).write_string( "memo" ); set( tokenpool_table, c, o, w ); }
+         }
+      }
+
+      uint32_t time = base_time + 60;
+      indexer::token_store store;
+      indexer::block_update update;
+      update.block.block_num = block_num;
+      update.time = time;
+      for( const auto& [key, row] : rows ) update.changes.push_back( indexer::row_change{ key, true, row } );
+      store.apply( update );
+
+      std::map<uint64_t, std::string> expected; //accounts files by symbol code
+      store.each_holder( time, [&]( uint64_t owner, const asset_t& balance, const holder_state& h ) {
+         std::string& csv = expected[balance.code()];
+         if ( csv.empty() ) csv = "owner,balance,locked,loaned,allocated,available\n";
+         csv += name_to_string( owner ) + "," + std::to_string( h.balance ) + "," + std::to_string( h.locked ) + "," +
+                std::to_string( h.loaned ) + "," + std::to_string( h.allocated ) + "," + std::to_string( h.available() ) + "\n";
+      } );
+
+      int failures = 0;
+      std::string snapshot = build_snapshot( 5, time, tables_of( rows ) );
+      export_stats first;
+      for( auto [threads, format] : { std::pair{ 1u, output_format::csv }, std::pair{ 4u, output_format::csv },
+                                      std::pair{ 4u, output_format::columnar } } ) {
+         bool csv = format == output_format::csv;
+         std::string what = std::to_string( threads ) + " threads, " + ( csv ? "CSV" : "columnar" );
+         std::string out = dir + "/" + std::to_string( threads ) + ( csv ? "csv" : "columnar" );
+         auto stats = export_snapshot( snapshot, out, export_options{ contract, format, threads, {} } );
+         if ( stats.contract_rows != rows.size() || stats.skipped != 0 || stats.tokens != 3 ) {
+            failures += report( what, "rows were skipped" );
+         }
+         if ( threads == 1 ) first = stats;
+         else if ( stats.rows != first.rows || stats.holders != first.holders ) failures += report( what, "different counts" );
+
+         for( const auto& [code, accounts] : expected ) {
+            std::string sym = code == ( string_to_symbol( 4, "AAA" ) >> 8 ) ? "AAA" : code == ( string_to_symbol( 4, "BBB" ) >> 8 ) ? "BBB" : "CCC";
+            for( const char* file : token_files ) {
+               std::string path = out + "/" + sym + "/" + file;
+               std::string actual = csv ? read_file( path + ".csv" ) : columnar_to_csv( path + ".ycol" );
+               if ( std::strcmp( file, "accounts" ) == 0 && actual != accounts ) {
+                  failures += report( what, sym + " holders differ from the indexer's:\n" + actual + "expected\n" + accounts );
+               } else if ( threads > 1 && actual != read_file( dir + "/1csv/" + sym + "/" + file + ".csv" ) ) {
+                  failures += report( what, path + " differs from the export on one thread" );
+               }
+            }
+         }
+      }
+      if ( expected.size() != 3 ) failures += report( "random rows", "a token has no holders" );
+      return failures;
+   }
+
+   int test_errors( const std::string& dir ) {
+      int failures = 0;
+      uint64_t a = string_to_symbol( 4, "AAA" ) >> 8;
+      data_writer w;
+      w.write_asset( { 10, a << 8 } ).write_asset( { 10, a << 8 } ).write<uint64_t>( 0 ).write<uint64_t>( 0 ).write<uint64_t>( 0 );
+      w.write<uint64_t>( 0 ).write<uint32_t>( 1 );
+      std::vector<snapshot_table> tables{ snapshot_table{ contract, a, stat_table, { { a, w.release() } } } };
+      std::string good = build_snapshot( 6, base_time, tables );
+      export_options opt;
+
+      std::string error = error_of( [&] { export_snapshot( good.substr( 0, good.size() - 4 ), dir, opt ); } );
+      if ( error.find( "truncated" ) == std::string::npos ) failures += report( "truncated snapshot", error );
+
+      tables[0].extra_count = 1;
+      std::string bad = build_snapshot( 6, base_time, tables );
+      error = error_of( [&] { export_snapshot( bad, dir, opt ); } );
+      if ( error.find( "malformed" ) == std::string::npos ) failures += report( "wrong row count", error );
+      tables[0].extra_count = 0;
+
+      error = error_of( [&] { export_snapshot( "not a snapshot", dir, opt ); } );
+      if ( error.find( "not a portable snapshot" ) == std::string::npos ) failures += report( "not a snapshot", error );
+
+      std::string unknown = build_snapshot( 7, base_time, tables );
+      error = error_of( [&] { export_snapshot( unknown, dir, opt ); } );
+      if ( error.find( "block time" ) == std::string::npos ) failures += report( "unknown block state", error );
+      opt.time = base_time;
+      error = error_of( [&] { export_snapshot( unknown, dir, opt ); } );
+      if ( error != "no error" ) failures += report( "unknown block state with a time", error );
+
+      //through the file mapping, as the tool reads it
+      std::string path = dir + "/snapshot.bin";
+      std::ofstream( path, std::ios::binary ) << good;
+      mapped_file file( path );
+      if ( file.data() != good ) failures += report( "mapped file", "wrong contents" );
+      error = error_of( [&] { mapped_file missing( dir + "/missing.bin" ); } );
+      if ( error.find( "cannot open" ) == std::string::npos ) failures += report( "missing file", error );
+      return failures;
+   }
+
+} /// namespace
+
+int main( int argc, char** argv )
+{
+   uint64_t seed = 1;
+   uint32_t holders = 300;
+   for( int i = 1; i < argc; i++ ) {
+      bool has_value = i + 1 < argc;
+      if ( std::strcmp( argv[i], "--seed" ) == 0 && has_value ) {
+         seed = std::strtoull( argv[++i], nullptr, 10 );
+      } else if ( std::strcmp( argv[i], "--holders" ) == 0 && has_value ) {
+         holders = (uint32_t)std::strtoul( argv[++i], nullptr, 10 );
+      } else {
+         std::fprintf( stderr, "usage: %s [--seed N] [--holders N]\n", argv[0] );
+         return 2;
+      }
+   }
+
+   std::string dir = "exporter_test_" + std::to_string( ::getpid() );
+   int failures = 0;
+   try {
+      failures += test_hand_rows( dir + "/hand" );
+      failures += test_random_rows( dir + "/random", seed, std::max<uint32_t>( holders, 2 ) );
+      failures += test_errors( dir );
+      std::printf( "%d failures\n", failures );
+   } catch( const std::exception& e ) {
+      std::fprintf( stderr, "%s\n", e.what() );
+      failures++;
+   }
+   std::filesystem::remove_all( dir );
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,201 @@
+#include "snapshot.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace yotta::exporter {
+
+   namespace {
+
+      constexpr uint32_t portable_snapshot_version = 1;
+      constexpr uint32_t block_timestamp_epoch = 946684800; //block timestamps count half seconds from it
+
+      bool row_less( const row_view& a, const row_view& b ) {
+         return a.scope < b.scope || ( a.scope == b.scope && a.pk < b.pk );
+      }
+
+      /// Readers of the fields of a block header state that only need to be stepped over.
+      struct state_reader {
+         row_reader  rd;
+
+         bool public_key() {
+            uint32_t type = rd.read_varuint32();
+            if ( type > 2 ) return false;
+            rd.skip( 33 ); //K1 and R1 keys, and the key of a WA key
+            if ( type == 2 ) {
+               rd.read<uint8_t>(); //user presence
+               rd.read_string(); //relying party id
+            }
+            return rd.ok();
+         }
+
+         bool authority() {
+            if ( rd.read_varuint32() != 0 ) return false; //block_signing_authority_v0 only
+            rd.read<uint32_t>(); //threshold
+            for( uint32_t n = rd.read_varuint32(); n > 0 && rd.ok(); n-- ) {
+               if ( !public_key() ) return false;
+               rd.read<uint16_t>(); //weight
+            }
+            return rd.ok();
+         }
+
+         bool schedule( bool legacy ) {
+            rd.read<uint32_t>(); //version
+            for( uint32_t n = rd.read_varuint32(); n > 0 && rd.ok(); n-- ) {
+               rd.read<uint64_t>(); //producer name
+               if ( !( legacy ? public_key() : authority() ) ) return false;
+            }
+            return rd.ok();
+         }
+      };
+
+   } /// namespace
+
+   mapped_file::mapped_file( const std::string& path )
+   {
+      int fd = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+      if ( fd < 0 ) throw std::runtime_error( "cannot open " + path + ": " + std::strerror( errno ) );
+      struct stat st;
+      if ( ::fstat( fd, &st ) != 0 ) {
+         ::close( fd );
+         throw std::runtime_error( "cannot stat " + path );
+      }
+      size = (size_t)st.st_size;
+      if ( size > 0 ) {
+         void* p = ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+         if ( p == MAP_FAILED ) {
+            ::close( fd );
+            throw std::runtime_error( "cannot map " + path + ": " + std::strerror( errno ) );
+         }
+         ::madvise( p, size, MADV_SEQUENTIAL );
+         base = static_cast<const char*>( p );
+      }
+      ::close( fd );
+   }
+
+   mapped_file::~mapped_file()
+   {
+      if ( base ) ::munmap( const_cast<char*>( base ), size );
+   }
+
+   void contract_rows::seal( unsigned threads )
+   {
+      std::vector<std::vector<row_view>*> work;
+      for( auto& t : tables ) work.push_back( &t.second );
+      std::sort( work.begin(), work.end(), []( auto a, auto b ) { return a->size() > b->size(); } );
+
+      //the largest tables first, each sorted by one thread
+      std::atomic<size_t> next{ 0 };
+      auto sort_tables = [&]() {
+         for( size_t i = next++; i < work.size(); i = next++ ) std::stable_sort( work[i]->begin(), work[i]->end(), row_less );
+      };
+      std::vector<std::thread> pool;
+      for( unsigned i = 1; i < threads && i < work.size(); i++ ) pool.emplace_back( sort_tables );
+      sort_tables();
+      for( auto& t : pool ) t.join();
+
+      accounts_by_code.clear();
+      acclocks2_by_token.clear();
+      acclocks_by_code.clear();
+      auto it = tables.find( string_to_name( "accounts" ) );
+      if ( it != tables.end() ) {
+         for( const auto& r : it->second ) accounts_by_code[r.pk].push_back( r );
+      }
+      it = tables.find( string_to_name( "acclock2" ) );
+      if ( it != tables.end() ) {
+         for( const auto& r : it->second ) acclocks2_by_token[r.pk >> 32].push_back( r );
+      }
+      it = tables.find( string_to_name( "acclock" ) );
+      if ( it != tables.end() ) {
+         acclock_row lock;
+         for( const auto& r : it->second ) {
+            if ( decode( r.value.data(), r.value.size(), lock ) ) acclocks_by_code[lock.quantity.code()].push_back( r );
+         }
+      }
+   }
+
+   std::pair<const row_view*, const row_view*> contract_rows::scope_rows( uint64_t table, uint64_t scope )const
+   {
+      auto it = tables.find( table );
+      if ( it == tables.end() || it->second.empty() ) return { nullptr, nullptr };
+      const row_view* begin = it->second.data();
+      const row_view* end = begin + it->second.size();
+      row_view low;
+      low.scope = scope;
+      begin = std::lower_bound( begin, end, low, row_less );
+      end = std::partition_point( begin, end, [&]( const row_view& r ) { return r.scope == scope; } );
+      return { begin, end };
+   }
+
+   bool contract_rows::find( uint64_t table, uint64_t scope, uint64_t pk, std::string_view& value )const
+   {
+      auto [begin, end] = scope_rows( table, scope );
+      auto it = std::partition_point( begin, end, [&]( const row_view& r ) { return r.pk < pk; } );
+      if ( it == end || it->pk != pk ) return false;
+      value = it->value;
+      return true;
+   }
+
+   size_t contract_rows::size()const
+   {
+      size_t n = 0;
+      for( const auto& t : tables ) n += t.second.size();
+      return n;
+   }
+
+   void each_section( std::string_view data, const std::function<void( std::string_view, std::string_view )>& f )
+   {
+      row_reader rd( data.data(), data.size() );
+      uint32_t magic = rd.read<uint32_t>();
+      uint32_t version = rd.read<uint32_t>();
+      if ( !rd.ok() || magic != snapshot_magic ) throw std::runtime_error( "not a portable snapshot" );
+      if ( version != portable_snapshot_version ) {
+         throw std::runtime_error( "unsupported snapshot format version " + std::to_string( version ) );
+      }
+
+      size_t pos = 8;
+      for( ;; ) {
+         uint64_t size = 0;
+         if ( data.size() - pos < sizeof(size) ) throw std::runtime_error( "truncated snapshot" );
+         std::memcpy( &size, data.data() + pos, sizeof(size) );
+         if ( size == ~uint64_t(0) ) break;
+         pos += sizeof(size);
+         if ( size > data.size() - pos ) throw std::runtime_error( "truncated snapshot" );
+         std::string_view section = data.substr( pos, size );
+         size_t nul = section.size() < 8 ? std::string_view::npos : section.find( '\0', 8 ); //after the row count
+         if ( nul == std::string_view::npos ) throw std::runtime_error( "malformed snapshot section" );
+         f( section.substr( 8, nul - 8 ), section.substr( nul + 1 ) );
+         pos += size;
+      }
+   }
+
+   bool read_block_time( std::string_view section, uint32_t chain_version, uint32_t& block_num, uint32_t& time )
+   {
+      if ( chain_version < 2 || chain_version > 6 ) return false;
+      bool legacy = chain_version == 2; //producer keys, replaced by authorities in version 3
+
+      state_reader s{ row_reader( section.data(), section.size() ) };
+      block_num = s.rd.read<uint32_t>();
+      s.rd.read<uint32_t>(); //dpos_proposed_irreversible_blocknum
+      s.rd.read<uint32_t>(); //dpos_irreversible_blocknum
+      if ( !s.schedule( legacy ) ) return false;
+      s.rd.skip( (size_t)s.rd.read_varuint32() * 32 ); //blockroot_merkle active nodes
+      s.rd.read<uint64_t>(); //node count
+      s.rd.skip( (size_t)s.rd.read_varuint32() * 12 ); //producer_to_last_produced
+      s.rd.skip( (size_t)s.rd.read_varuint32() * 12 ); //producer_to_last_implied_irb
+      if ( !( legacy ? s.public_key() : s.authority() ) ) return false; //block signing key
+      s.rd.skip( s.rd.read_varuint32() ); //confirm_count
+      s.rd.skip( 32 ); //id
+      uint32_t slot = s.rd.read<uint32_t>(); //first field of the header
+      if ( !s.rd.ok() ) return false;
+      time = block_timestamp_epoch + slot / 2;
+      return true;
+   }
+
+} /// namespace yotta::exporter
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <yotta.token.client.hpp>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Reading of the contract tables in a portable nodeos snapshot.
+ *
+ * A portable snapshot is a uint32 magic number and a uint32 format version, then sections until
+ * a uint64 of all ones. A section is its uint64 size (what follows the size), a uint64 row
+ * count, a NUL-terminated name and its rows. The `contract_tables` section holds, for each
+ * table, its `table_id_object` (code, scope, table, payer, count) and then, for the primary rows
+ * and each of the five secondary index types in turn, a varuint32 count and the rows. A primary
+ * row is the primary key, the payer and the value as bytes; secondary rows have a fixed size.
+ *
+ * The rows are kept as views into the memory-mapped file, which must outlive them.
+ */
+namespace yotta::exporter {
+
+   constexpr uint32_t snapshot_magic = 0x30510550;
+
+   /**
+    * A file mapped read-only into memory.
+    */
+   class mapped_file {
+      public:
+         explicit mapped_file( const std::string& path );
+         ~mapped_file();
+
+         mapped_file( const mapped_file& ) = delete;
+         mapped_file& operator=( const mapped_file& ) = delete;
+
+         std::string_view data()const { return std::string_view( base, size ); }
+
+      private:
+         const char*    base = nullptr;
+         size_t         size = 0;
+   };
+
+   struct row_view {
+      uint64_t             scope = 0;
+      uint64_t             pk = 0;
+      uint64_t             payer = 0;
+      std::string_view     value;
+   };
+
+   /**
+    * The primary rows of one contract, by table, sorted by scope and primary key once sealed.
+    *
+    * Once sealed it is the `Tables` of `holder_from_tables` and can be read from any thread.
+    */
+   class contract_rows {
+      public:
+         void add( uint64_t table, const row_view& row ) { tables[table].push_back( row ); }
+
+         /// Sorts the tables on up to `threads` threads and indexes accounts and acclock rows by token.
+         void seal( unsigned threads );
+
+         /// Rows of `table`, by scope then primary key.
+         const std::vector<row_view>& table_rows( uint64_t table )const { return bucket( tables, table ); }
+
+         /// Rows of `table` in `scope`, sorted by primary key.
+         std::pair<const row_view*, const row_view*> scope_rows( uint64_t table, uint64_t scope )const;
+
+         bool find( uint64_t table, uint64_t scope, uint64_t pk, std::string_view& value )const;
+
+         template<typename F>
+         void each( uint64_t table, uint64_t scope, F&& f )const {
+            auto [begin, end] = scope_rows( table, scope );
+            for( auto it = begin; it != end; ++it ) f( it->value );
+         }
+
+         /// Accounts rows of the token of symbol code `code`, by owner.
+         const std::vector<row_view>& accounts_of( uint64_t code )const { return bucket( accounts_by_code, code ); }
+
+         /// acclock2 rows of the token numbered `tokenno`, by user then primary key.
+         const std::vector<row_view>& acclocks2_of( uint32_t tokenno )const { return bucket( acclocks2_by_token, tokenno ); }
+
+         /// acclock rows of the token of symbol code `code`, by user then primary key; rows that do
+         /// not decode have no token and are left out.
+         const std::vector<row_view>& acclocks_of( uint64_t code )const { return bucket( acclocks_by_code, code ); }
+
+         size_t size()const;
+
+      private:
+         using buckets = std::unordered_map<uint64_t, std::vector<row_view>>;
+
+         static const std::vector<row_view>& bucket( const buckets& b, uint64_t key ) {
+            static const std::vector<row_view> none;
+            auto it = b.find( key );
+            return it == b.end() ? none : it->second;
+         }
+
+         std::unordered_map<uint64_t, std::vector<row_view>>   tables;
+         buckets                                               accounts_by_code;
+         buckets                                               acclocks2_by_token;
+         buckets                                               acclocks_by_code;
+   };
+
+   struct snapshot_info {
+      uint32_t                   chain_version = 0; //of the chain_snapshot_header section
+      std::optional<uint32_t>    block_num;
+      std::optional<uint32_t>    block_time; //in seconds, when the block state has a known layout
+      uint64_t                   tables = 0; //of every contract
+      uint64_t                   rows = 0; //primary rows of every contract
+   };
+
+   /**
+    * Reads the sections of a snapshot, adding the primary rows of the tables of `contract` for
+    * which `wanted( table )` is true to `out`. Throws when the snapshot is malformed or has no
+    * contract tables.
+    *
+    * The block time is read from the block header state of chain snapshot versions 2 to 6.
+    */
+   template<typename Wanted>
+   snapshot_info read_snapshot( std::string_view data, uint64_t contract, Wanted&& wanted, contract_rows& out );
+
+   /// The time of the header of a `eosio::chain::block_state` section, false for an unknown layout.
+   bool read_block_time( std::string_view section, uint32_t chain_version, uint32_t& block_num, uint32_t& time );
+
+   /// Calls `f( name, body )` on each section, the body following the name. Throws when malformed.
+   void each_section( std::string_view data, const std::function<void( std::string_view, std::string_view )>& f );
+
+   template<typename Wanted>
+   snapshot_info read_snapshot( std::string_view data, uint64_t contract, Wanted&& wanted, contract_rows& out )
+   {
+      //fixed sizes of the rows of the secondary indexes: index64, index128, index256, index_double, index_long_double
+      static constexpr size_t secondary_size[5] = { 24, 32, 48, 24, 32 };
+
+      snapshot_info info;
+      bool          has_tables = false;
+      std::string_view block_state;
+      each_section( data, [&]( std::string_view name, std::string_view body ) {
+         if ( name == "eosio::chain::chain_snapshot_header" ) {
+            row_reader rd( body.data(), body.size() );
+            info.chain_version = rd.read<uint32_t>();
+         } else if ( name == "eosio::chain::block_state" ) {
+            block_state = body;
+         } else if ( name == "contract_tables" ) {
+            has_tables = true;
+            row_reader rd( body.data(), body.size() );
+            while( rd.ok() && !rd.done() ) {
+               uint64_t code  = rd.read<uint64_t>();
+               uint64_t scope = rd.read<uint64_t>();
+               uint64_t table = rd.read<uint64_t>();
+               rd.read<uint64_t>(); //payer
+               rd.read<uint32_t>(); //count
+               bool keep = code == contract && wanted( table );
+               info.tables++;
+
+               uint32_t n = rd.read_varuint32();
+               info.rows += n;
+               for( uint32_t i = 0; i < n && rd.ok(); i++ ) {
+                  row_view r;
+                  r.scope = scope;
+                  r.pk    = rd.read<uint64_t>();
+                  r.payer = rd.read<uint64_t>();
+                  r.value = rd.read_string();
+                  if ( keep ) out.add( table, r );
+               }
+               for( size_t size : secondary_size ) rd.skip( (size_t)rd.read_varuint32() * size );
+            }
+            if ( !rd.done() ) throw std::runtime_error( "malformed contract_tables section" );
+         }
+      } );
+      if ( !has_tables ) throw std::runtime_error( "the snapshot has no contract_tables section" );
+
+      uint32_t block_num = 0;
+      uint32_t time = 0;
+      if ( !block_state.empty() && read_block_time( block_state, info.chain_version, block_num, time ) ) {
+         info.block_num = block_num;
+         info.block_time = time;
+      }
+      return info;
+   }
+
+} /// namespace yotta::exporter
@@ -0,0 +1,78 @@
+#include "exporter.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+/**
+ * Exporter of the yotta.token tables of a portable nodeos snapshot, offline.
+ *
+ * It maps the snapshot file into memory, reads the rows of the contract's stat, accounts,
+ * tokenpool, lockrule, acclock, numlock and loanpool tables, v1 and v2, and sub-ledgers straight
+ * from the `contract_tables` section, and writes them split by token to `--out` as CSV or as
+ * columnar files (`exporter.hpp`, `table_writer.hpp`), the tokens spread over `--threads`
+ * threads. Each holder's available and locked balances are computed at the block time of the
+ * snapshot with the math of `get_lock_asset`, or at `--time` when given; snapshots whose block
+ * state the reader does not know (chain snapshot versions other than 2 to 6) need `--time`.
+ *
+ * Usage: snapshot_exporter --snapshot FILE --out DIR [--contract NAME] [--format csv|columnar]
+ *                          [--threads N] [--time SECONDS]
+ */
+using namespace yotta;
+using namespace yotta::exporter;
+
+int main( int argc, char** argv )
+{
+   std::string    snapshot;
+   std::string    out;
+   export_options opt;
+   bool           bad = false;
+   for( int i = 1; i < argc && !bad; i++ ) {
+      bool has_value = i + 1 < argc;
+      if ( std::strcmp( argv[i], "--snapshot" ) == 0 && has_value ) {
+         snapshot = argv[++i];
+      } else if ( std::strcmp( argv[i], "--out" ) == 0 && has_value ) {
+         out = argv[++i];
+      } else if ( std::strcmp( argv[i], "--contract" ) == 0 && has_value ) {
+         opt.contract = string_to_name( argv[++i] );
+      } else if ( std::strcmp( argv[i], "--format" ) == 0 && has_value ) {
+         std::string f = argv[++i];
+         if ( f == "csv" ) opt.format = output_format::csv;
+         else if ( f == "columnar" ) opt.format = output_format::columnar;
+         else bad = true;
+      } else if ( std::strcmp( argv[i], "--threads" ) == 0 && has_value ) {
+         opt.threads = (unsigned)std::strtoul( argv[++i], nullptr, 10 );
+      } else if ( std::strcmp( argv[i], "--time" ) == 0 && has_value ) {
+         opt.time = (uint32_t)std::strtoul( argv[++i], nullptr, 10 );
+      } else {
+         bad = true;
+      }
+   }
+   if ( bad || snapshot.empty() || out.empty() ) {
+      std::fprintf( stderr, "usage: %s --snapshot FILE --out DIR [--contract NAME] [--format csv|columnar]\n"
+                            "          [--threads N] [--time SECONDS]\n", argv[0] );
+      return 2;
+   }
+
+   try {
+      auto begin = std::chrono::steady_clock::now();
+      mapped_file file( snapshot );
+      auto stats = export_snapshot( file.data(), out, opt );
+      double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+
+      std::printf( "chain snapshot version %u, block %s, time %u: %llu tables, %llu rows, %llu contract rows, "
+                   "%llu tokens, %llu holders, %llu rows written, %llu skipped, %.1f s, %.0f MB per second\n",
+                   stats.snapshot.chain_version,
+                   stats.snapshot.block_num ? std::to_string( *stats.snapshot.block_num ).c_str() : "unknown",
+                   stats.time, (unsigned long long)stats.snapshot.tables, (unsigned long long)stats.snapshot.rows,
+                   (unsigned long long)stats.contract_rows, (unsigned long long)stats.tokens,
+                   (unsigned long long)stats.holders, (unsigned long long)stats.rows, (unsigned long long)stats.skipped,
+                   seconds, seconds > 0 ? file.data().size() / seconds / 1e6 : 0.0 );
+      return 0;
+   } catch( const std::exception& e ) {
+      std::fprintf( stderr, "%s\n", e.what() );
+      return 1;
+   }
+}
@@ -0,0 +1,172 @@
+#include "table_writer.hpp"
+#include <yotta.token.client.hpp>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace yotta::exporter {
+
+   namespace {
+
+      constexpr size_t flush_size = 1 << 20;
+
+      class output_file {
+         public:
+            explicit output_file( const std::string& path ) : path(path) {
+               file = std::fopen( path.c_str(), "wb" );
+               if ( !file ) throw std::runtime_error( "cannot write " + path );
+            }
+
+            ~output_file() {
+               if ( file ) std::fclose( file );
+            }
+
+            void write( const void* data, size_t size ) {
+               if ( size && std::fwrite( data, size, 1, file ) != 1 ) throw std::runtime_error( "cannot write " + path );
+            }
+
+            template<typename T>
+            void write( T v ) { write( &v, sizeof(v) ); }
+
+            void close() {
+               FILE* f = file;
+               file = nullptr;
+               if ( std::fclose( f ) != 0 ) throw std::runtime_error( "cannot write " + path );
+            }
+
+         private:
+            std::string    path;
+            FILE*          file = nullptr;
+      };
+
+      class csv_writer : public table_writer {
+         public:
+            csv_writer( const std::string& path, const std::vector<column>& columns ) : out( path ), columns(columns.size()) {
+               for( const auto& c : columns ) add( std::string_view( c.name ) );
+               end_row();
+               row_count = 0;
+            }
+
+            void add( int64_t v ) override {
+               separate();
+               buf += std::to_string( v );
+            }
+
+            void add_name( uint64_t v ) override {
+               separate();
+               buf += name_to_string( v );
+            }
+
+            void add( std::string_view v ) override {
+               separate();
+               if ( v.find_first_of( ",\"\r\n" ) == std::string_view::npos ) {
+                  buf.append( v );
+                  return;
+               }
+               buf.push_back( '"' );
+               for( char c : v ) {
+                  if ( c == '"' ) buf.push_back( '"' );
+                  buf.push_back( c );
+               }
+               buf.push_back( '"' );
+            }
+
+            void end_row() override {
+               if ( values != columns ) throw std::logic_error( "row with a wrong number of values" );
+               buf.push_back( '\n' );
+               values = 0;
+               row_count++;
+               if ( buf.size() >= flush_size ) flush();
+            }
+
+            void finish() override {
+               flush();
+               out.close();
+            }
+
+         private:
+            void separate() {
+               if ( values++ ) buf.push_back( ',' );
+            }
+
+            void flush() {
+               out.write( buf.data(), buf.size() );
+               buf.clear();
+            }
+
+            output_file    out;
+            size_t         columns;
+            size_t         values = 0;
+            std::string    buf;
+      };
+
+      /// Holds the columns in memory until `finish`, the format writing each one contiguously.
+      class columnar_writer : public table_writer {
+         public:
+            columnar_writer( const std::string& path, std::vector<column> columns )
+            : out( path ), columns(std::move( columns )), data(this->columns.size()) {}
+
+            void add( int64_t v ) override { next( column_type::int64 ).numbers.push_back( (uint64_t)v ); }
+            void add_name( uint64_t v ) override { next( column_type::name ).numbers.push_back( v ); }
+
+            void add( std::string_view v ) override {
+               auto& d = next( column_type::string );
+               d.bytes.append( v );
+               d.numbers.push_back( d.bytes.size() );
+            }
+
+            void end_row() override {
+               if ( values != columns.size() ) throw std::logic_error( "row with a wrong number of values" );
+               values = 0;
+               row_count++;
+            }
+
+            void finish() override {
+               out.write( columnar_magic );
+               out.write( columnar_version );
+               out.write( row_count );
+               out.write( (uint32_t)columns.size() );
+               for( const auto& c : columns ) {
+                  out.write( (uint8_t)c.type );
+                  out.write( (uint32_t)c.name.size() );
+                  out.write( c.name.data(), c.name.size() );
+               }
+               for( size_t i = 0; i < columns.size(); i++ ) {
+                  out.write( data[i].numbers.data(), data[i].numbers.size() * sizeof(uint64_t) );
+                  if ( columns[i].type == column_type::string ) {
+                     out.write( (uint64_t)data[i].bytes.size() );
+                     out.write( data[i].bytes.data(), data[i].bytes.size() );
+                  }
+               }
+               out.close();
+            }
+
+         private:
+            struct column_data {
+               std::vector<uint64_t>   numbers; //values, or end offsets of strings
+               std::string             bytes;
+            };
+
+            column_data& next( column_type type ) {
+               if ( values >= columns.size() || columns[values].type != type ) {
+                  throw std::logic_error( "value of the wrong type for column " + std::to_string( values ) );
+               }
+               return data[values++];
+            }
+
+            output_file                out;
+            std::vector<column>        columns;
+            std::vector<column_data>   data;
+            size_t                     values = 0;
+      };
+
+   } /// namespace
+
+   std::unique_ptr<table_writer> make_table_writer( output_format format, const std::string& path,
+                                                    std::vector<column> columns )
+   {
+      if ( format == output_format::csv ) return std::make_unique<csv_writer>( path + ".csv", columns );
+      return std::make_unique<columnar_writer>( path + ".ycol", std::move( columns ) );
+   }
+
+} /// namespace yotta::exporter
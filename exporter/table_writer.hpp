@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Writers of the exported tables, one file per table.
+ *
+ * CSV files have a header line of the column names; names are written as strings and strings
+ * are quoted when they hold a comma, a quote or a line break.
+ *
+ * Columnar files (`.ycol`) hold each column contiguously, all little-endian:
+ *
+ *     uint32 magic "YCOL", uint32 version (1), uint64 row count, uint32 column count,
+ *     per column: uint8 type, uint32 name size, name,
+ *     per column, in order: for `int64` and `name`, one uint64 per row; for `string`, uint64
+ *     end offsets of the rows into the bytes that follow, then a uint64 byte count and the bytes.
+ */
+namespace yotta::exporter {
+
+   enum class output_format { csv, columnar };
+
+   enum class column_type : uint8_t {
+      int64  = 0,
+      name   = 1, //a 64-bit eosio name
+      string = 2,
+   };
+
+   struct column {
+      std::string    name;
+      column_type    type;
+   };
+
+   constexpr uint32_t columnar_magic = 0x4c4f4359; //"YCOL"
+   constexpr uint32_t columnar_version = 1;
+
+   /**
+    * Writer of the rows of one table. Values are given in column order, then `end_row`; `finish`
+    * writes what is left and throws when the file cannot be written.
+    */
+   class table_writer {
+      public:
+         virtual ~table_writer() = default;
+
+         virtual void add( int64_t v ) = 0;
+         virtual void add_name( uint64_t v ) = 0;
+         virtual void add( std::string_view v ) = 0;
+         virtual void end_row() = 0;
+         virtual void finish() = 0;
+
+         uint64_t rows()const { return row_count; }
+
+      protected:
+         uint64_t row_count = 0;
+   };
+
+   /// Creates `path` plus `.csv` or `.ycol` with `columns`.
+   std::unique_ptr<table_writer> make_table_writer( output_format format, const std::string& path,
+                                                    std::vector<column> columns );
+
+} /// namespace yotta::exporter
@@ -0,0 +1,42 @@
+#include "contract_engine.hpp"
+
+#ifdef YOTTA_CANDIDATE_SOURCE
+
+/**
+ * The changed contract of `YOTTA_CANDIDATE_DIR`, next to the contract of this tree in one
+ * program: its names are moved aside by macros, and its `#include <yotta.token.hpp>` finds the
+ * header of this tree already included, its own being included first.
+ */
+#include <yotta.token.hpp>
+
+#define private public
+#define yotta yotta_candidate
+#define yottatoken candidate_yottatoken
+#include YOTTA_CANDIDATE_VESTING
+#include YOTTA_CANDIDATE_HEADER
+#include YOTTA_CANDIDATE_SOURCE
+#undef yottatoken
+#undef yotta
+#undef private
+
+namespace yotta::harness {
+
+   std::unique_ptr<engine> make_candidate_contract_engine( const std::vector<uint64_t>& accounts )
+   {
+      return std::make_unique<contract_engine<candidate_yottatoken>>( accounts );
+   }
+
+} /// namespace yotta::harness
+
+#else
+
+namespace yotta::harness {
+
+   std::unique_ptr<engine> make_candidate_contract_engine( const std::vector<uint64_t>& )
+   {
+      return nullptr;
+   }
+
+} /// namespace yotta::harness
+
+#endif
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "engine.hpp"
+#include <eosio/eosio.hpp>
+#include <stdexcept>
+#include <string>
+
+/**
+ * The encumbrance engine of a yotta.token contract built natively against the CDT stand-in of
+ * `native/eosio`: each action runs the contract's own code as one transaction on an in-memory
+ * chain.
+ *
+ * `Contract` is the contract class. Spendable balances are read through its private
+ * `get_lock_asset`, `get_loan_amount` and `get_allocated`, the helpers of `sub_balance`, so the
+ * translation unit instantiating this includes the contract source with private members made
+ * accessible.
+ *
+ * The uniqueness check contract is emulated: every account has bought a token permission and
+ * `simreg` numbers the tokens in creation order.
+ */
+namespace yotta::harness {
+
+   template<typename Contract>
+   class contract_engine : public engine {
+      public:
+         explicit contract_engine( const std::vector<uint64_t>& accounts )
+         {
+            chain.accounts.insert( accounts.begin(), accounts.end() );
+            chain.accounts.insert( contract_account );
+            chain.accounts.insert( registry_account );
+
+            auto& t = chain.db.get( userreg_table() );
+            for( uint64_t user : chain.accounts ) {
+               t.rows[user] = eosio::native::stored_row{ registry_account, eosio::pack( userreg{ eosio::name( user ), 0, 1, 1 } ) };
+            }
+            chain.on_action( eosio::name( registry_account ), eosio::name( "simreg" ),
+                             []( eosio::native::chain& c, const eosio::native::inline_action& ) {
+               auto& rows = c.db.get( userreg_table() );
+               for( auto& [user, row] : rows.rows ) {
+                  auto ur = eosio::unpack<userreg>( row.value );
+                  ur.next_tokenno++;
+                  c.db.update( rows, userreg_table(), user, 0, eosio::pack( ur ) );
+               }
+            } );
+
+            if ( !push( contract_account, [&]( Contract& c ) { c.setunicheck( eosio::name( registry_account ) ); } ) ) {
+               throw std::runtime_error( "setunicheck failed" );
+            }
+            chain.db.written_keys().clear();
+         }
+
+         void load( const table_dump& tables ) override
+         {
+            chain.db.clear( contract_account );
+            for( const auto& r : tables.all() ) {
+               auto [table, scope, pk] = r.key;
+               auto data = tables.data( r );
+               chain.db.get( { contract_account, table, scope } ).rows[pk] =
+                  eosio::native::stored_row{ r.payer, std::vector<char>( data.begin(), data.end() ) };
+            }
+         }
+
+         table_dump dump()const override
+         {
+            table_dump  out;
+            data_writer w;
+            for( const auto& [id, t] : chain.db.all() ) {
+               if ( id.code != contract_account ) continue;
+               for( const auto& [pk, row] : t.rows ) {
+                  size_t offset = w.size();
+                  for( char c : row.value ) w.write( c );
+                  out.add( id.table, id.scope, pk, row.payer, w, offset );
+               }
+            }
+            out.seal( w );
+            return out;
+         }
+
+         bool find_row( const row_key& key, uint64_t& payer, std::vector<char>& data )const override
+         {
+            const auto* t = chain.db.find( { contract_account, std::get<0>( key ), std::get<1>( key ) } );
+            if ( !t ) return false;
+            auto it = t->rows.find( std::get<2>( key ) );
+            if ( it == t->rows.end() ) return false;
+            payer = it->second.payer;
+            data = it->second.value;
+            return true;
+         }
+
+         void take_written( std::vector<row_key>& keys ) override
+         {
+            auto& written = chain.db.written_keys();
+            for( const auto& [id, pk] : written ) {
+               if ( id.code == contract_account ) keys.emplace_back( id.table, id.scope, pk );
+            }
+            written.clear();
+         }
+
+         void spendables( spendable_list& out ) override
+         {
+            out.clear();
+            chain.call( [&] {
+               Contract c( eosio::name{ contract_account }, eosio::name{ contract_account }, eosio::datastream<const char*>( nullptr, 0 ) );
+               const auto& all = chain.db.all();
+               for( auto it = all.lower_bound( { contract_account, accounts_table, 0 } );
+                    it != all.end() && it->first.code == contract_account && it->first.table == accounts_table; ++it ) {
+                  for( const auto& [code, row] : it->second.rows ) {
+                     out.push_back( { { it->first.scope, code }, spendable_of( c, eosio::name( it->first.scope ), row ) } );
+                  }
+               }
+            } );
+         }
+
+         bool spendable( const balance_key& key, int64_t& amount ) override
+         {
+            const auto* t = chain.db.find( { contract_account, accounts_table, key.first } );
+            if ( !t ) return false;
+            auto it = t->rows.find( key.second );
+            if ( it == t->rows.end() ) return false;
+            chain.call( [&] {
+               Contract c( eosio::name{ contract_account }, eosio::name{ contract_account }, eosio::datastream<const char*>( nullptr, 0 ) );
+               amount = spendable_of( c, eosio::name( key.first ), it->second );
+            } );
+            return true;
+         }
+
+         void set_time( uint64_t curtime ) override { chain.set_time( curtime ); }
+
+         bool create( uint64_t actor, uint64_t issuer, const asset_t& maximum_supply ) override
+         {
+            return push( actor, [&]( Contract& c ) { c.create( eosio::name( issuer ), to_asset( maximum_supply ), "", "" ); } );
+         }
+
+         bool issue( uint64_t actor, uint64_t to, const asset_t& quantity ) override
+         {
+            return push( actor, [&]( Contract& c ) { c.issue( eosio::name( to ), to_asset( quantity ), "" ); } );
+         }
+
+         bool setextime( uint64_t actor, uint64_t time, const asset_t& value ) override
+         {
+            return push( actor, [&]( Contract& c ) { c.setextime( time, to_asset( value ) ); } );
+         }
+
+         bool transfer( uint64_t actor, uint64_t from, uint64_t to, const asset_t& quantity ) override
+         {
+            return push( actor, [&]( Contract& c ) { c.transfer( eosio::name( from ), eosio::name( to ), to_asset( quantity ), "" ); } );
+         }
+
+         bool approve( uint64_t actor, uint64_t from, uint64_t manager, const asset_t& quantity ) override
+         {
+            return push( actor, [&]( Contract& c ) { c.approve( eosio::name( from ), eosio::name( manager ), to_asset( quantity ) ); } );
+         }
+
+         bool loantrans( uint64_t actor, uint64_t manager, uint64_t from, uint64_t to, const asset_t& quantity, bool bcreate ) override
+         {
+            return push( actor, [&]( Contract& c ) {
+               c.loantrans( eosio::name( manager ), eosio::name( from ), eosio::name( to ), to_asset( quantity ), bcreate, "" );
+            } );
+         }
+
+         bool addtknpool( uint64_t actor, uint64_t user, const asset_t& value ) override
+         {
+            return push( actor, [&]( Contract& c ) { c.addtknpool( eosio::name( user ), to_asset( value ), "", "" ); } );
+         }
+
+         bool addrule( uint64_t actor, uint64_t user, uint32_t lockruleid, const std::vector<uint64_t>& times,
+                       const std::vector<uint16_t>& pcts, uint32_t base, uint32_t period, const asset_t& value ) override
+         {
+            return push( actor, [&]( Contract& c ) {
+               c.addrule( eosio::name( user ), lockruleid, times, pcts, base, period, to_asset( value ), "" );
+            } );
+         }
+
+         bool locktransfer( uint64_t actor, uint32_t lockruleid, uint64_t from, uint64_t to, const asset_t& quantity ) override
+         {
+            return push( actor, [&]( Contract& c ) {
+               c.locktransfer( lockruleid, eosio::name( from ), eosio::name( to ), to_asset( quantity ), "" );
+            } );
+         }
+
+         bool unlockasset( uint64_t actor, uint64_t acc, const asset_t& value ) override
+         {
+            return push( actor, [&]( Contract& c ) { c.unlockasset( eosio::name( acc ), to_asset( value ), "" ); } );
+         }
+
+      private:
+         struct userreg {
+            eosio::name    user;
+            uint32_t       reg_count;
+            uint32_t       total_count;
+            uint32_t       next_tokenno;
+         };
+
+         static eosio::native::table_id userreg_table() {
+            return { registry_account, string_to_name( "userreg" ), registry_account };
+         }
+
+         /// Action data is not validated when it is unpacked, so neither is this.
+         static eosio::asset to_asset( const asset_t& a ) {
+            eosio::asset r;
+            r.amount = a.amount;
+            r.symbol = eosio::symbol( a.symbol );
+            return r;
+         }
+
+         /// What `sub_balance` lets `owner` spend of the balance in `row`.
+         static int64_t spendable_of( Contract& c, eosio::name owner, const eosio::native::stored_row& row ) {
+            auto balance = eosio::unpack<eosio::asset>( row.value );
+            int64_t locked = c.get_lock_asset( owner, balance ).amount;
+            int64_t reserved = c.get_loan_amount( owner, balance.symbol ) + c.get_allocated( owner, balance.symbol );
+            return balance.amount - locked - reserved;
+         }
+
+         /// Runs an action of the contract as a transaction, the contract object living as long as the action.
+         template<typename F>
+         bool push( uint64_t actor, F&& f ) {
+            return chain.push( eosio::name( contract_account ), { eosio::name( actor ) }, [&] {
+               Contract c( eosio::name{ contract_account }, eosio::name{ contract_account }, eosio::datastream<const char*>( nullptr, 0 ) );
+               f( c );
+            } );
+         }
+
+         eosio::native::chain chain;
+   };
+
+} /// namespace yotta::harness
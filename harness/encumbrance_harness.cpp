@@ -0,0 +1,600 @@
+#include "engine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/**
+ * Deterministic fuzz and differential harness of the encumbrance engine.
+ *
+ * It drives random sequences of create, issue, setextime, transfer, approve, loantrans, addtknpool,
+ * addrule, locktransfer and unlockasset, with the clock advancing between steps and now and then
+ * an actor without the authority required, against the contract in this tree built natively
+ * (the reference) and a candidate. After every step it compares whether the action was accepted,
+ * every row either engine wrote, with its payer, and the spendable balances of the holders of the
+ * rows written; every spendable balance when the clock moved or a token or rule row was written;
+ * and all tables every `full_compare_interval` steps and at the end. The tables start with rows
+ * of the old v1 tables, so the lazy conversion to v2 is covered too.
+ *
+ * The candidate is the independent model of `model_engine.hpp`, or with `--candidate contract`
+ * the changed contract the harness was built with (`YOTTA_CANDIDATE_DIR`). `--self-test` runs the
+ * model with each planted divergence and fails unless the harness reports every one.
+ *
+ * Usage: encumbrance_harness [--seed N] [--steps N] [--jobs N] [--candidate model|contract] [--self-test]
+ *
+ * `--jobs N` runs N consecutive seeds from `--seed` in parallel, `--steps` actions each.
+ */
+using namespace yotta;
+using namespace yotta::harness;
+
+namespace {
+
+   constexpr uint64_t start_time = 1600000000;
+   constexpr uint64_t max_time = std::numeric_limits<uint32_t>::max(); //seconds of a block time
+   constexpr uint64_t full_compare_interval = 1000;
+   constexpr uint64_t self_test_steps = 200000;
+
+   const std::vector<uint64_t> accounts = {
+      string_to_name( "alice" ), string_to_name( "bob" ), string_to_name( "carol" ), string_to_name( "dave" ),
+      string_to_name( "erin" ), string_to_name( "frank" ), string_to_name( "grace" ), string_to_name( "heidi" ),
+   };
+
+   //the first three are created at setup, the last one only by the fuzzer
+   const char* const codes[] = { "AAA", "BBB", "CCC", "DDD" };
+   constexpr size_t code_count = sizeof( codes ) / sizeof( codes[0] );
+   constexpr uint8_t precision = 4;
+
+   const std::pair<mutant, const char*> mutants[] = {
+      { mutant::skip_auth, "skip_auth" },
+      { mutant::spend_off_by_one, "spend_off_by_one" },
+      { mutant::ignore_v1_acclocks, "ignore_v1_acclocks" },
+      { mutant::keep_acclock_time, "keep_acclock_time" },
+      { mutant::keep_debit_payer, "keep_debit_payer" },
+      { mutant::skip_loan_upgrade, "skip_loan_upgrade" },
+   };
+
+   /// The engines disagree.
+   struct divergence : std::runtime_error {
+      using std::runtime_error::runtime_error;
+   };
+
+   struct fuzzer {
+      std::mt19937_64            rng;
+      std::map<uint64_t, uint64_t> issuers; //by symbol code, of the tokens created
+
+      explicit fuzzer( uint64_t seed ) : rng( seed ) {}
+
+      uint64_t below( uint64_t n ) { return rng() % n; }
+      bool     chance( uint64_t percent ) { return below( 100 ) < percent; }
+      uint64_t account() { return accounts[below( accounts.size() )]; }
+
+      /// `required`, sometimes another account.
+      uint64_t actor( uint64_t required ) { return chance( 5 ) ? account() : required; }
+
+      uint64_t issuer( const asset_t& value ) {
+         auto it = issuers.find( value.code() );
+         return it == issuers.end() ? account() : it->second;
+      }
+
+      uint64_t symbol( size_t code ) { return string_to_symbol( precision, codes[code] ); }
+
+      /// A token symbol, sometimes unknown, invalid or with the wrong precision.
+      asset_t token( int64_t amount = 0 ) {
+         size_t code = chance( 3 ) ? code_count - 1 : below( code_count - 1 );
+         uint64_t sym = chance( 3 ) ? string_to_symbol( precision - 1, codes[code] ) : symbol( code );
+         if ( chance( 1 ) ) sym = string_to_symbol( precision, "AaA" );
+         return asset_t{ amount, sym };
+      }
+
+      /// An amount around `hint`, or small, large, zero or negative.
+      int64_t amount( int64_t hint ) {
+         switch( below( 10 ) ) {
+            case 0: return -(int64_t)below( 5 );
+            case 1: case 2: return 1 + (int64_t)below( 1000000 );
+            case 3: case 4: case 5: return 1 + (int64_t)below( 1000 );
+            default: return hint + (int64_t)below( 3 ) - 1;
+         }
+      }
+
+      uint32_t lockruleid() {
+         if ( chance( 5 ) ) return (uint32_t)below( 101 );
+         return 101 + (uint32_t)below( 12 );
+      }
+
+      /// Rule vectors, valid most of the time.
+      void rule( std::vector<uint64_t>& times, std::vector<uint16_t>& pcts, uint32_t& base, uint32_t& period ) {
+         base = chance( 50 ) ? 100 : 10000;
+         size_t n = chance( 40 ) ? 1 : 2 + below( 4 );
+         if ( chance( 5 ) ) n = below( 3 );
+         uint64_t t = below( 10000 );
+         uint16_t p = 0;
+         for( size_t i = 0; i < n; i++ ) {
+            times.push_back( t );
+            t += 1 + below( 50000 );
+            p = std::min<uint32_t>( base, p + 1 + below( base / n + 1 ) );
+            pcts.push_back( n == 1 ? (uint16_t)below( base / 4 + 1 ) : p );
+         }
+         period = 1 + (uint32_t)below( 100000 );
+         if ( chance( 5 ) && !times.empty() ) times.back() = chance( 50 ) ? 0 : ( 1ULL << 33 );
+         if ( chance( 3 ) ) pcts.push_back( 1 );
+         if ( chance( 3 ) ) period = 0;
+      }
+   };
+
+   /// Rows of the old tables, as left by the previous version of the contract.
+   table_dump add_legacy_rows( fuzzer& fz, const table_dump& tables, const spendable_list& holders )
+   {
+      table_dump  out;
+      data_writer w;
+      size_t      offset = 0;
+      for( const auto& r : tables.all() ) {
+         offset = w.size();
+         for( char c : tables.data( r ) ) w.write( c );
+         out.add( std::get<0>( r.key ), std::get<1>( r.key ), std::get<2>( r.key ), r.payer, w, offset );
+      }
+      for( size_t code = 0; code < code_count - 1; code++ ) {
+         uint64_t sym = fz.symbol( code );
+         uint64_t scope = sym >> 8;
+         uint32_t tokenno = code + 1;
+         for( uint32_t id = 101; id <= 105; id++ ) {
+            std::vector<uint64_t> times;
+            std::vector<uint16_t> pcts;
+            uint32_t base, period;
+            fz.rule( times, pcts, base, period );
+            if ( times.empty() || times.size() != pcts.size() || period == 0 ) continue;
+            offset = w.size();
+            w.write( id ).write_array( times ).write_array( pcts ).write( base ).write( period ).write_string( "v1" );
+            out.add( lockrule_table, scope, id, accounts[code], w, offset );
+         }
+         for( const auto& [k, spendable] : holders ) {
+            if ( k.second != scope ) continue;
+            uint64_t user = k.first;
+            if ( fz.chance( 40 ) ) {
+               offset = w.size();
+               w.write( user ).write_asset( asset_t{ 1 + (int64_t)fz.below( 100000 ), sym } );
+               out.add( numlock_table, scope, user, accounts[code], w, offset );
+            }
+            if ( fz.chance( 30 ) ) {
+               offset = w.size();
+               w.write( user ).write( fz.account() ).write_asset( asset_t{ 1 + (int64_t)fz.below( 100000 ), sym } );
+               out.add( loanpool_table, scope, user, user, w, offset );
+            }
+            for( int n = fz.below( 4 ); n > 0; n-- ) {
+               uint64_t no_ruleid = ( (uint64_t)tokenno << 32 ) + 101 + fz.below( 8 );
+               offset = w.size();
+               w.write( no_ruleid ).write_asset( asset_t{ 1 + (int64_t)fz.below( 100000 ), sym } ).write( user )
+                .write( start_time - fz.below( 100000 ) );
+               out.add( acclock_table, user, no_ruleid, accounts[code], w, offset );
+            }
+         }
+      }
+      out.seal( w );
+      return out;
+   }
+
+   std::string hex( const std::vector<char>& data )
+   {
+      std::string out;
+      char buf[3];
+      for( char c : data ) {
+         std::snprintf( buf, sizeof( buf ), "%02x", (uint8_t)c );
+         out += buf;
+      }
+      return out;
+   }
+
+   std::string describe_key( const row_key& k )
+   {
+      return "table " + name_to_string( std::get<0>( k ) ) + " scope " + std::to_string( std::get<1>( k ) )
+           + " key " + std::to_string( std::get<2>( k ) );
+   }
+
+   std::string describe_row( const engine& e, const row_key& k )
+   {
+      uint64_t payer = 0;
+      std::vector<char> data;
+      if ( !e.find_row( k, payer, data ) ) return "missing";
+      return hex( data ) + " paid by " + name_to_string( payer );
+   }
+
+   std::string code_to_string( uint64_t code )
+   {
+      std::string str;
+      for( ; code; code >>= 8 ) str.push_back( (char)( code & 0xff ) );
+      return str;
+   }
+
+   /**
+    * One seeded run of the fuzzer against a reference and a candidate engine.
+    */
+   class run {
+      public:
+         run( uint64_t seed, std::unique_ptr<engine> reference, std::unique_ptr<engine> candidate )
+         : seed(seed), fz(seed), reference(std::move(reference)), candidate(std::move(candidate)) {}
+
+         uint64_t accepted = 0; //of the actions compared
+         uint64_t done = 0; //actions compared
+
+         /// Runs `steps` actions, throwing `divergence` at the first difference.
+         void go( uint64_t steps ) {
+            setup();
+            for( step = 1; step <= steps; step++ ) {
+               bool clock_moved = fz.chance( 4 ) && curtime < max_time;
+               if ( clock_moved ) {
+                  curtime = std::min( max_time, curtime + ( fz.chance( 90 ) ? 1 + fz.below( 1500 ) : 1 + fz.below( 250000 ) ) );
+                  reference->set_time( curtime );
+                  candidate->set_time( curtime );
+               }
+               random_action();
+               bool shared_rows = compare_written();
+               if ( clock_moved || shared_rows || step % full_compare_interval == 0 ) {
+                  compare_spendables();
+               } else {
+                  compare_holders();
+               }
+               if ( step % full_compare_interval == 0 ) compare_tables();
+               done = step;
+            }
+            compare_tables();
+         }
+
+      private:
+         [[noreturn]] void fail( const std::string& what ) {
+            throw divergence( "seed " + std::to_string( seed ) + " step " + std::to_string( step ) + ": " + what
+                              + " after " + action );
+         }
+
+         void setup() {
+            reference->set_time( curtime );
+            candidate->set_time( curtime );
+            for( size_t code = 0; code < code_count - 1; code++ ) {
+               uint64_t issuer = accounts[code];
+               asset_t  supply{ 1000000000000LL, fz.symbol( code ) };
+               fz.issuers[supply.code()] = issuer;
+               apply( "setup create " + asset_to_string( supply ), [&]( engine& e ) { return e.create( issuer, issuer, supply ); } );
+               apply( "setup issue", [&]( engine& e ) { return e.issue( issuer, issuer, asset_t{ supply.amount / 2, supply.symbol } ); } );
+               apply( "setup addtknpool", [&]( engine& e ) { return e.addtknpool( issuer, issuer, supply ); } );
+               for( uint64_t to : accounts ) {
+                  if ( to == issuer ) continue;
+                  apply( "setup transfer", [&]( engine& e ) { return e.transfer( issuer, issuer, to, asset_t{ 1000000, supply.symbol } ); } );
+               }
+               if ( code < 2 ) {
+                  apply( "setup setextime", [&]( engine& e ) { return e.setextime( issuer, start_time - 50000 * code, supply ); } );
+               }
+            }
+            reference->spendables( ref_spendable );
+            table_dump tables = add_legacy_rows( fz, reference->dump(), ref_spendable );
+            reference->load( tables );
+            candidate->load( tables );
+            for( const auto& r : tables.all() ) {
+               currency_stat_row st;
+               auto data = tables.data( r );
+               if ( std::get<0>( r.key ) == stat_table && decode( data.data(), data.size(), st ) ) {
+                  token_terms[std::get<2>( r.key )] = { st.time, st.tokenno };
+               }
+            }
+            action = "loading the tables";
+            compare_tables();
+            compare_spendables();
+            accepted = 0;
+         }
+
+         /// Runs an action on both engines.
+         template<typename Act>
+         bool apply( std::string desc, Act&& act ) {
+            action = std::move( desc );
+            bool ok = act( *reference );
+            if ( act( *candidate ) != ok ) fail( ok ? "only the reference accepts the action" : "only the candidate accepts the action" );
+            accepted += ok;
+            return ok;
+         }
+
+         /**
+          * Compares the rows written, true when one of them is a rule or changes the exchanging time
+          * or the number of a token, which every holder depends on.
+          */
+         bool compare_written() {
+            bool shared_rows = false;
+            keys.clear();
+            holders.clear();
+            reference->take_written( keys );
+            candidate->take_written( keys );
+            std::sort( keys.begin(), keys.end() );
+            keys.erase( std::unique( keys.begin(), keys.end() ), keys.end() );
+            for( const auto& k : keys ) {
+               uint64_t ref_payer = 0, cand_payer = 0;
+               bool ref_found = reference->find_row( k, ref_payer, ref_data );
+               bool cand_found = candidate->find_row( k, cand_payer, cand_data );
+               if ( ref_found != cand_found || ( ref_found && ( ref_payer != cand_payer || ref_data != cand_data ) ) ) {
+                  fail( describe_key( k ) + " differs: reference " + describe_row( *reference, k ) + ", candidate "
+                        + describe_row( *candidate, k ) );
+               }
+               auto [table, scope, pk] = k;
+               if ( table == stat_table ) {
+                  currency_stat_row st;
+                  if ( ref_found && !decode( ref_data.data(), ref_data.size(), st ) ) fail( describe_key( k ) + " is malformed" );
+                  auto terms = ref_found ? std::make_pair( st.time, st.tokenno ) : std::make_pair( uint64_t(0), uint32_t(0) );
+                  auto& known = token_terms[pk];
+                  shared_rows |= known != terms;
+                  known = terms;
+               } else if ( table == lockrule_table || table == lockrule2_table ) {
+                  shared_rows = true;
+               } else if ( table == accounts_table ) {
+                  holders.push_back( { scope, pk } );
+               } else if ( table == acclock2_table ) {
+                  holders.push_back( { scope, token_of( (uint32_t)( pk >> 32 ) ) } );
+               } else if ( table == acclock_table ) {
+                  acclock_row lock;
+                  bool known = ref_found && decode( ref_data.data(), ref_data.size(), lock );
+                  holders.push_back( { scope, known ? lock.quantity.code() : 0 } );
+               } else if ( table != tokenpool_table && table != unicheck_table ) {
+                  holders.push_back( { pk, scope } ); //numlock and loanpool rows, in the scope of the token
+               }
+            }
+            return shared_rows;
+         }
+
+         /// The symbol code of token number `tokenno`, 0 when it is not known.
+         uint64_t token_of( uint32_t tokenno )const {
+            for( const auto& [code, terms] : token_terms ) {
+               if ( terms.second == tokenno ) return code;
+            }
+            return 0;
+         }
+
+         /// Compares the spendable balances of the holders of the rows written.
+         void compare_holders() {
+            std::sort( holders.begin(), holders.end() );
+            holders.erase( std::unique( holders.begin(), holders.end() ), holders.end() );
+            uint64_t any_token = 0; //the last holder compared in every token
+            for( const auto& [owner, code] : holders ) {
+               if ( code == 0 ) {
+                  for( const char* c : codes ) compare_holder( { owner, string_to_symbol( precision, c ) >> 8 } );
+                  any_token = owner;
+               } else if ( owner != any_token ) {
+                  compare_holder( { owner, code } );
+               }
+            }
+         }
+
+         void compare_holder( const balance_key& k ) {
+            int64_t ref_amount = 0, cand_amount = 0;
+            bool ref_found = reference->spendable( k, ref_amount );
+            bool cand_found = candidate->spendable( k, cand_amount );
+            if ( ref_found != cand_found || ref_amount != cand_amount ) {
+               fail( "spendable of " + name_to_string( k.first ) + " in " + code_to_string( k.second ) + " differs: reference "
+                     + ( ref_found ? std::to_string( ref_amount ) : std::string( "missing" ) ) + ", candidate "
+                     + ( cand_found ? std::to_string( cand_amount ) : std::string( "missing" ) ) );
+            }
+         }
+
+         void compare_spendables() {
+            reference->spendables( ref_spendable );
+            candidate->spendables( cand_spendable );
+            if ( ref_spendable == cand_spendable ) return;
+            for( size_t i = 0; i < ref_spendable.size(); i++ ) {
+               const auto& [k, amount] = ref_spendable[i];
+               if ( i >= cand_spendable.size() || cand_spendable[i].first != k || cand_spendable[i].second != amount ) {
+                  fail( "spendable of " + name_to_string( k.first ) + " in " + code_to_string( k.second ) + " differs: reference "
+                        + std::to_string( amount ) + ", candidate "
+                        + ( i < cand_spendable.size() && cand_spendable[i].first == k ? std::to_string( cand_spendable[i].second )
+                                                                                      : std::string( "missing" ) ) );
+               }
+            }
+            fail( "the candidate has spendable balances the reference does not" );
+         }
+
+         void compare_tables() {
+            table_dump ref = reference->dump();
+            table_dump cand = candidate->dump();
+            if ( ref == cand ) return;
+            auto a = ref.all().begin();
+            auto b = cand.all().begin();
+            while( a != ref.all().end() && b != cand.all().end() && a->key == b->key && a->payer == b->payer
+                   && ref.data( *a ) == cand.data( *b ) ) {
+               ++a;
+               ++b;
+            }
+            row_key k = a == ref.all().end() ? b->key : b == cand.all().end() ? a->key : std::min( a->key, b->key );
+            fail( describe_key( k ) + " differs: reference " + describe_row( *reference, k ) + ", candidate "
+                  + describe_row( *candidate, k ) );
+         }
+
+         void random_action();
+
+         uint64_t                   seed;
+         fuzzer                     fz;
+         std::unique_ptr<engine>    reference;
+         std::unique_ptr<engine>    candidate;
+         uint64_t                   curtime = start_time;
+         uint64_t                   step = 0;
+         std::string                action = "setup";
+
+         std::vector<row_key>       keys; //written by the last action
+         std::map<uint64_t, std::pair<uint64_t, uint32_t>> token_terms; //exchanging time and number, by symbol code
+         std::vector<balance_key>   holders; //of the rows written, with a symbol code of 0 for any token
+         std::vector<char>          ref_data;
+         std::vector<char>          cand_data;
+         spendable_list             ref_spendable;
+         spendable_list             cand_spendable;
+   };
+
+   void run::random_action()
+   {
+      uint64_t from = fz.account();
+      uint64_t to = fz.chance( 5 ) ? from : fz.account();
+      asset_t  value = fz.token();
+      int64_t  spendable = 0;
+      reference->spendable( { from, value.code() }, spendable );
+      value.amount = fz.amount( spendable );
+      std::string desc = name_to_string( from ) + " " + name_to_string( to ) + " " + asset_to_string( value );
+
+      uint64_t pick = fz.below( 100 );
+      if ( pick < 2 ) {
+         uint64_t actor = fz.actor( from );
+         value.amount = fz.chance( 90 ) ? 1000000000000LL : fz.amount( 0 );
+         if ( apply( "create " + desc + " by " + name_to_string( actor ), [&]( engine& e ) { return e.create( actor, from, value ); } ) ) {
+            fz.issuers[value.code()] = from;
+         }
+      } else if ( pick < 10 ) {
+         uint64_t actor = fz.actor( fz.issuer( value ) );
+         apply( "issue " + desc + " by " + name_to_string( actor ), [&]( engine& e ) { return e.issue( actor, to, value ); } );
+      } else if ( pick < 12 ) {
+         uint64_t actor = fz.actor( fz.issuer( value ) );
+         uint64_t time = start_time + fz.below( 1000000 );
+         apply( "setextime " + std::to_string( time ) + " " + desc + " by " + name_to_string( actor ),
+                [&]( engine& e ) { return e.setextime( actor, time, value ); } );
+      } else if ( pick < 35 ) {
+         uint64_t actor = fz.actor( from );
+         apply( "transfer " + desc + " by " + name_to_string( actor ), [&]( engine& e ) { return e.transfer( actor, from, to, value ); } );
+      } else if ( pick < 47 ) {
+         uint64_t actor = fz.actor( from );
+         apply( "approve " + desc + " by " + name_to_string( actor ), [&]( engine& e ) { return e.approve( actor, from, to, value ); } );
+      } else if ( pick < 60 ) {
+         uint64_t manager = fz.chance( 20 ) ? fz.account() : to;
+         uint64_t actor = fz.actor( manager );
+         uint64_t payee = fz.account();
+         bool     bcreate = fz.chance( 70 );
+         apply( "loantrans " + name_to_string( manager ) + " " + desc + " " + name_to_string( payee ) + ( bcreate ? " create" : "" )
+                + " by " + name_to_string( actor ),
+                [&]( engine& e ) { return e.loantrans( actor, manager, from, payee, value, bcreate ); } );
+      } else if ( pick < 63 ) {
+         uint64_t actor = fz.actor( fz.issuer( value ) );
+         apply( "addtknpool " + desc + " by " + name_to_string( actor ), [&]( engine& e ) { return e.addtknpool( actor, from, value ); } );
+      } else if ( pick < 70 ) {
+         std::vector<uint64_t> times;
+         std::vector<uint16_t> pcts;
+         uint32_t base, period;
+         uint32_t id = fz.lockruleid();
+         uint64_t actor = fz.actor( from );
+         fz.rule( times, pcts, base, period );
+         apply( "addrule " + desc + " id " + std::to_string( id ) + " size " + std::to_string( times.size() ) + " base "
+                + std::to_string( base ) + " period " + std::to_string( period ) + " by " + name_to_string( actor ),
+                [&]( engine& e ) { return e.addrule( actor, from, id, times, pcts, base, period, value ); } );
+      } else if ( pick < 88 ) {
+         uint32_t id = fz.chance( 25 ) ? 0 : fz.lockruleid();
+         uint64_t actor = fz.actor( from );
+         apply( "locktransfer " + desc + " id " + std::to_string( id ) + " by " + name_to_string( actor ),
+                [&]( engine& e ) { return e.locktransfer( actor, id, from, to, value ); } );
+      } else {
+         uint64_t actor = fz.actor( fz.issuer( value ) );
+         value.amount = fz.chance( 50 ) ? (int64_t)fz.below( 100000 ) : fz.amount( 0 );
+         apply( "unlockasset " + name_to_string( from ) + " " + asset_to_string( value ) + " by " + name_to_string( actor ),
+                [&]( engine& e ) { return e.unlockasset( actor, from, value ); } );
+      }
+   }
+
+   std::unique_ptr<engine> make_candidate( const std::string& kind, mutant m )
+   {
+      if ( kind == "contract" ) {
+         auto e = make_candidate_contract_engine( accounts );
+         if ( !e ) throw std::invalid_argument( "the harness was built without YOTTA_CANDIDATE_DIR" );
+         return e;
+      }
+      if ( kind != "model" ) throw std::invalid_argument( "unknown candidate " + kind );
+      return make_model_engine( accounts, m );
+   }
+
+   struct result {
+      uint64_t    actions = 0;
+      uint64_t    accepted = 0;
+      std::string failure; //empty when the engines agree
+   };
+
+   result run_seed( uint64_t seed, uint64_t steps, const std::string& kind, mutant m )
+   {
+      run r( seed, make_reference_engine( accounts ), make_candidate( kind, m ) );
+      result out;
+      try {
+         r.go( steps );
+      } catch( const divergence& d ) {
+         out.failure = d.what();
+      }
+      out.actions = r.done;
+      out.accepted = r.accepted;
+      return out;
+   }
+
+   /// Every planted divergence of the model must be reported.
+   int self_test( uint64_t seed )
+   {
+      int missed = 0;
+      for( const auto& [m, name] : mutants ) {
+         result r = run_seed( seed, self_test_steps, "model", m );
+         if ( r.failure.empty() ) {
+            std::fprintf( stderr, "mutant %s was not caught in %llu steps\n", name, (unsigned long long)self_test_steps );
+            missed++;
+         } else {
+            std::printf( "mutant %s caught: %s\n", name, r.failure.c_str() );
+         }
+      }
+      return missed ? 1 : 0;
+   }
+
+} /// namespace
+
+int main( int argc, char** argv )
+{
+   uint64_t    seed = 1;
+   uint64_t    steps = 1000000;
+   uint64_t    jobs = 1;
+   std::string kind = "model";
+   bool        test_mutants = false;
+   for( int i = 1; i < argc; i++ ) {
+      bool has_value = i + 1 < argc;
+      if ( std::strcmp( argv[i], "--self-test" ) == 0 ) {
+         test_mutants = true;
+      } else if ( std::strcmp( argv[i], "--seed" ) == 0 && has_value ) {
+         seed = std::strtoull( argv[++i], nullptr, 10 );
+      } else if ( std::strcmp( argv[i], "--steps" ) == 0 && has_value ) {
+         steps = std::strtoull( argv[++i], nullptr, 10 );
+      } else if ( std::strcmp( argv[i], "--jobs" ) == 0 && has_value ) {
+         jobs = std::max<uint64_t>( 1, std::strtoull( argv[++i], nullptr, 10 ) );
+      } else if ( std::strcmp( argv[i], "--candidate" ) == 0 && has_value ) {
+         kind = argv[++i];
+      } else {
+         std::fprintf( stderr, "usage: %s [--seed N] [--steps N] [--jobs N] [--candidate model|contract] [--self-test]\n", argv[0] );
+         return 2;
+      }
+   }
+
+   try {
+      if ( test_mutants ) return self_test( seed );
+
+      std::vector<result>      results( jobs );
+      std::vector<std::thread> threads;
+      auto begin = std::chrono::steady_clock::now();
+      for( uint64_t j = 0; j < jobs; j++ ) {
+         threads.emplace_back( [&, j] { results[j] = run_seed( seed + j, steps, kind, mutant::none ); } );
+      }
+      for( auto& t : threads ) t.join();
+      double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+
+      int status = 0;
+      uint64_t total = 0;
+      uint64_t accepted = 0;
+      for( const auto& r : results ) {
+         total += r.actions;
+         accepted += r.accepted;
+         if ( !r.failure.empty() ) {
+            std::fprintf( stderr, "%s\n", r.failure.c_str() );
+            status = 1;
+         }
+      }
+      std::printf( "seeds %llu-%llu: %llu actions, %llu accepted, %.1f s, %.0f actions per minute\n",
+                   (unsigned long long)seed, (unsigned long long)( seed + jobs - 1 ), (unsigned long long)total,
+                   (unsigned long long)accepted, seconds, seconds > 0 ? total * 60 / seconds : 0.0 );
+      return status;
+   } catch( const std::exception& e ) {
+      std::fprintf( stderr, "%s\n", e.what() );
+      return 2;
+   }
+}
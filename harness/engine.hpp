@@ -0,0 +1,153 @@
+#pragma once
+
+#include <yotta.token.client.hpp>
+#include <algorithm>
+#include <memory>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * Interface of an implementation of the yotta.token encumbrance engine, as driven by
+ * `encumbrance_harness`.
+ *
+ * Tables are exchanged in the contract's binary row format, keyed by (table, scope, primary key)
+ * and with the payer of each row, so an implementation with another schema can still be loaded
+ * and compared.
+ */
+namespace yotta::harness {
+
+   constexpr uint64_t contract_account = string_to_name( "yotta.token" );
+   constexpr uint64_t registry_account = string_to_name( "reg.token" ); //the uniqueness check contract
+
+   constexpr uint64_t unicheck_table  = string_to_name( "unicheckname" );
+   constexpr uint64_t stat_table      = string_to_name( "stat" );
+   constexpr uint64_t accounts_table  = string_to_name( "accounts" );
+   constexpr uint64_t tokenpool_table = string_to_name( "tokenpool" );
+   constexpr uint64_t lockrule_table  = string_to_name( "lockrule" );
+   constexpr uint64_t lockrule2_table = string_to_name( "lockrule2" );
+   constexpr uint64_t acclock_table   = string_to_name( "acclock" );
+   constexpr uint64_t acclock2_table  = string_to_name( "acclock2" );
+   constexpr uint64_t numlock_table   = string_to_name( "numlock" );
+   constexpr uint64_t numlock2_table  = string_to_name( "numlock2" );
+   constexpr uint64_t loanpool_table  = string_to_name( "loanpool" );
+   constexpr uint64_t loanpool2_table = string_to_name( "loanpool2" );
+
+   using row_key       = std::tuple<uint64_t, uint64_t, uint64_t>; //table, scope, primary key
+
+   /**
+    * Rows of every table, in one buffer and sorted by key once `seal` is called.
+    */
+   class table_dump {
+      public:
+         struct row {
+            row_key     key;
+            uint64_t    payer = 0;
+            uint32_t    offset = 0;
+            uint32_t    size = 0;
+         };
+
+         /// Appends the row written to `w` since `offset`, the size of `w` before writing it.
+         void add( uint64_t table, uint64_t scope, uint64_t pk, uint64_t payer, const data_writer& w, size_t offset ) {
+            rows.push_back( row{ row_key{ table, scope, pk }, payer, (uint32_t)offset, (uint32_t)( w.size() - offset ) } );
+         }
+
+         void seal( data_writer& w ) {
+            bytes = w.release();
+            std::sort( rows.begin(), rows.end(), []( const row& a, const row& b ) { return a.key < b.key; } );
+         }
+
+         const std::vector<row>& all()const { return rows; }
+         std::string_view data( const row& r )const { return std::string_view( bytes.data() + r.offset, r.size ); }
+
+         /// The first row not less than `key`.
+         std::vector<row>::const_iterator lower_bound( const row_key& key )const {
+            return std::lower_bound( rows.begin(), rows.end(), key, []( const row& r, const row_key& k ) { return r.key < k; } );
+         }
+
+         const row* find( const row_key& key )const {
+            auto it = lower_bound( key );
+            return it != rows.end() && it->key == key ? &*it : nullptr;
+         }
+
+         bool operator==( const table_dump& other )const {
+            if ( rows.size() != other.rows.size() ) return false;
+            for( size_t i = 0; i < rows.size(); i++ ) {
+               if ( rows[i].key != other.rows[i].key || rows[i].payer != other.rows[i].payer
+                    || data( rows[i] ) != other.data( other.rows[i] ) ) return false;
+            }
+            return true;
+         }
+
+      private:
+         std::vector<row>  rows;
+         std::vector<char> bytes;
+   };
+
+   using balance_key    = std::pair<uint64_t, uint64_t>; //owner, symbol code
+   using spendable_list = std::vector<std::pair<balance_key, int64_t>>; //sorted by key
+
+   class engine {
+      public:
+         virtual ~engine() = default;
+
+         /// Replaces every table, e.g. with rows of the old tables not converted yet.
+         virtual void load( const table_dump& tables ) = 0;
+         virtual table_dump dump()const = 0;
+
+         /// Finds one row, false when it does not exist.
+         virtual bool find_row( const row_key& key, uint64_t& payer, std::vector<char>& data )const = 0;
+
+         /// Appends the keys of the rows written since the last call to `keys`, failed actions included.
+         virtual void take_written( std::vector<row_key>& keys ) = 0;
+
+         /// balance - locked - loaned - allocated of every accounts row at the current time.
+         virtual void spendables( spendable_list& out ) = 0;
+
+         /// The spendable balance of one accounts row, false when it does not exist.
+         virtual bool spendable( const balance_key& key, int64_t& amount ) = 0;
+
+         virtual void set_time( uint64_t curtime ) = 0;
+
+         /**
+          * Actions follow the contract's, authorized by `actor`. They return false, changing
+          * nothing, when the contract would reject them.
+          */
+         virtual bool create( uint64_t actor, uint64_t issuer, const asset_t& maximum_supply ) = 0;
+         virtual bool issue( uint64_t actor, uint64_t to, const asset_t& quantity ) = 0;
+         virtual bool setextime( uint64_t actor, uint64_t time, const asset_t& value ) = 0;
+         virtual bool transfer( uint64_t actor, uint64_t from, uint64_t to, const asset_t& quantity ) = 0;
+         virtual bool approve( uint64_t actor, uint64_t from, uint64_t manager, const asset_t& quantity ) = 0;
+         virtual bool loantrans( uint64_t actor, uint64_t manager, uint64_t from, uint64_t to, const asset_t& quantity,
+                                 bool bcreate ) = 0;
+         virtual bool addtknpool( uint64_t actor, uint64_t user, const asset_t& value ) = 0;
+         virtual bool addrule( uint64_t actor, uint64_t user, uint32_t lockruleid, const std::vector<uint64_t>& times,
+                               const std::vector<uint16_t>& pcts, uint32_t base, uint32_t period, const asset_t& value ) = 0;
+         virtual bool locktransfer( uint64_t actor, uint32_t lockruleid, uint64_t from, uint64_t to, const asset_t& quantity ) = 0;
+         virtual bool unlockasset( uint64_t actor, uint64_t acc, const asset_t& value ) = 0;
+   };
+
+   /**
+    * A planted divergence of the model, for `--self-test`.
+    */
+   enum class mutant {
+      none,
+      skip_auth,           //transfer does not require the sender's authority
+      spend_off_by_one,    //the encumbrance check rejects spending the whole spendable balance
+      ignore_v1_acclocks,  //locked balances miss tranches not converted yet
+      keep_acclock_time,   //adding to a tranche does not restart it
+      keep_debit_payer,    //the debited accounts row never changes payer
+      skip_loan_upgrade,   //approve leaves an old loan row in place
+   };
+
+   /// The contract in this tree, built natively.
+   std::unique_ptr<engine> make_reference_engine( const std::vector<uint64_t>& accounts );
+
+   /// The changed contract of `YOTTA_CANDIDATE_DIR`, null when the harness is built without one.
+   std::unique_ptr<engine> make_candidate_contract_engine( const std::vector<uint64_t>& accounts );
+
+   /// The independent model of `model_engine.hpp`.
+   std::unique_ptr<engine> make_model_engine( const std::vector<uint64_t>& accounts, mutant m );
+
+} /// namespace yotta::harness
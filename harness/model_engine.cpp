@@ -0,0 +1,10 @@
+#include "model_engine.hpp"
+
+namespace yotta::harness {
+
+   std::unique_ptr<engine> make_model_engine( const std::vector<uint64_t>& accounts, mutant m )
+   {
+      return std::make_unique<model_engine>( accounts, m );
+   }
+
+} /// namespace yotta::harness
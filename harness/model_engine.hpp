@@ -0,0 +1,802 @@
+#pragma once
+
+#include "engine.hpp"
+#include <functional>
+#include <limits>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+/**
+ * An independent model of the encumbrance engine, the default candidate of the harness.
+ *
+ * It follows the contract's actions check by check over typed in-memory tables, with its own
+ * lock walk, encumbrance check and serialization: only `yotta::locked_amount`, the vesting math,
+ * is shared with the contract. Writes are journaled so that a rejected action is undone, and the
+ * payer of every row is tracked. What the harness never enables is left out: the change log,
+ * checkpoints, rewards, sub-ledgers and notifications.
+ *
+ * A `mutant` other than `none` plants a known divergence, to check that the harness reports it.
+ */
+namespace yotta::harness {
+
+   /// An eosio assertion failure, which aborts the action.
+   struct check_failure : std::runtime_error {
+      using std::runtime_error::runtime_error;
+   };
+
+   inline void check( bool pred, const char* msg )
+   {
+      if ( !pred ) throw check_failure( msg );
+   }
+
+   /**
+    * Undo log of the model's writes, and the keys written.
+    */
+   class journal {
+      public:
+         void on_write( const row_key& key, std::function<void()> undo_write ) {
+            written.push_back( key );
+            undo.push_back( std::move( undo_write ) );
+         }
+
+         void on_change( std::function<void()> undo_change ) { undo.push_back( std::move( undo_change ) ); }
+
+         size_t savepoint()const { return undo.size(); }
+
+         void rollback( size_t sp ) {
+            while( undo.size() > sp ) {
+               undo.back()();
+               undo.pop_back();
+            }
+         }
+
+         void commit( size_t sp ) { undo.resize( sp ); }
+
+         std::vector<row_key> written;
+
+      private:
+         std::vector<std::function<void()>> undo;
+   };
+
+   /**
+    * The rows of one table, keyed by (scope, primary key), with their payers.
+    */
+   template<typename Row>
+   class model_table {
+      public:
+         using key = std::pair<uint64_t, uint64_t>;
+
+         struct entry {
+            uint64_t payer = 0;
+            Row      row;
+         };
+
+         using const_iterator = typename std::map<key, entry>::const_iterator;
+
+         model_table( uint64_t table, journal& j ) : table(table), j(j) {}
+
+         uint64_t name()const { return table; }
+
+         const entry* find( const key& k )const {
+            auto it = rows.find( k );
+            return it == rows.end() ? nullptr : &it->second;
+         }
+
+         const Row* row( const key& k )const {
+            auto e = find( k );
+            return e ? &e->row : nullptr;
+         }
+
+         void emplace( const key& k, uint64_t payer, Row r ) {
+            check( payer != 0, "must specify a valid account to pay for new record" );
+            check( rows.emplace( k, entry{ payer, std::move( r ) } ).second,
+                   "could not insert object, most likely a uniqueness constraint was violated" );
+            j.on_write( row_key{ table, k.first, k.second }, [this, k] { rows.erase( k ); } );
+         }
+
+         /// The row to change, billed to `payer` unless it is 0.
+         Row& modify( const key& k, uint64_t payer ) {
+            auto it = rows.find( k );
+            check( it != rows.end(), "object passed to modify is not in multi_index" );
+            j.on_write( row_key{ table, k.first, k.second }, [this, k, old = it->second] { rows[k] = old; } );
+            if ( payer ) it->second.payer = payer;
+            return it->second.row;
+         }
+
+         void erase( const key& k ) {
+            auto it = rows.find( k );
+            check( it != rows.end(), "object passed to erase is not in multi_index" );
+            j.on_write( row_key{ table, k.first, k.second }, [this, k, old = it->second] { rows[k] = old; } );
+            rows.erase( it );
+         }
+
+         const_iterator lower_bound( const key& k )const { return rows.lower_bound( k ); }
+         const_iterator end()const { return rows.end(); }
+
+         std::map<key, entry> rows;
+
+      private:
+         uint64_t table;
+         journal& j;
+   };
+
+   class model_engine : public engine {
+      public:
+         using key = std::pair<uint64_t, uint64_t>;
+
+         struct unicheck_row {
+            uint64_t             contractacc = 0;
+         };
+
+         struct stat_row {
+            asset_t              supply;
+            asset_t              max_supply;
+            uint64_t             issuer = 0;
+            uint64_t             poolsetter = 0;
+            uint64_t             unlocker = 0;
+            uint64_t             time = 0;
+            uint32_t             tokenno = 0;
+         };
+
+         struct balance_row {
+            asset_t              balance;
+         };
+
+         struct pool_row {
+            std::string          pool_name;
+            std::string          memo;
+         };
+
+         template<typename T>
+         struct rule_row {
+            std::vector<T>          times;
+            std::vector<uint16_t>   pcts;
+            uint32_t                base = 0;
+            uint32_t                period = 0;
+            std::string             desc;
+         };
+
+         struct acclock1_row {
+            asset_t              quantity;
+            uint64_t             user = 0;
+            uint64_t             time = 0;
+         };
+
+         struct acclock2_row {
+            int64_t              amount = 0;
+            uint32_t             time = 0;
+         };
+
+         struct numlock1_row {
+            asset_t              quantity;
+         };
+
+         struct numlock2_row {
+            int64_t              amount = 0;
+         };
+
+         struct loan1_row {
+            uint64_t             manager = 0;
+            asset_t              quantity;
+         };
+
+         struct loan2_row {
+            uint64_t             manager = 0;
+            int64_t              amount = 0;
+         };
+
+         model_engine( const std::vector<uint64_t>& accounts, mutant m ) : accounts( accounts.begin(), accounts.end() ), m(m)
+         {
+            this->accounts.insert( contract_account );
+            this->accounts.insert( registry_account );
+            unicheck.rows[{ contract_account, unicheck.name() }] = { contract_account, unicheck_row{ registry_account } };
+         }
+
+         void set_time( uint64_t time ) override { curtime = time; }
+
+         void load( const table_dump& tables ) override
+         {
+            each_table( []( auto& t ) { t.rows.clear(); } );
+            for( const auto& r : tables.all() ) {
+               auto [table, scope, pk] = r.key;
+               auto data = tables.data( r );
+               bool ok = false;
+               each_table( [&]( auto& t ) {
+                  if ( t.name() != table ) return;
+                  auto& e = t.rows[{ scope, pk }];
+                  e.payer = r.payer;
+                  ok = read( data.data(), data.size(), pk, e.row );
+               } );
+               if ( !ok ) throw std::invalid_argument( "malformed row in loaded tables" );
+            }
+            j.written.clear();
+         }
+
+         table_dump dump()const override
+         {
+            table_dump  out;
+            data_writer w;
+            each_table( [&]( const auto& t ) {
+               for( const auto& [k, e] : t.rows ) {
+                  size_t offset = w.size();
+                  write( w, k.second, e.row );
+                  out.add( t.name(), k.first, k.second, e.payer, w, offset );
+               }
+            } );
+            out.seal( w );
+            return out;
+         }
+
+         bool find_row( const row_key& k, uint64_t& payer, std::vector<char>& data )const override
+         {
+            auto [table, scope, pk] = k;
+            bool found = false;
+            each_table( [&]( const auto& t ) {
+               if ( t.name() != table ) return;
+               const auto* e = t.find( { scope, pk } );
+               if ( !e ) return;
+               data_writer w;
+               write( w, pk, e->row );
+               data = w.release();
+               payer = e->payer;
+               found = true;
+            } );
+            return found;
+         }
+
+         void take_written( std::vector<row_key>& keys ) override
+         {
+            keys.insert( keys.end(), j.written.begin(), j.written.end() );
+            j.written.clear();
+         }
+
+         void spendables( spendable_list& out ) override
+         {
+            out.clear();
+            for( const auto& [k, e] : balances.rows ) {
+               out.push_back( { k, spendable_of( k.first, e.row ) } );
+            }
+         }
+
+         bool spendable( const balance_key& key, int64_t& amount ) override
+         {
+            const balance_row* b = balances.row( key );
+            if ( !b ) return false;
+            amount = spendable_of( key.first, *b );
+            return true;
+         }
+
+         bool create( uint64_t actor, uint64_t issuer, const asset_t& maximum_supply ) override
+         {
+            return run( [&] {
+               uint64_t code = maximum_supply.code();
+               check( actor == issuer, "missing authority" );
+               check( valid_code( code ), "invalid symbol name" );
+               check( valid( maximum_supply ), "invalid supply" );
+               check( maximum_supply.amount > 0, "max-supply must be positive" );
+               check( !stat.find( { code, code } ), "token with symbol already exists" );
+               check( unicheck.find( { contract_account, unicheck.name() } ), "uniqueness check contract account has not benn setted" );
+               check( accounts.count( issuer ) == 1, "You need to buy a token permission." );
+               stat.emplace( { code, code }, issuer, stat_row{ asset_t{ 0, maximum_supply.symbol }, maximum_supply,
+                                                               issuer, issuer, issuer, 0, next_tokenno } );
+               j.on_change( [this, n = next_tokenno] { next_tokenno = n; } );
+               next_tokenno++;
+            } );
+         }
+
+         bool issue( uint64_t actor, uint64_t to, const asset_t& quantity ) override
+         {
+            return run( [&] {
+               uint64_t code = quantity.code();
+               check( valid_code( code ), "invalid symbol" );
+               check( accounts.count( to ) == 1, "to account does not exist" );
+               const stat_row* s = stat.row( { code, code } );
+               check( s, "token with symbol does not exist, create token before issue" );
+               check( actor == s->issuer, "missing authority" );
+               check( valid( quantity ), "invalid quantity" );
+               check( quantity.amount > 0, "must issue positive quantity" );
+               check( quantity.symbol == s->supply.symbol, "symbol or precision mismatch" );
+               check( quantity.amount <= s->max_supply.amount - s->supply.amount, "quantity exceeds available supply" );
+               uint64_t issuer = s->issuer;
+               stat.modify( { code, code }, 0 ).supply.amount += quantity.amount;
+               add_balance( to, quantity, issuer, true );
+            } );
+         }
+
+         bool setextime( uint64_t actor, uint64_t time, const asset_t& value ) override
+         {
+            return run( [&] {
+               uint64_t code = value.code();
+               check( valid_code( code ), "invalid symbol" );
+               const stat_row* s = stat.row( { code, code } );
+               check( s, "This token is not existed when setextime." );
+               check( s->time == 0, "The exchanging time has already been setted." );
+               check( actor == s->issuer, "missing authority" );
+               stat.modify( { code, code }, 0 ).time = time;
+            } );
+         }
+
+         bool transfer( uint64_t actor, uint64_t from, uint64_t to, const asset_t& quantity ) override
+         {
+            return run( [&] { do_transfer( actor, from, to, quantity ); } );
+         }
+
+         bool approve( uint64_t actor, uint64_t from, uint64_t manager, const asset_t& quantity ) override
+         {
+            return run( [&] {
+               uint64_t code = quantity.code();
+               check( valid_code( code ), "invalid symbol when approve" );
+               const stat_row* s = stat.row( { code, code } );
+               check( s, "token is not existed." );
+               check( quantity.amount > 0, "must approve positive quantity" );
+               check( quantity.symbol == s->supply.symbol, "symbol or precision mismatch" );
+               check( actor == from, "missing authority" );
+               const balance_row* acc = balances.row( { from, code } );
+               check( acc, "acc's token is not existed" );
+               int64_t lock = get_locked( from, quantity );
+
+               if ( m != mutant::skip_loan_upgrade ) upgrade_loan( code, from );
+               const loan2_row* loan = loanpool2.row( { code, from } );
+               if ( !loan ) {
+                  check( can_spend( acc->balance.amount, lock, 0, quantity.amount ), "overdrawn balance" );
+                  loanpool2.emplace( { code, from }, from, loan2_row{ manager, quantity.amount } );
+               } else {
+                  check( loan->manager == manager, "manager should be the same as before" );
+                  check( can_spend( acc->balance.amount, lock, loan->amount, quantity.amount ), "overdrawn balance" );
+                  loanpool2.modify( { code, from }, from ).amount += quantity.amount;
+               }
+            } );
+         }
+
+         bool loantrans( uint64_t actor, uint64_t manager, uint64_t from, uint64_t to, const asset_t& quantity, bool bcreate ) override
+         {
+            return run( [&] {
+               uint64_t code = quantity.code();
+               check( valid_code( code ), "invalid symbol when loantrans" );
+               check( quantity.amount > 0, "must loantrans positive quantity" );
+               check( actor == manager, "missing authority" );
+               upgrade_loan( code, from );
+               const loan2_row* loan = loanpool2.row( { code, from } );
+               check( loan, "loan is null" );
+               check( loan->amount >= quantity.amount, "overdrawn balance" );
+               check( loan->manager == manager, "only manager can loantrans" );
+               int64_t amount = loan->amount;
+
+               sub_balance( from, quantity, manager );
+               add_balance( to, quantity, manager, bcreate );
+
+               if ( amount == quantity.amount ) {
+                  loanpool2.erase( { code, from } );
+               } else {
+                  loanpool2.modify( { code, from }, 0 ).amount -= quantity.amount;
+               }
+            } );
+         }
+
+         bool addtknpool( uint64_t actor, uint64_t user, const asset_t& value ) override
+         {
+            return run( [&] {
+               uint64_t code = value.code();
+               check( valid_code( code ), "invalid symbol when addtknpool" );
+               const stat_row* s = stat.row( { code, code } );
+               check( s, "token is not existed when addtknpool" );
+               check( actor == s->poolsetter, "missing authority" );
+               check( accounts.count( user ) == 1, "Account does not exist when addtknpool" );
+               check( !tokenpool.find( { code, user } ), "user has already registered as token pool account" );
+               tokenpool.emplace( { code, user }, s->poolsetter, pool_row{} );
+            } );
+         }
+
+         bool addrule( uint64_t actor, uint64_t user, uint32_t lockruleid, const std::vector<uint64_t>& times,
+                       const std::vector<uint16_t>& pcts, uint32_t base, uint32_t period, const asset_t& value ) override
+         {
+            return run( [&] {
+               uint64_t code = value.code();
+               check( actor == user, "missing authority" );
+               check( valid_code( code ), "invalid symbol when addrule" );
+               check( tokenpool.find( { code, user } ), "is not a token pool account" );
+               check( lockruleid > 100, "lockruleid which less than 100 is reserved" );
+               check( times.size() >= 1, "invalidate size of times array" );
+               check( times.size() == pcts.size(), "times and percentage in different size." );
+               if ( times.size() == 1 ) {
+                  check( period > 0, "period must be a positive number" );
+               }
+               check( !lockrule2.find( { code, lockruleid } ), "the id already existed in rule table" );
+               check( !lockrule.find( { code, lockruleid } ), "the id already existed in rule table" );
+               for( size_t i = 0; i < times.size(); i++ ) {
+                  check( times[i] <= std::numeric_limits<uint32_t>::max(), "times is out of range" );
+                  if ( i == 0 ) {
+                     check( pcts[i] <= base, "invalidate lock percentage" );
+                  } else {
+                     check( times[i] > times[i-1], "times vector error" );
+                     check( pcts[i] > pcts[i-1] && pcts[i] <= base, "lock percentage vector error" );
+                  }
+               }
+               lockrule2.emplace( { code, lockruleid }, user,
+                                  rule_row<uint32_t>{ std::vector<uint32_t>( times.begin(), times.end() ), pcts, base, period, "" } );
+            } );
+         }
+
+         bool locktransfer( uint64_t actor, uint32_t lockruleid, uint64_t from, uint64_t to, const asset_t& quantity ) override
+         {
+            return run( [&] {
+               uint64_t code = quantity.code();
+               check( actor == from, "missing authority" );
+               check( valid_code( code ), "invalid symbol when locktransfer" );
+               check( quantity.amount > 0, "must locktransfer positive quantity" );
+               check( tokenpool.find( { code, from } ), "only token pool account can locktransfer" );
+               do_transfer( actor, from, to, quantity );
+               add_lock( from, to, quantity, lockruleid );
+            } );
+         }
+
+         bool unlockasset( uint64_t actor, uint64_t acc, const asset_t& value ) override
+         {
+            return run( [&] {
+               uint64_t code = value.code();
+               check( valid_code( code ), "invalid symbol when unlockasset" );
+               check( value.amount >= 0, "cannot lock negative quantity" );
+               const stat_row* s = stat.row( { code, code } );
+               check( s, "token is not existed when unlockasset" );
+               check( actor == s->unlocker, "missing authority" );
+               check( balances.find( { acc, code } ), "Account does not have this token" );
+               upgrade_numlock( code, acc );
+               const numlock2_row* n = numlock2.row( { code, acc } );
+               check( n, "lockasset isn't existed" );
+               check( n->amount >= value.amount, "locking asset should less than before" );
+               if ( n->amount == value.amount ) {
+                  numlock2.erase( { code, acc } );
+               } else {
+                  numlock2.modify( { code, acc }, s->unlocker ).amount -= value.amount;
+               }
+            } );
+         }
+
+      private:
+         static constexpr int64_t max_amount = ( 1LL << 62 ) - 1;
+
+         /// 1 to 7 upper case letters.
+         static bool valid_code( uint64_t code ) {
+            if ( code == 0 || ( code >> 56 ) != 0 ) return false;
+            for( ; code; code >>= 8 ) {
+               char c = (char)( code & 0xff );
+               if ( c < 'A' || c > 'Z' ) return false;
+            }
+            return true;
+         }
+
+         static bool valid( const asset_t& a ) {
+            return -max_amount <= a.amount && a.amount <= max_amount && valid_code( a.code() );
+         }
+
+         bool can_spend( int64_t balance, int64_t lock, int64_t reserved, int64_t amount )const {
+            if ( m == mutant::spend_off_by_one ) return balance - lock - reserved > amount;
+            return balance - lock - reserved >= amount;
+         }
+
+         template<typename F>
+         bool run( F&& f ) {
+            size_t sp = j.savepoint();
+            try {
+               f();
+               j.commit( sp );
+               return true;
+            } catch( const check_failure& ) {
+               j.rollback( sp );
+               return false;
+            }
+         }
+
+         template<typename F>
+         void each_table( F&& f ) {
+            f( unicheck ); f( stat ); f( balances ); f( tokenpool ); f( lockrule ); f( lockrule2 );
+            f( acclock ); f( acclock2 ); f( numlock ); f( numlock2 ); f( loanpool ); f( loanpool2 );
+         }
+
+         template<typename F>
+         void each_table( F&& f )const {
+            const_cast<model_engine*>( this )->each_table( [&]( const auto& t ) { f( t ); } );
+         }
+
+         void do_transfer( uint64_t actor, uint64_t from, uint64_t to, const asset_t& quantity ) {
+            uint64_t code = quantity.code();
+            check( from != to, "cannot transfer to self" );
+            check( accounts.count( to ) == 1, "to account does not exist" );
+            check( valid_code( code ), "invalid symbol when transfer" );
+            const stat_row* s = stat.row( { code, code } );
+            check( s, "token is not existed." );
+            check( m == mutant::skip_auth || actor == from, "missing authority" );
+            check( valid( quantity ), "invalid quantity" );
+            check( quantity.amount > 0, "must transfer positive quantity" );
+            check( quantity.symbol == s->supply.symbol, "symbol or precision mismatch" );
+            sub_balance( from, quantity, from );
+            add_balance( to, quantity, from, true );
+         }
+
+         void sub_balance( uint64_t owner, const asset_t& value, uint64_t ram_payer ) {
+            const balance_row* acc = balances.row( { owner, value.code() } );
+            check( acc, "Payer's token is not existed" );
+            int64_t lock = get_locked( owner, value );
+            check( can_spend( acc->balance.amount, lock, loaned( owner, value.code() ), value.amount ), "overdrawn balance" );
+            check( acc->balance.symbol == value.symbol, "attempt to subtract asset with different symbol" );
+            bool owner_pays = owner == ram_payer && m != mutant::keep_debit_payer;
+            balances.modify( { owner, value.code() }, owner_pays ? owner : 0 ).balance.amount -= value.amount;
+         }
+
+         void add_balance( uint64_t owner, const asset_t& value, uint64_t ram_payer, bool bcreate ) {
+            if ( balances.find( { owner, value.code() } ) ) {
+               balances.modify( { owner, value.code() }, 0 ).balance.amount += value.amount;
+            } else {
+               check( bcreate, "Payee's token is not existed" );
+               balances.emplace( { owner, value.code() }, ram_payer, balance_row{ value } );
+            }
+         }
+
+         int64_t get_locked( uint64_t user, const asset_t& value ) {
+            const stat_row* s = stat.row( { value.code(), value.code() } );
+            check( s, "token is not existed" );
+            check( value.symbol == s->supply.symbol, "symbol or precision mismatch" );
+            return locked( user, *s );
+         }
+
+         int64_t spendable_of( uint64_t owner, const balance_row& b )const {
+            uint64_t code = b.balance.code();
+            const stat_row* s = stat.row( { code, code } );
+            if ( !s ) throw std::logic_error( "a balance of a token which does not exist" );
+            return b.balance.amount - locked( owner, *s ) - loaned( owner, code );
+         }
+
+         /// numlock plus the locked part of every acclock tranche of the token.
+         int64_t locked( uint64_t user, const stat_row& s )const {
+            uint64_t code = s.supply.code();
+            int64_t  total = 0;
+            if ( const numlock2_row* n = numlock2.row( { code, user } ) ) {
+               total = n->amount;
+            } else if ( const numlock1_row* n1 = numlock.row( { code, user } ) ) {
+               total = n1->quantity.amount;
+            }
+
+            uint64_t prefix = (uint64_t)s.tokenno << 32;
+            for( auto it = acclock2.lower_bound( { user, prefix } );
+                 it != acclock2.end() && it->first.first == user && ( it->first.second >> 32 ) == s.tokenno; ++it ) {
+               total += tranche_locked( s, it->first.second, it->second.row.amount );
+            }
+            if ( m != mutant::ignore_v1_acclocks ) {
+               for( auto it = acclock.lower_bound( { user, 0 } ); it != acclock.end() && it->first.first == user; ++it ) {
+                  if ( it->second.row.quantity.code() == code ) total += tranche_locked( s, it->first.second, it->second.row.quantity.amount );
+               }
+            }
+            return total;
+         }
+
+         /// A tranche of a rule which does not exist stays locked.
+         int64_t tranche_locked( const stat_row& s, uint64_t no_ruleid, int64_t amount )const {
+            uint64_t code = s.supply.code();
+            uint32_t lockruleid = (uint32_t)no_ruleid;
+            if ( const auto* r = lockrule2.row( { code, lockruleid } ) ) {
+               return locked_amount( amount, s.time, curtime, r->times, r->pcts, r->base, r->period );
+            }
+            if ( const auto* r = lockrule.row( { code, lockruleid } ) ) {
+               return locked_amount( amount, s.time, curtime, r->times, r->pcts, r->base, r->period );
+            }
+            return amount;
+         }
+
+         int64_t loaned( uint64_t from, uint64_t code )const {
+            if ( const loan2_row* loan = loanpool2.row( { code, from } ) ) return loan->amount;
+            if ( const loan1_row* loan = loanpool.row( { code, from } ) ) return loan->quantity.amount;
+            return 0;
+         }
+
+         void add_lock( uint64_t ram_payer, uint64_t to, const asset_t& quantity, uint32_t lockruleid ) {
+            uint64_t code = quantity.code();
+            if ( lockruleid == 0 ) {
+               upgrade_numlock( code, to );
+               if ( numlock2.find( { code, to } ) ) {
+                  numlock2.modify( { code, to }, ram_payer ).amount += quantity.amount;
+               } else {
+                  numlock2.emplace( { code, to }, ram_payer, numlock2_row{ quantity.amount } );
+               }
+               return;
+            }
+            check( lockrule2.find( { code, lockruleid } ) || lockrule.find( { code, lockruleid } ),
+                   "lockruleid not existed in rule table" );
+            const stat_row* s = stat.row( { code, code } );
+            check( s, "token is not existed" );
+            uint64_t prefix = (uint64_t)s->tokenno << 32;
+            uint64_t no_ruleid = prefix + lockruleid;
+            upgrade_acclock( code, to );
+
+            size_t rules_no = 0;
+            for( auto it = acclock2.lower_bound( { to, prefix } );
+                 it != acclock2.end() && it->first.first == to && ( it->first.second >> 32 ) == s->tokenno; ++it ) {
+               rules_no++;
+               if ( it->first.second == no_ruleid ) {
+                  auto& r = acclock2.modify( it->first, 0 );
+                  if ( m != mutant::keep_acclock_time ) r.time = (uint32_t)curtime;
+                  r.amount += quantity.amount;
+                  return;
+               }
+            }
+            check( rules_no <= 100, "lock rules of account is too many" );
+            acclock2.emplace( { to, no_ruleid }, ram_payer, acclock2_row{ quantity.amount, (uint32_t)curtime } );
+         }
+
+         void upgrade_numlock( uint64_t code, uint64_t user ) {
+            const numlock1_row* old = numlock.row( { code, user } );
+            if ( !old ) return;
+            numlock2.emplace( { code, user }, contract_account, numlock2_row{ old->quantity.amount } );
+            numlock.erase( { code, user } );
+         }
+
+         void upgrade_loan( uint64_t code, uint64_t from ) {
+            const loan1_row* old = loanpool.row( { code, from } );
+            if ( !old ) return;
+            loanpool2.emplace( { code, from }, contract_account, loan2_row{ old->manager, old->quantity.amount } );
+            loanpool.erase( { code, from } );
+         }
+
+         void upgrade_acclock( uint64_t code, uint64_t user ) {
+            std::vector<key> moved;
+            for( auto it = acclock.lower_bound( { user, 0 } ); it != acclock.end() && it->first.first == user; ++it ) {
+               if ( it->second.row.quantity.code() == code ) moved.push_back( it->first );
+            }
+            for( const auto& k : moved ) {
+               const acclock1_row old = *acclock.row( k );
+               if ( acclock2.find( k ) ) {
+                  acclock2.modify( k, 0 ).amount += old.quantity.amount;
+               } else {
+                  acclock2.emplace( k, contract_account, acclock2_row{ old.quantity.amount, (uint32_t)old.time } );
+               }
+               acclock.erase( k );
+            }
+         }
+
+         /// Row serialization, in the field order of `yotta.token.hpp`.
+
+         static void write( data_writer& w, uint64_t, const unicheck_row& r ) { w.write( r.contractacc ); }
+
+         static void write( data_writer& w, uint64_t, const stat_row& r ) {
+            w.write_asset( r.supply ).write_asset( r.max_supply ).write( r.issuer ).write( r.poolsetter )
+             .write( r.unlocker ).write( r.time ).write( r.tokenno );
+         }
+
+         static void write( data_writer& w, uint64_t, const balance_row& r ) { w.write_asset( r.balance ); }
+
+         static void write( data_writer& w, uint64_t user, const pool_row& r ) {
+            w.write( user ).write_string( r.pool_name ).write_string( r.memo );
+         }
+
+         template<typename T>
+         static void write( data_writer& w, uint64_t lockruleid, const rule_row<T>& r ) {
+            w.write( (uint32_t)lockruleid ).write_array( r.times ).write_array( r.pcts ).write( r.base )
+             .write( r.period ).write_string( r.desc );
+         }
+
+         static void write( data_writer& w, uint64_t no_ruleid, const acclock1_row& r ) {
+            w.write( no_ruleid ).write_asset( r.quantity ).write( r.user ).write( r.time );
+         }
+
+         static void write( data_writer& w, uint64_t no_ruleid, const acclock2_row& r ) {
+            w.write( no_ruleid ).write( r.amount ).write( r.time );
+         }
+
+         static void write( data_writer& w, uint64_t user, const numlock1_row& r ) { w.write( user ).write_asset( r.quantity ); }
+         static void write( data_writer& w, uint64_t user, const numlock2_row& r ) { w.write( user ).write( r.amount ); }
+
+         static void write( data_writer& w, uint64_t from, const loan1_row& r ) {
+            w.write( from ).write( r.manager ).write_asset( r.quantity );
+         }
+
+         static void write( data_writer& w, uint64_t from, const loan2_row& r ) {
+            w.write( from ).write( r.manager ).write( r.amount );
+         }
+
+         /// Row decoding, true when `data` is exactly one row with primary key `pk`.
+
+         static bool read( const char* data, size_t size, uint64_t pk, unicheck_row& r ) {
+            row_reader rd( data, size );
+            r.contractacc = rd.read<uint64_t>();
+            return rd.done() && pk == unicheck_table;
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, stat_row& r ) {
+            currency_stat_row s;
+            if ( !decode( data, size, s ) ) return false;
+            r = stat_row{ s.supply, s.max_supply, s.issuer, s.poolsetter, s.unlocker, s.time, s.tokenno };
+            return pk == s.max_supply.code();
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, balance_row& r ) {
+            account_row a;
+            if ( !decode( data, size, a ) ) return false;
+            r.balance = a.balance;
+            return pk == a.balance.code();
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, pool_row& r ) {
+            tokenpool_row p;
+            if ( !decode( data, size, p ) ) return false;
+            r = pool_row{ std::string( p.pool_name ), std::string( p.memo ) };
+            return pk == p.user;
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, rule_row<uint64_t>& r ) {
+            lockrule_row l;
+            if ( !decode( data, size, l ) ) return false;
+            r = rule_row<uint64_t>{ l.times.to_vector(), l.pcts.to_vector(), l.base, l.period, std::string( l.desc ) };
+            return pk == l.lockruleid;
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, rule_row<uint32_t>& r ) {
+            lockrule2_row l;
+            if ( !decode( data, size, l ) ) return false;
+            r = rule_row<uint32_t>{ l.times.to_vector(), l.pcts.to_vector(), l.base, l.period, std::string( l.desc ) };
+            return pk == l.lockruleid;
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, acclock1_row& r ) {
+            acclock_row l;
+            if ( !decode( data, size, l ) ) return false;
+            r = acclock1_row{ l.quantity, l.user, l.time };
+            return pk == l.no_ruleid;
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, acclock2_row& r ) {
+            acclock_row l;
+            if ( !decode_acclock2( data, size, 0, l ) ) return false;
+            r = acclock2_row{ l.quantity.amount, (uint32_t)l.time };
+            return pk == l.no_ruleid;
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, numlock1_row& r ) {
+            numlock_row n;
+            if ( !decode( data, size, n ) ) return false;
+            r.quantity = n.quantity;
+            return pk == n.user;
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, numlock2_row& r ) {
+            numlock_row n;
+            if ( !decode_numlock2( data, size, 0, n ) ) return false;
+            r.amount = n.quantity.amount;
+            return pk == n.user;
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, loan1_row& r ) {
+            loanpool_row l;
+            if ( !decode( data, size, l ) ) return false;
+            r = loan1_row{ l.manager, l.quantity };
+            return pk == l.from;
+         }
+
+         static bool read( const char* data, size_t size, uint64_t pk, loan2_row& r ) {
+            loanpool_row l;
+            if ( !decode_loanpool2( data, size, 0, l ) ) return false;
+            r = loan2_row{ l.manager, l.quantity.amount };
+            return pk == l.from;
+         }
+
+         journal                        j;
+         model_table<unicheck_row>      unicheck{ unicheck_table, j };
+         model_table<stat_row>          stat{ stat_table, j }; //scope and key: symbol code
+         model_table<balance_row>       balances{ accounts_table, j }; //owner, symbol code
+         model_table<pool_row>          tokenpool{ tokenpool_table, j }; //symbol code, user
+         model_table<rule_row<uint64_t>> lockrule{ lockrule_table, j }; //symbol code, lockruleid
+         model_table<rule_row<uint32_t>> lockrule2{ lockrule2_table, j };
+         model_table<acclock1_row>      acclock{ acclock_table, j }; //user, no_ruleid
+         model_table<acclock2_row>      acclock2{ acclock2_table, j };
+         model_table<numlock1_row>      numlock{ numlock_table, j }; //symbol code, user
+         model_table<numlock2_row>      numlock2{ numlock2_table, j };
+         model_table<loan1_row>         loanpool{ loanpool_table, j }; //symbol code, from
+         model_table<loan2_row>         loanpool2{ loanpool2_table, j };
+
+         std::set<uint64_t>   accounts; //which exist, each with a token permission
+         mutant               m;
+         uint64_t             curtime = 0;
+         uint32_t             next_tokenno = 1;
+   };
+
+} /// namespace yotta::harness
@@ -0,0 +1,15 @@
+#include "contract_engine.hpp"
+
+/// The contract's private helpers are read by `contract_engine::spendables`.
+#define private public
+#include <yotta.token.cpp>
+#undef private
+
+namespace yotta::harness {
+
+   std::unique_ptr<engine> make_reference_engine( const std::vector<uint64_t>& accounts )
+   {
+      return std::make_unique<contract_engine<yottatoken>>( accounts );
+   }
+
+} /// namespace yotta::harness
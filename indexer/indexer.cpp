@@ -0,0 +1,161 @@
+#include "pipeline.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+
+/**
+ * Indexer of the yotta.token tables from the state history of a node.
+ *
+ * It follows the stat, accounts, tokenpool, lockrule, acclock, numlock and loanpool tables, v1
+ * and v2, and the sub-ledgers, decoding the deltas of each block on `--workers` threads into an
+ * embedded store (`token_store.hpp`) that keeps spendable balances queryable at any time with
+ * the vesting walk of `get_lock_asset`. Forks are undone through the store's undo state.
+ *
+ * The stream comes from a node with `--connect` or from a file recorded with `--record` through
+ * `--replay`. `--state` loads the store when the file exists, saves it every `--save-every`
+ * blocks and on exit, and resumes the stream after its last block. `--holders` writes every
+ * balance as CSV on exit, at `--time` or else the time of the last block.
+ *
+ * Usage: indexer --connect HOST:PORT | --replay FILE [--contract NAME] [--workers N]
+ *                [--start-block N] [--end-block N] [--irreversible-only] [--record FILE]
+ *                [--state FILE] [--save-every N] [--holders FILE] [--time SECONDS]
+ *
+ * The node must keep the state history since the contract was deployed, or the store must be
+ * loaded from a state taken since. SIGINT and SIGTERM stop at the next block, saving the state.
+ */
+using namespace yotta;
+using namespace yotta::indexer;
+
+namespace {
+
+   message_source* volatile active_source = nullptr;
+
+   void on_signal( int )
+   {
+      if ( active_source ) active_source->interrupt();
+   }
+
+   bool file_exists( const std::string& path )
+   {
+      struct stat st;
+      return ::stat( path.c_str(), &st ) == 0;
+   }
+
+} /// namespace
+
+int main( int argc, char** argv )
+{
+   std::string connect;
+   std::string replay;
+   std::string record;
+   std::string state;
+   std::string holders;
+   uint64_t    contract = string_to_name( "yotta.token" );
+   unsigned    workers = 4;
+   uint32_t    start_block = 0;
+   uint32_t    end_block = 0xffffffff;
+   uint32_t    save_every = 0;
+   uint64_t    at_time = 0;
+   bool        irreversible_only = false;
+   for( int i = 1; i < argc; i++ ) {
+      bool has_value = i + 1 < argc;
+      if ( std::strcmp( argv[i], "--connect" ) == 0 && has_value ) {
+         connect = argv[++i];
+      } else if ( std::strcmp( argv[i], "--replay" ) == 0 && has_value ) {
+         replay = argv[++i];
+      } else if ( std::strcmp( argv[i], "--contract" ) == 0 && has_value ) {
+         contract = string_to_name( argv[++i] );
+      } else if ( std::strcmp( argv[i], "--workers" ) == 0 && has_value ) {
+         workers = (unsigned)std::strtoul( argv[++i], nullptr, 10 );
+      } else if ( std::strcmp( argv[i], "--start-block" ) == 0 && has_value ) {
+         start_block = (uint32_t)std::strtoul( argv[++i], nullptr, 10 );
+      } else if ( std::strcmp( argv[i], "--end-block" ) == 0 && has_value ) {
+         end_block = (uint32_t)std::strtoul( argv[++i], nullptr, 10 );
+      } else if ( std::strcmp( argv[i], "--irreversible-only" ) == 0 ) {
+         irreversible_only = true;
+      } else if ( std::strcmp( argv[i], "--record" ) == 0 && has_value ) {
+         record = argv[++i];
+      } else if ( std::strcmp( argv[i], "--state" ) == 0 && has_value ) {
+         state = argv[++i];
+      } else if ( std::strcmp( argv[i], "--save-every" ) == 0 && has_value ) {
+         save_every = (uint32_t)std::strtoul( argv[++i], nullptr, 10 );
+      } else if ( std::strcmp( argv[i], "--holders" ) == 0 && has_value ) {
+         holders = argv[++i];
+      } else if ( std::strcmp( argv[i], "--time" ) == 0 && has_value ) {
+         at_time = std::strtoull( argv[++i], nullptr, 10 );
+      } else {
+         connect.clear();
+         replay.clear();
+         break;
+      }
+   }
+   if ( connect.empty() == replay.empty() ) {
+      std::fprintf( stderr, "usage: %s --connect HOST:PORT | --replay FILE [--contract NAME] [--workers N]\n"
+                            "          [--start-block N] [--end-block N] [--irreversible-only] [--record FILE]\n"
+                            "          [--state FILE] [--save-every N] [--holders FILE] [--time SECONDS]\n", argv[0] );
+      return 2;
+   }
+
+   try {
+      token_store store;
+      if ( !state.empty() && file_exists( state ) ) store.load( state );
+      ship::block_position resume_after = store.head();
+      if ( resume_after.block_num > 0 ) start_block = resume_after.block_num + 1;
+
+      pipeline p( store, contract, workers );
+      std::unique_ptr<message_source> source;
+      if ( !replay.empty() ) {
+         source = std::make_unique<replay_source>( replay, start_block, resume_after );
+      } else {
+         auto colon = connect.rfind( ':' );
+         if ( colon == std::string::npos ) throw std::runtime_error( "--connect needs HOST:PORT" );
+         auto client = std::make_unique<ship_client>( connect.substr( 0, colon ),
+                                                      (uint16_t)std::strtoul( connect.c_str() + colon + 1, nullptr, 10 ) );
+         ship::get_blocks_request r;
+         r.start_block_num = start_block;
+         r.end_block_num = end_block;
+         r.max_messages_in_flight = p.window_size();
+         r.have_positions = store.reversible_blocks();
+         r.irreversible_only = irreversible_only;
+         client->request( r );
+         source = std::move( client );
+      }
+      std::unique_ptr<recorder> rec;
+      if ( !record.empty() ) rec = std::make_unique<recorder>( record );
+
+      active_source = source.get();
+      std::signal( SIGINT, on_signal );
+      std::signal( SIGTERM, on_signal );
+
+      uint32_t first = 0;
+      auto begin = std::chrono::steady_clock::now();
+      auto stats = p.run( *source, rec.get(), end_block, [&]( const block_update& b ) {
+         if ( !first ) first = b.block.block_num;
+         if ( save_every && !state.empty() && b.block.block_num % save_every == 0 ) store.save( state );
+      } );
+      double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+      active_source = nullptr;
+
+      if ( !state.empty() ) store.save( state );
+      if ( !holders.empty() ) {
+         std::ofstream out( holders );
+         write_holders_csv( store, at_time ? at_time : store.head_time(), out );
+         if ( !out.flush() ) throw std::runtime_error( "cannot write " + holders );
+      }
+
+      std::printf( "blocks %u-%u: %llu blocks, %llu rows, %zu stored, %.1f s, %.0f blocks per second\n",
+                   first, store.head().block_num, (unsigned long long)stats.blocks, (unsigned long long)stats.rows,
+                   store.size(), seconds, seconds > 0 ? stats.blocks / seconds : 0.0 );
+      return 0;
+   } catch( const std::exception& e ) {
+      std::fprintf( stderr, "%s\n", e.what() );
+      return 1;
+   }
+}
@@ -0,0 +1,714 @@
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <netinet/in.h>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * Tests of the indexer against generated state history streams.
+ *
+ * A generated chain writes random rows of the followed tables, rows of another contract and of
+ * other tables, and forks now and then. Its stream is replayed from a recording with several
+ * worker counts, served over a websocket by a minimal state history server, and resumed from a
+ * store saved in the middle of a fork; each time the store must end with exactly the rows of the
+ * canonical chain. Holder balances of hand-written rows are checked against values worked out by
+ * hand, and malformed rows and forks past the irreversible block must fail.
+ *
+ * Usage: indexer_test [--seed N] [--blocks N]
+ */
+using namespace yotta;
+using namespace yotta::indexer;
+
+namespace {
+
+   constexpr uint64_t contract       = string_to_name( "yotta.token" );
+   constexpr uint64_t other_contract = string_to_name( "other.token" );
+   constexpr uint32_t lib_lag        = 4; //blocks between the head and the last irreversible block
+   constexpr uint32_t base_time      = 1600000000;
+
+   constexpr uint64_t stat_table      = string_to_name( "stat" );
+   constexpr uint64_t accounts_table  = string_to_name( "accounts" );
+   constexpr uint64_t tokenpool_table = string_to_name( "tokenpool" );
+   constexpr uint64_t lockrule_table  = string_to_name( "lockrule" );
+   constexpr uint64_t lockrule2_table = string_to_name( "lockrule2" );
+   constexpr uint64_t acclock_table   = string_to_name( "acclock" );
+   constexpr uint64_t acclock2_table  = string_to_name( "acclock2" );
+   constexpr uint64_t numlock_table   = string_to_name( "numlock" );
+   constexpr uint64_t numlock2_table  = string_to_name( "numlock2" );
+   constexpr uint64_t loanpool_table  = string_to_name( "loanpool" );
+   constexpr uint64_t loanpool2_table = string_to_name( "loanpool2" );
+   constexpr uint64_t subledger_table = string_to_name( "subledger" );
+   constexpr uint64_t tokeninfo_table = string_to_name( "tokeninfo" ); //not followed
+
+   using row_map = std::map<row_key, stored_row>;
+
+   std::string key_string( const row_key& key ) {
+      return name_to_string( std::get<0>( key ) ) + " " + name_to_string( std::get<1>( key ) ) + " "
+             + std::to_string( std::get<2>( key ) );
+   }
+
+   row_map rows_of( const token_store& store ) {
+      row_map rows;
+      store.each_row( [&]( const row_key& key, const stored_row& row ) { rows.emplace( key, row ); } );
+      return rows;
+   }
+
+   /// Empty when the store has exactly `expected`.
+   std::string compare_rows( const token_store& store, const row_map& expected ) {
+      row_map actual = rows_of( store );
+      for( const auto& [key, row] : expected ) {
+         auto it = actual.find( key );
+         if ( it == actual.end() ) return "missing row " + key_string( key );
+         if ( !( it->second == row ) ) return "different row " + key_string( key );
+      }
+      for( const auto& [key, row] : actual ) {
+         if ( !expected.count( key ) ) return "extra row " + key_string( key );
+      }
+      return {};
+   }
+
+   ship::block_position position( uint32_t block_num, uint8_t branch ) {
+      ship::block_position p;
+      p.block_num = block_num;
+      std::memcpy( p.block_id.data(), &block_num, sizeof(block_num) );
+      p.block_id[4] = branch;
+      return p;
+   }
+
+   /// A packed block whose header starts with the timestamp of `time`, the rest left out.
+   std::vector<char> block_header( uint32_t time ) {
+      return data_writer().write<uint32_t>( ( time - ship::block_timestamp_epoch ) * 2 ).write( contract ).release();
+   }
+
+   std::vector<char> block_message( const ship::block_position& block, uint32_t time, uint32_t lib,
+                                    const std::vector<ship::contract_row>& rows, bool noise ) {
+      ship::delta_writer deltas;
+      if ( noise ) deltas.add_row( "account", true, "not a contract row" );
+      for( const auto& r : rows ) deltas.add_contract_row( r );
+      auto packed = deltas.release();
+      auto header = block_header( time );
+
+      ship::blocks_result r;
+      r.head = block;
+      r.last_irreversible = position( lib, 0 );
+      r.this_block = block;
+      if ( block.block_num > 1 ) r.prev_block = position( block.block_num - 1, 0 );
+      r.block = std::string_view( header.data(), header.size() );
+      r.deltas = std::string_view( packed.data(), packed.size() );
+      return ship::pack_result( r );
+   }
+
+   ship::contract_row contract_row( uint64_t code, uint64_t table, uint64_t scope, uint64_t pk, bool present,
+                                    const std::vector<char>& value ) {
+      ship::contract_row r;
+      r.present = present;
+      r.code = code;
+      r.scope = scope;
+      r.table = table;
+      r.primary_key = pk;
+      r.payer = present ? scope : 0;
+      r.value = std::string_view( value.data(), value.size() );
+      return r;
+   }
+
+   /**
+    * A random chain of the followed tables, with its stream and the rows its canonical blocks
+    * leave.
+    */
+   struct generated_chain {
+      std::vector<std::vector<char>>   messages;
+      row_map                          rows;
+      uint32_t                         head = 0;
+      uint32_t                         first_fork = 0; //number of the first block replaced by a fork
+   };
+
+   class chain_generator {
+      public:
+         explicit chain_generator( uint64_t seed ) : rng(seed) {
+            for( const char* n : { "alice", "bob", "carol", "dave", "erin", "frank" } ) owners.push_back( string_to_name( n ) );
+            for( const char* c : { "AAA", "BBB", "CCC" } ) codes.push_back( string_to_symbol( 4, c ) >> 8 );
+         }
+
+         generated_chain generate( uint32_t blocks ) {
+            generated_chain chain;
+            {
+               //a result without a block, as sent when the requested range is done
+               ship::blocks_result r;
+               chain.messages.push_back( ship::pack_result( r ) );
+            }
+            for( uint32_t n = 1; n <= blocks; n++ ) {
+               if ( n > lib_lag + 1 && n + 3 < blocks && pick( 15 ) == 0 ) {
+                  if ( !chain.first_fork ) chain.first_fork = n;
+                  row_map fork = chain.rows;
+                  uint32_t depth = 1 + (uint32_t)pick( lib_lag - 1 );
+                  for( uint32_t k = 0; k < depth; k++ ) add_block( chain, fork, n + k, 1, 1 + pick( 12 ) );
+               }
+               add_block( chain, chain.rows, n, 0, n == 5 ? 0 : pick( 20 ) );
+               if ( n == 5 ) add_pool_rows( chain, n ); //one message over 64 KiB
+            }
+            chain.head = blocks;
+            return chain;
+         }
+
+      private:
+         uint64_t pick( uint64_t n ) { return n ? rng() % n : 0; }
+
+         uint64_t owner() { return owners[pick( owners.size() )]; }
+         uint64_t code() { return codes[pick( codes.size() )]; }
+         uint64_t symbol( uint64_t c ) { return ( c << 8 ) | 4; }
+         uint32_t tokenno( uint64_t c ) { return 1 + (uint32_t)( std::find( codes.begin(), codes.end(), c ) - codes.begin() ); }
+         uint32_t rule() { return 101 + (uint32_t)pick( 3 ); }
+         int64_t  amount() { return (int64_t)pick( 100000 ); }
+
+         /// A random key of a followed table and a value of its row.
+         std::pair<row_key, std::vector<char>> random_row() {
+            data_writer w;
+            uint64_t c = code();
+            switch( pick( 12 ) ) {
+               case 0: {
+                  w.write_asset( { amount(), symbol( c ) } ).write_asset( { 1000000000, symbol( c ) } );
+                  w.write( owner() ).write( owner() ).write( owner() ).write<uint64_t>( base_time + pick( 1000 ) ).write( tokenno( c ) );
+                  return { { stat_table, c, c }, w.release() };
+               }
+               case 1: case 2: {
+                  uint64_t o = owner();
+                  w.write_asset( { amount(), symbol( c ) } );
+                  return { { accounts_table, o, c }, w.release() };
+               }
+               case 3: {
+                  uint64_t u = owner();
+                  w.write( u ).write_string( "pool" ).write_string( "memo" );
+                  return { { tokenpool_table, c, u }, w.release() };
+               }
+               case 4: {
+                  uint32_t id = rule();
+                  w.write( id ).write_array( std::vector<uint64_t>{ pick( 100 ), 100 + pick( 100 ) } );
+                  w.write_array( std::vector<uint16_t>{ 30, 100 } ).write<uint32_t>( 100 ).write<uint32_t>( 0 ).write_string( "v1" );
+                  return { { lockrule_table, c, id }, w.release() };
+               }
+               case 5: {
+                  uint32_t id = rule();
+                  w.write( id ).write_array( std::vector<uint32_t>{ (uint32_t)pick( 50 ) } );
+                  w.write_array( std::vector<uint16_t>{ 10 } ).write<uint32_t>( 100 ).write<uint32_t>( 10 ).write_string( "v2" );
+                  return { { lockrule2_table, c, id }, w.release() };
+               }
+               case 6: {
+                  uint64_t o = owner();
+                  uint64_t id = pick( 4 );
+                  w.write( id ).write_asset( { amount(), symbol( c ) } ).write( o ).write<uint64_t>( base_time );
+                  return { { acclock_table, o, id }, w.release() };
+               }
+               case 7: {
+                  uint64_t o = owner();
+                  uint64_t no_ruleid = ( (uint64_t)tokenno( c ) << 32 ) + rule();
+                  w.write( no_ruleid ).write( amount() ).write<uint32_t>( base_time );
+                  return { { acclock2_table, o, no_ruleid }, w.release() };
+               }
+               case 8: {
+                  uint64_t o = owner();
+                  w.write( o ).write_asset( { amount(), symbol( c ) } );
+                  return { { numlock_table, c, o }, w.release() };
+               }
+               case 9: {
+                  uint64_t o = owner();
+                  w.write( o ).write( amount() );
+                  return { { numlock2_table, c, o }, w.release() };
+               }
+               case 10: {
+                  uint64_t o = owner();
+                  if ( pick( 2 ) ) {
+                     w.write( o ).write( owner() ).write_asset( { amount(), symbol( c ) } );
+                     return { { loanpool_table, c, o }, w.release() };
+                  }
+                  w.write( o ).write( owner() ).write( amount() );
+                  return { { loanpool2_table, c, o }, w.release() };
+               }
+               default: {
+                  uint64_t o = owner();
+                  w.write( o ).write( amount() );
+                  return { { subledger_table, c, o }, w.release() };
+               }
+            }
+         }
+
+         /**
+          * Appends block `n` of `branch` with `changes` random writes to `state`, removing a third
+          * of the rows that exist, and rows that must be ignored.
+          */
+         void add_block( generated_chain& chain, row_map& state, uint32_t n, uint8_t branch, uint64_t changes ) {
+            std::vector<std::vector<char>>   values; //owned by the block
+            std::vector<ship::contract_row>  rows;
+            values.reserve( changes + 2 );
+            for( uint64_t i = 0; i < changes; i++ ) {
+               auto [key, value] = random_row();
+               auto [table, scope, pk] = key;
+               auto it = state.find( key );
+               if ( it != state.end() && pick( 3 ) == 0 ) {
+                  values.push_back( it->second.value );
+                  rows.push_back( contract_row( contract, table, scope, pk, false, values.back() ) );
+                  state.erase( it );
+               } else {
+                  values.push_back( std::move( value ) );
+                  rows.push_back( contract_row( contract, table, scope, pk, true, values.back() ) );
+                  state[key] = stored_row{ scope, values.back() };
+               }
+            }
+            values.push_back( { 'x' } ); //not rows of followed tables, never decoded
+            rows.push_back( contract_row( other_contract, accounts_table, owner(), code(), true, values.back() ) );
+            rows.push_back( contract_row( contract, tokeninfo_table, contract, n, true, values.back() ) );
+
+            chain.messages.push_back( block_message( position( n, branch ), base_time + n, n > lib_lag ? n - lib_lag : 0,
+                                                     rows, branch == 0 ) );
+         }
+
+         /// Block `n` again, as a fork of itself, with many tokenpool rows.
+         void add_pool_rows( generated_chain& chain, uint32_t n ) {
+            std::vector<std::vector<char>>   values;
+            std::vector<ship::contract_row>  rows;
+            values.reserve( 4000 );
+            for( uint64_t user = 1; user <= 4000; user++ ) {
+               values.push_back( data_writer().write( user ).write_string( "pool" ).write_string( "a longer memo" ).release() );
+               rows.push_back( contract_row( contract, tokenpool_table, codes[0], user, true, values.back() ) );
+               chain.rows[{ tokenpool_table, codes[0], user }] = stored_row{ codes[0], values.back() };
+            }
+            chain.messages.push_back( block_message( position( n, 2 ), base_time + n, n - lib_lag, rows, false ) );
+         }
+
+         std::mt19937_64         rng;
+         std::vector<uint64_t>   owners;
+         std::vector<uint64_t>   codes;
+   };
+
+   class vector_source : public message_source {
+      public:
+         explicit vector_source( std::vector<std::vector<char>> messages ) : messages(std::move( messages )) {}
+
+         bool next( std::vector<char>& msg ) override {
+            if ( pos == messages.size() ) return false;
+            msg = messages[pos++];
+            return true;
+         }
+
+      private:
+         std::vector<std::vector<char>>   messages;
+         size_t                           pos = 0;
+   };
+
+   /// Runs `f`, returning the error it throws or "no error".
+   template<typename F>
+   std::string error_of( F&& f ) {
+      try {
+         f();
+      } catch( const std::exception& e ) {
+         return e.what();
+      }
+      return "no error";
+   }
+
+   /**
+    * A state history endpoint serving a fixed stream as nodeos does, on a loopback port.
+    */
+   class test_server {
+      public:
+         explicit test_server( const std::vector<std::vector<char>>& messages ) {
+            listen_fd = ::socket( AF_INET, SOCK_STREAM, 0 );
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+            socklen_t len = sizeof(addr);
+            if ( listen_fd < 0 || ::bind( listen_fd, (sockaddr*)&addr, len ) != 0 || ::listen( listen_fd, 1 ) != 0
+                 || ::getsockname( listen_fd, (sockaddr*)&addr, &len ) != 0 ) {
+               throw std::runtime_error( "cannot listen on a loopback port" );
+            }
+            port = ntohs( addr.sin_port );
+            thread = std::thread( [this, &messages] {
+               try {
+                  serve( messages );
+               } catch( const std::exception& e ) {
+                  failure = e.what();
+               }
+            } );
+         }
+
+         ~test_server() {
+            if ( thread.joinable() ) thread.join();
+            ::close( listen_fd );
+         }
+
+         /// Empty when the session went as expected.
+         std::string finish() {
+            thread.join();
+            if ( failure.empty() && !pong ) failure = "the client did not answer the ping";
+            return failure;
+         }
+
+         uint16_t          port = 0;
+         std::string       failure;
+
+      private:
+         void serve( const std::vector<std::vector<char>>& messages ) {
+            fd = ::accept( listen_fd, nullptr, nullptr );
+            if ( fd < 0 ) throw std::runtime_error( "accept failed" );
+            std::string request;
+            while( request.size() < 4 || request.compare( request.size() - 4, 4, "\r\n\r\n" ) != 0 ) {
+               char c;
+               read_exact( &c, 1 );
+               request.push_back( c );
+            }
+            if ( request.find( "Upgrade: websocket" ) == std::string::npos || request.find( "Sec-WebSocket-Key: " ) == std::string::npos ) {
+               throw std::runtime_error( "not a websocket upgrade" );
+            }
+            //the ABI follows the headers in the same packet
+            std::string abi = "{\"version\":\"eosio::abi/1.1\"}";
+            std::string reply = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                                "Sec-WebSocket-Accept: unchecked\r\n\r\n" + frame( 0x1, abi.data(), abi.size(), true );
+            write_all( reply );
+
+            uint8_t opcode = 0;
+            auto req = read_frame( opcode );
+            row_reader rd( req.data(), req.size() );
+            uint32_t kind = rd.read_varuint32();
+            rd.read<uint32_t>(); //start
+            rd.read<uint32_t>(); //end
+            uint32_t in_flight = rd.read<uint32_t>();
+            if ( opcode != 0x2 || kind != ship::get_blocks_request_v0 || in_flight == 0 ) throw std::runtime_error( "bad request" );
+
+            size_t sent = 0;
+            size_t acked = 0;
+            while( acked < messages.size() ) {
+               if ( sent < messages.size() && sent - acked < in_flight ) {
+                  const auto& m = messages[sent++];
+                  if ( sent == 1 ) { //fragmented, with a ping between the fragments
+                     size_t half = m.size() / 2;
+                     write_all( frame( 0x2, m.data(), half, false ) + frame( 0x9, "ping", 4, true )
+                                + frame( 0x0, m.data() + half, m.size() - half, true ) );
+                  } else {
+                     write_all( frame( 0x2, m.data(), m.size(), true ) );
+                  }
+                  continue;
+               }
+               auto payload = read_frame( opcode );
+               if ( opcode == 0xA ) {
+                  pong = true;
+               } else if ( opcode == 0x2 ) {
+                  row_reader ack( payload.data(), payload.size() );
+                  if ( ack.read_varuint32() != ship::get_blocks_ack_request_v0 ) throw std::runtime_error( "not an ack" );
+                  acked += ack.read<uint32_t>();
+               } else {
+                  throw std::runtime_error( "unexpected frame" );
+               }
+            }
+            write_all( frame( 0x8, "", 0, true ) );
+            for( ;; ) { //until the client's close
+               read_frame( opcode );
+               if ( opcode == 0x8 ) break;
+               if ( opcode == 0xA ) pong = true;
+            }
+            ::close( fd );
+         }
+
+         /// Server frames are not masked.
+         static std::string frame( uint8_t opcode, const char* data, size_t size, bool fin ) {
+            std::string f;
+            f.push_back( (char)( ( fin ? 0x80 : 0 ) | opcode ) );
+            if ( size < 126 ) {
+               f.push_back( (char)size );
+            } else if ( size <= 0xffff ) {
+               f.push_back( (char)126 );
+               f.push_back( (char)( size >> 8 ) );
+               f.push_back( (char)size );
+            } else {
+               f.push_back( (char)127 );
+               for( int shift = 56; shift >= 0; shift -= 8 ) f.push_back( (char)( (uint64_t)size >> shift ) );
+            }
+            f.append( data, size );
+            return f;
+         }
+
+         std::vector<char> read_frame( uint8_t& opcode ) {
+            uint8_t head[2];
+            read_exact( head, 2 );
+            opcode = head[0] & 0x0f;
+            if ( !( head[0] & 0x80 ) || !( head[1] & 0x80 ) ) throw std::runtime_error( "client frame fragmented or not masked" );
+            uint64_t size = head[1] & 0x7f;
+            if ( size >= 126 ) throw std::runtime_error( "client frame too large" );
+            uint8_t mask[4];
+            read_exact( mask, 4 );
+            std::vector<char> payload( size );
+            read_exact( payload.data(), size );
+            for( size_t i = 0; i < size; i++ ) payload[i] ^= mask[i % 4];
+            return payload;
+         }
+
+         void read_exact( void* buf, size_t size ) {
+            char* p = static_cast<char*>( buf );
+            while( size > 0 ) {
+               ssize_t n = ::recv( fd, p, size, 0 );
+               if ( n <= 0 ) throw std::runtime_error( "the client closed the connection" );
+               p += n;
+               size -= (size_t)n;
+            }
+         }
+
+         void write_all( const std::string& data ) {
+            for( size_t done = 0; done < data.size(); ) {
+               ssize_t n = ::send( fd, data.data() + done, data.size() - done, MSG_NOSIGNAL );
+               if ( n <= 0 ) throw std::runtime_error( "send failed" );
+               done += (size_t)n;
+            }
+         }
+
+         int            listen_fd = -1;
+         int            fd = -1;
+         bool           pong = false;
+         std::thread    thread;
+   };
+
+   /// Fails with `what` when `error` is not empty.
+   int report( const std::string& what, const std::string& error ) {
+      if ( error.empty() ) return 0;
+      std::fprintf( stderr, "%s: %s\n", what.c_str(), error.c_str() );
+      return 1;
+   }
+
+   int test_replay( const generated_chain& chain, const std::string& path ) {
+      int failures = 0;
+      {
+         recorder rec( path );
+         for( const auto& m : chain.messages ) rec.write( m );
+      }
+      for( unsigned workers : { 1u, 3u, 8u } ) {
+         token_store store;
+         replay_source source( path );
+         pipeline p( store, contract, workers );
+         auto stats = p.run( source, nullptr );
+         std::string error = compare_rows( store, chain.rows );
+         if ( error.empty() && store.head().block_num != chain.head ) error = "head is not the last block";
+         if ( error.empty() && stats.messages != chain.messages.size() ) error = "messages were skipped";
+         failures += report( "replay with " + std::to_string( workers ) + " workers", error );
+      }
+      return failures;
+   }
+
+   int test_websocket( const generated_chain& chain ) {
+      token_store store;
+      std::string error;
+      std::string abi;
+      {
+         test_server server( chain.messages );
+         error = error_of( [&] {
+            ship_client client( "127.0.0.1", server.port );
+            abi = client.abi();
+            pipeline p( store, contract, 3 );
+            ship::get_blocks_request r;
+            r.start_block_num = 1;
+            r.max_messages_in_flight = p.window_size();
+            client.request( r );
+            p.run( client, nullptr );
+         } );
+         if ( error == "no error" ) error = server.finish();
+         else server.finish();
+      }
+      if ( error.empty() && abi.find( "eosio::abi" ) == std::string::npos ) error = "the ABI was not received";
+      if ( error.empty() ) error = compare_rows( store, chain.rows );
+      return report( "websocket session", error );
+   }
+
+   /// Stops on the first block of the first fork, saves, loads and resumes from the recording.
+   int test_resume( const generated_chain& chain, const std::string& path, const std::string& state ) {
+      if ( !chain.first_fork ) return report( "resume", "the chain has no fork" );
+      token_store first;
+      {
+         replay_source source( path );
+         pipeline( first, contract, 4 ).run( source, nullptr, chain.first_fork + 1 );
+      }
+      first.save( state );
+
+      token_store resumed;
+      resumed.load( state );
+      std::string error = compare_rows( resumed, rows_of( first ) );
+      if ( error.empty() && ( resumed.head().block_id != first.head().block_id || resumed.head_time() != first.head_time() ) ) {
+         error = "the head was not saved";
+      }
+      if ( error.empty() && resumed.head().block_id != position( chain.first_fork, 1 ).block_id ) {
+         error = "did not stop on the fork";
+      }
+      if ( error.empty() ) {
+         replay_source source( path, 0, resumed.head() );
+         pipeline( resumed, contract, 4 ).run( source, nullptr );
+         error = compare_rows( resumed, chain.rows );
+      }
+      return report( "resume", error );
+   }
+
+   int test_holders( const std::string& path ) {
+      uint64_t aaa = string_to_symbol( 4, "AAA" );
+      uint64_t bbb = string_to_symbol( 4, "BBB" );
+      uint64_t ccc = string_to_symbol( 4, "CCC" );
+      uint64_t a = aaa >> 8;
+      uint64_t alice = string_to_name( "alice" );
+      uint64_t bob = string_to_name( "bob" );
+      uint64_t carol = string_to_name( "carol" );
+
+      std::vector<std::vector<char>>   values;
+      std::vector<ship::contract_row>  rows;
+      values.reserve( 32 );
+      auto add = [&]( uint64_t table, uint64_t scope, uint64_t pk, data_writer& w ) {
+         values.push_back( w.release() );
+         w = data_writer();
+         rows.push_back( contract_row( contract, table, scope, pk, true, values.back() ) );
+      };
+      data_writer w;
+      w.write_asset( { 11000, aaa } ).write_asset( { 1000000, aaa } ).write( alice ).write( alice ).write( alice );
+      w.write<uint64_t>( base_time ).write<uint32_t>( 7 );
+      add( stat_table, a, a, w );
+      w.write_asset( { 10000, aaa } );                     add( accounts_table, alice, a, w );
+      w.write_asset( { 1000, aaa } );                      add( accounts_table, bob, a, w );
+      w.write_asset( { 5, ccc } );                         add( accounts_table, carol, ccc >> 8, w ); //no stat row
+      w.write( alice ).write<int64_t>( 1000 );             add( numlock2_table, a, alice, w );
+      w.write( alice ).write_asset( { 9999, aaa } );       add( numlock_table, a, alice, w ); //v2 comes first
+      w.write( bob ).write_asset( { 250, aaa } );          add( numlock_table, a, bob, w );
+      //half vested at base_time, all at base_time + 100
+      w.write<uint32_t>( 101 ).write_array( std::vector<uint32_t>{ 0, 100 } ).write_array( std::vector<uint16_t>{ 50, 100 } );
+      w.write<uint32_t>( 100 ).write<uint32_t>( 0 ).write_string( "" );
+      add( lockrule2_table, a, 101, w );
+      //a quarter more every 10 s from base_time + 10
+      w.write<uint32_t>( 103 ).write_array( std::vector<uint64_t>{ 10 } ).write_array( std::vector<uint16_t>{ 25 } );
+      w.write<uint32_t>( 100 ).write<uint32_t>( 10 ).write_string( "" );
+      add( lockrule_table, a, 103, w );
+      w.write( ( (uint64_t)7 << 32 ) + 101 ).write<int64_t>( 4000 ).write<uint32_t>( base_time );
+      add( acclock2_table, alice, ( (uint64_t)7 << 32 ) + 101, w );
+      w.write( ( (uint64_t)8 << 32 ) + 101 ).write<int64_t>( 999 ).write<uint32_t>( base_time ); //another token
+      add( acclock2_table, alice, ( (uint64_t)8 << 32 ) + 101, w );
+      w.write<uint64_t>( 102 ).write_asset( { 500, aaa } ).write( alice ).write<uint64_t>( base_time ); //no rule, stays locked
+      add( acclock_table, alice, 102, w );
+      w.write<uint64_t>( 101 ).write_asset( { 700, bbb } ).write( alice ).write<uint64_t>( base_time ); //another token
+      add( acclock_table, alice, 101, w );
+      w.write<uint64_t>( 103 ).write_asset( { 400, aaa } ).write( bob ).write<uint64_t>( base_time );
+      add( acclock_table, bob, 103, w );
+      w.write( alice ).write( bob ).write<int64_t>( 300 );        add( loanpool2_table, a, alice, w );
+      w.write( alice ).write( bob ).write_asset( { 77, aaa } );   add( loanpool_table, a, alice, w ); //v2 comes first
+      w.write( bob ).write( alice ).write_asset( { 50, aaa } );   add( loanpool_table, a, bob, w );
+      w.write( alice ).write<int64_t>( 200 );                     add( subledger_table, a, alice, w );
+
+      recorder( path ).write( block_message( position( 1, 0 ), base_time + 50, 1, rows, true ) );
+      token_store store;
+      replay_source source( path );
+      pipeline( store, contract, 2 ).run( source, nullptr );
+
+      int failures = 0;
+      if ( store.head_time() != base_time + 50 ) failures += report( "holders", "wrong block time" );
+      struct expected {
+         uint64_t owner;
+         uint64_t curtime;
+         int64_t  locked;
+         int64_t  loaned;
+         int64_t  allocated;
+         int64_t  available;
+      };
+      for( const auto& e : { expected{ alice, base_time + 50, 3500, 300, 200, 6000 },
+                             expected{ alice, base_time + 200, 1500, 300, 200, 8000 },
+                             expected{ alice, base_time - 100, 5500, 300, 200, 4000 },
+                             expected{ bob, base_time + 50, 250, 50, 0, 700 },
+                             expected{ bob, base_time + 25, 550, 50, 0, 400 } } ) {
+         holder_state h;
+         std::string what = name_to_string( e.owner ) + " at " + std::to_string( e.curtime );
+         if ( !store.holder( e.owner, a, e.curtime, h ) ) {
+            failures += report( "holders", what + " not found" );
+         } else if ( h.locked != e.locked || h.loaned != e.loaned || h.allocated != e.allocated || h.available() != e.available ) {
+            failures += report( "holders", what + ": locked " + std::to_string( h.locked ) + ", loaned " + std::to_string( h.loaned )
+                                + ", allocated " + std::to_string( h.allocated ) + ", available " + std::to_string( h.available() ) );
+         }
+      }
+      holder_state h;
+      if ( store.holder( carol, ccc >> 8, base_time, h ) ) failures += report( "holders", "a token without stat row has holders" );
+
+      std::ostringstream csv;
+      write_holders_csv( store, store.head_time(), csv );
+      if ( csv.str() != "owner,symbol,precision,balance,locked,loaned,allocated,available\n"
+                        "alice,AAA,4,10000,3500,300,200,6000\n"
+                        "bob,AAA,4,1000,250,50,0,700\n" ) {
+         failures += report( "holders", "unexpected CSV:\n" + csv.str() );
+      }
+      return failures;
+   }
+
+   int test_errors() {
+      int failures = 0;
+      std::vector<char> bad_value{ 1, 2, 3 };
+      std::vector<ship::contract_row> rows{ contract_row( contract, accounts_table, 1, 1, true, bad_value ) };
+      {
+         token_store store;
+         vector_source source( { block_message( position( 1, 0 ), base_time, 0, rows, true ) } );
+         std::string error = error_of( [&] { pipeline( store, contract, 2 ).run( source, nullptr ); } );
+         if ( error.find( "does not decode" ) == std::string::npos ) failures += report( "malformed row", error );
+      }
+      {
+         token_store store;
+         vector_source source( { block_message( position( 10, 0 ), base_time, 10, {}, false ),
+                                 block_message( position( 10, 1 ), base_time, 9, {}, false ) } );
+         std::string error = error_of( [&] { pipeline( store, contract, 2 ).run( source, nullptr ); } );
+         if ( error.find( "irreversible" ) == std::string::npos ) failures += report( "irreversible fork", error );
+      }
+      {
+         token_store store;
+         std::vector<char> truncated = block_message( position( 1, 0 ), base_time, 0, {}, false );
+         truncated.pop_back();
+         vector_source source( { truncated } );
+         std::string error = error_of( [&] { pipeline( store, contract, 2 ).run( source, nullptr ); } );
+         if ( error.find( "malformed" ) == std::string::npos ) failures += report( "truncated message", error );
+      }
+      return failures;
+   }
+
+} /// namespace
+
+int main( int argc, char** argv )
+{
+   uint64_t seed = 1;
+   uint32_t blocks = 400;
+   for( int i = 1; i < argc; i++ ) {
+      bool has_value = i + 1 < argc;
+      if ( std::strcmp( argv[i], "--seed" ) == 0 && has_value ) {
+         seed = std::strtoull( argv[++i], nullptr, 10 );
+      } else if ( std::strcmp( argv[i], "--blocks" ) == 0 && has_value ) {
+         blocks = (uint32_t)std::strtoul( argv[++i], nullptr, 10 );
+      } else {
+         std::fprintf( stderr, "usage: %s [--seed N] [--blocks N]\n", argv[0] );
+         return 2;
+      }
+   }
+
+   std::string prefix = "indexer_test_" + std::to_string( ::getpid() );
+   std::string stream = prefix + ".ship";
+   std::string state = prefix + ".state";
+   std::string holders = prefix + "_holders.ship";
+   int failures = 0;
+   try {
+      generated_chain chain = chain_generator( seed ).generate( std::max<uint32_t>( blocks, 20 ) );
+      failures += test_replay( chain, stream );
+      failures += test_websocket( chain );
+      failures += test_resume( chain, stream, state );
+      failures += test_holders( holders );
+      failures += test_errors();
+      std::printf( "%zu messages, %zu rows: %d failures\n", chain.messages.size(), chain.rows.size(), failures );
+   } catch( const std::exception& e ) {
+      std::fprintf( stderr, "%s\n", e.what() );
+      failures++;
+   }
+   std::remove( stream.c_str() );
+   std::remove( state.c_str() );
+   std::remove( holders.c_str() );
+   return failures ? 1 : 0;
+}
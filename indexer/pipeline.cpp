@@ -0,0 +1,176 @@
+#include "pipeline.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+namespace yotta::indexer {
+
+   namespace {
+
+      constexpr uint32_t ack_batch = 32;
+
+   } /// namespace
+
+   bool decode_block( const std::vector<char>& msg, uint64_t contract, block_update& out )
+   {
+      ship::blocks_result r;
+      if ( !ship::decode_result( msg.data(), msg.size(), r ) ) throw std::runtime_error( "malformed state history result" );
+      if ( !r.this_block ) return false;
+
+      out.block = *r.this_block;
+      out.last_irreversible = r.last_irreversible;
+      out.changes.clear();
+      std::string block_num = std::to_string( out.block.block_num );
+      if ( !ship::block_time( r.block, out.time ) ) throw std::runtime_error( "block " + block_num + " has no header" );
+
+      std::optional<ship::contract_row> bad;
+      bool ok = ship::each_contract_row( r.deltas, [&]( const ship::contract_row& row ) {
+         if ( row.code != contract || !is_followed_table( row.table ) ) return;
+         row_change c;
+         c.key = row_key{ row.table, row.scope, row.primary_key };
+         c.present = row.present;
+         if ( row.present ) {
+            c.row.payer = row.payer;
+            c.row.value.assign( row.value.begin(), row.value.end() );
+            if ( !bad && !is_valid_row( row.table, c.row.value ) ) bad = row;
+         }
+         out.changes.push_back( std::move( c ) );
+      } );
+      if ( !ok ) throw std::runtime_error( "malformed deltas in block " + block_num );
+      if ( bad ) {
+         throw std::runtime_error( "row " + std::to_string( bad->primary_key ) + " of " + name_to_string( bad->table ) + " scope "
+                                   + name_to_string( bad->scope ) + " in block " + block_num + " does not decode" );
+      }
+      return true;
+   }
+
+   pipeline::pipeline( token_store& store, uint64_t contract, unsigned workers )
+   : store(store), contract(contract), workers(std::max( 1u, workers )), window(this->workers * 16)
+   {
+   }
+
+   pipeline_stats pipeline::run( message_source& source, recorder* rec, uint32_t end_block, const block_handler& on_block )
+   {
+      std::mutex                    m;
+      std::condition_variable       to_reader, to_workers, to_store;
+      std::deque<std::pair<uint64_t, std::vector<char>>>      pending; //read, not decoded, in order
+      std::map<uint64_t, std::optional<block_update>>         decoded; //by sequence, none without a block
+      uint64_t                      read = 0;
+      uint64_t                      applied = 0;
+      bool                          eof = false;
+      bool                          stopping = false;
+      std::exception_ptr            error;
+
+      auto fail = [&]( std::exception_ptr e ) {
+         std::lock_guard g( m );
+         if ( !error ) error = e;
+         stopping = true;
+         source.interrupt();
+         to_reader.notify_all();
+         to_workers.notify_all();
+         to_store.notify_all();
+      };
+
+      std::thread reader( [&] {
+         try {
+            std::vector<char> msg;
+            while( source.next( msg ) ) {
+               if ( rec ) rec->write( msg );
+               std::unique_lock lock( m );
+               to_reader.wait( lock, [&] { return stopping || read - applied < window; } );
+               if ( stopping ) break;
+               pending.emplace_back( read++, std::move( msg ) );
+               to_workers.notify_one();
+            }
+            std::lock_guard g( m );
+            eof = true;
+            to_workers.notify_all();
+            to_store.notify_all();
+         } catch( ... ) {
+            fail( std::current_exception() );
+         }
+      } );
+
+      std::vector<std::thread> pool;
+      for( unsigned i = 0; i < workers; i++ ) {
+         pool.emplace_back( [&] {
+            try {
+               for( ;; ) {
+                  std::unique_lock lock( m );
+                  to_workers.wait( lock, [&] { return stopping || eof || !pending.empty(); } );
+                  if ( stopping || pending.empty() ) return;
+                  auto [seq, msg] = std::move( pending.front() );
+                  pending.pop_front();
+                  lock.unlock();
+
+                  std::optional<block_update> b( std::in_place );
+                  if ( !decode_block( msg, contract, *b ) ) b.reset();
+
+                  lock.lock();
+                  decoded.emplace( seq, std::move( b ) );
+                  if ( seq == applied ) to_store.notify_one();
+               }
+            } catch( ... ) {
+               fail( std::current_exception() );
+            }
+         } );
+      }
+
+      pipeline_stats stats;
+      uint32_t unacked = 0;
+      try {
+         for( ;; ) {
+            std::unique_lock lock( m );
+            if ( unacked && decoded.find( applied ) == decoded.end() ) { //about to wait, let the server send more
+               lock.unlock();
+               source.ack( unacked );
+               unacked = 0;
+               lock.lock();
+            }
+            to_store.wait( lock, [&] { return stopping || decoded.count( applied ) || ( eof && applied == read ); } );
+            if ( stopping || !decoded.count( applied ) ) break;
+            auto node = decoded.extract( applied );
+            lock.unlock();
+
+            stats.messages++;
+            bool done = false;
+            if ( auto& b = node.mapped() ) {
+               store.apply( *b );
+               stats.blocks++;
+               stats.rows += b->changes.size();
+               if ( on_block ) on_block( *b );
+               done = b->block.block_num + 1 >= end_block;
+            }
+            if ( ++unacked >= ack_batch ) {
+               source.ack( unacked );
+               unacked = 0;
+            }
+
+            lock.lock();
+            applied++;
+            to_reader.notify_one();
+            if ( done ) {
+               stopping = true;
+               source.interrupt();
+               to_reader.notify_all();
+               to_workers.notify_all();
+               break;
+            }
+         }
+      } catch( ... ) {
+         fail( std::current_exception() );
+      }
+
+      reader.join();
+      for( auto& t : pool ) t.join();
+      if ( error ) std::rethrow_exception( error );
+      return stats;
+   }
+
+} /// namespace yotta::indexer
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ship_client.hpp"
+#include "token_store.hpp"
+#include <functional>
+
+/**
+ * The indexer's pipeline: a reader thread takes result messages from a source, a pool of worker
+ * threads decodes them into block updates, and the calling thread applies the updates to the
+ * store in stream order, acknowledging them to the source.
+ *
+ * At most `window` messages are between the reader and the store, which bounds memory when the
+ * node sends faster than the store applies.
+ */
+namespace yotta::indexer {
+
+   /**
+    * Decodes a result message into the changes of `contract` to the followed tables, each row
+    * checked with the native client. Returns false when the message carries no block. Throws
+    * when it is malformed or has no block header, which needs `fetch_block`.
+    */
+   bool decode_block( const std::vector<char>& msg, uint64_t contract, block_update& out );
+
+   struct pipeline_stats {
+      uint64_t    messages = 0;
+      uint64_t    blocks = 0;
+      uint64_t    rows = 0; //changes applied
+   };
+
+   class pipeline {
+      public:
+         /// Called on the store's thread after each block applied, e.g. to save the store.
+         using block_handler = std::function<void( const block_update& )>;
+
+         pipeline( token_store& store, uint64_t contract, unsigned workers );
+
+         /// Messages the pipeline holds at most, the `max_messages_in_flight` to request.
+         uint32_t window_size()const { return (uint32_t)window; }
+
+         /**
+          * Runs until the source ends or block `end_block - 1` is applied, recording every
+          * message to `rec` when given. Rethrows the first error of a thread, the others stopped.
+          */
+         pipeline_stats run( message_source& source, recorder* rec, uint32_t end_block = 0xffffffff,
+                             const block_handler& on_block = {} );
+
+      private:
+         token_store&   store;
+         uint64_t       contract;
+         unsigned       workers;
+         size_t         window;
+   };
+
+} /// namespace yotta::indexer
@@ -0,0 +1,309 @@
+#include "ship_client.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <random>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace yotta::indexer {
+
+   namespace {
+
+      constexpr uint32_t recording_magic = 0x50485359; //"YSHP"
+      constexpr uint64_t max_message_size = (uint64_t)1 << 30;
+
+      constexpr uint8_t op_continuation = 0x0;
+      constexpr uint8_t op_text         = 0x1;
+      constexpr uint8_t op_binary       = 0x2;
+      constexpr uint8_t op_close        = 0x8;
+      constexpr uint8_t op_ping         = 0x9;
+      constexpr uint8_t op_pong         = 0xA;
+
+      std::string base64( const uint8_t* data, size_t size ) {
+         static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+         std::string out;
+         for( size_t i = 0; i < size; i += 3 ) {
+            uint32_t v = data[i] << 16;
+            if ( i + 1 < size ) v |= data[i + 1] << 8;
+            if ( i + 2 < size ) v |= data[i + 2];
+            out.push_back( chars[( v >> 18 ) & 63] );
+            out.push_back( chars[( v >> 12 ) & 63] );
+            out.push_back( i + 1 < size ? chars[( v >> 6 ) & 63] : '=' );
+            out.push_back( i + 2 < size ? chars[v & 63] : '=' );
+         }
+         return out;
+      }
+
+      bool send_all( int fd, const char* data, size_t size ) {
+         while( size > 0 ) {
+            ssize_t n = ::send( fd, data, size, MSG_NOSIGNAL );
+            if ( n < 0 && errno == EINTR ) continue;
+            if ( n <= 0 ) return false;
+            data += n;
+            size -= (size_t)n;
+         }
+         return true;
+      }
+
+   } /// namespace
+
+   ship_client::ship_client( const std::string& host, uint16_t port )
+   {
+      addrinfo hints{};
+      hints.ai_family = AF_UNSPEC;
+      hints.ai_socktype = SOCK_STREAM;
+      addrinfo* addrs = nullptr;
+      if ( int err = getaddrinfo( host.c_str(), std::to_string( port ).c_str(), &hints, &addrs ); err != 0 ) {
+         throw std::runtime_error( "cannot resolve " + host + ": " + gai_strerror( err ) );
+      }
+      for( addrinfo* a = addrs; a && fd < 0; a = a->ai_next ) {
+         fd = ::socket( a->ai_family, a->ai_socktype, a->ai_protocol );
+         if ( fd >= 0 && ::connect( fd, a->ai_addr, a->ai_addrlen ) != 0 ) {
+            ::close( fd );
+            fd = -1;
+         }
+      }
+      freeaddrinfo( addrs );
+      if ( fd < 0 ) throw std::runtime_error( "cannot connect to " + host + ":" + std::to_string( port ) );
+
+      std::random_device rd;
+      uint8_t key[16];
+      for( auto& k : key ) k = (uint8_t)rd();
+      mask_seed = rd() | 1;
+
+      std::string handshake = "GET / HTTP/1.1\r\nHost: " + host + ":" + std::to_string( port ) +
+                              "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + base64( key, sizeof(key) ) +
+                              "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+      if ( !send_all( fd, handshake.data(), handshake.size() ) ) throw std::runtime_error( "cannot send the websocket handshake" );
+
+      //read byte by byte, the server may send the ABI right after the headers
+      std::string response;
+      while( response.size() < 4 || response.compare( response.size() - 4, 4, "\r\n\r\n" ) != 0 ) {
+         char c;
+         if ( response.size() > 16384 || !read_exact( &c, 1 ) ) throw std::runtime_error( "websocket handshake failed" );
+         response.push_back( c );
+      }
+      if ( response.compare( 0, 12, "HTTP/1.1 101" ) != 0 ) {
+         throw std::runtime_error( "websocket upgrade refused: " + response.substr( 0, response.find( '\r' ) ) );
+      }
+
+      std::vector<char> msg;
+      bool text = false;
+      if ( !read_message( msg, text ) || !text ) throw std::runtime_error( "the server did not send its ABI" );
+      server_abi.assign( msg.begin(), msg.end() );
+   }
+
+   ship_client::~ship_client()
+   {
+      if ( fd >= 0 ) ::close( fd );
+   }
+
+   void ship_client::request( const ship::get_blocks_request& r )
+   {
+      auto data = ship::pack_request( r );
+      send_frame( op_binary, data.data(), data.size() );
+   }
+
+   bool ship_client::next( std::vector<char>& msg )
+   {
+      bool text = false;
+      while( read_message( msg, text ) ) {
+         if ( !text ) return true;
+      }
+      return false;
+   }
+
+   void ship_client::ack( uint32_t n )
+   {
+      auto data = ship::pack_ack( n );
+      try {
+         send_frame( op_binary, data.data(), data.size() );
+      } catch( const std::runtime_error& ) {
+         //the connection is gone, which `next` reports
+      }
+   }
+
+   void ship_client::interrupt()
+   {
+      ::shutdown( fd, SHUT_RDWR ); //async-signal-safe
+   }
+
+   bool ship_client::read_message( std::vector<char>& msg, bool& text )
+   {
+      msg.clear();
+      bool started = false;
+      for( ;; ) {
+         uint8_t head[2];
+         if ( !read_exact( head, 2 ) ) return false;
+         bool     fin = head[0] & 0x80;
+         uint8_t  opcode = head[0] & 0x0f;
+         uint64_t size = head[1] & 0x7f;
+         if ( size == 126 ) {
+            uint8_t ext[2];
+            if ( !read_exact( ext, 2 ) ) return false;
+            size = ( ext[0] << 8 ) | ext[1];
+         } else if ( size == 127 ) {
+            uint8_t ext[8];
+            if ( !read_exact( ext, 8 ) ) return false;
+            size = 0;
+            for( uint8_t b : ext ) size = ( size << 8 ) | b;
+         }
+         uint8_t mask[4] = {};
+         bool masked = head[1] & 0x80;
+         if ( masked && !read_exact( mask, 4 ) ) return false;
+         if ( msg.size() + size > max_message_size ) throw std::runtime_error( "websocket message too large" );
+
+         if ( opcode >= op_close ) { //control frames are never fragmented and may come between fragments
+            std::vector<char> payload( size );
+            if ( !read_exact( payload.data(), size ) ) return false;
+            for( size_t i = 0; masked && i < size; i++ ) payload[i] ^= mask[i % 4];
+            if ( opcode == op_close ) {
+               std::lock_guard g( send_mutex );
+               uint8_t close[6] = { 0x80 | op_close, 0x80, 0, 0, 0, 0 };
+               send_all( fd, (const char*)close, sizeof(close) );
+               return false;
+            }
+            if ( opcode == op_ping ) {
+               try {
+                  send_frame( op_pong, payload.data(), payload.size() );
+               } catch( const std::runtime_error& ) {
+                  return false;
+               }
+            }
+            continue;
+         }
+
+         if ( opcode != op_continuation ) {
+            if ( started ) throw std::runtime_error( "websocket message interrupted by another" );
+            if ( opcode != op_text && opcode != op_binary ) throw std::runtime_error( "unknown websocket opcode" );
+            text = opcode == op_text;
+            started = true;
+         } else if ( !started ) {
+            throw std::runtime_error( "websocket continuation without a message" );
+         }
+         size_t offset = msg.size();
+         msg.resize( offset + size );
+         if ( !read_exact( msg.data() + offset, size ) ) return false;
+         for( size_t i = 0; masked && i < size; i++ ) msg[offset + i] ^= mask[i % 4];
+         if ( fin ) return true;
+      }
+   }
+
+   /// Client frames are masked, as the protocol requires.
+   void ship_client::send_frame( uint8_t opcode, const char* data, size_t size )
+   {
+      std::lock_guard g( send_mutex );
+      std::vector<char> frame;
+      frame.reserve( size + 14 );
+      frame.push_back( (char)( 0x80 | opcode ) );
+      if ( size < 126 ) {
+         frame.push_back( (char)( 0x80 | size ) );
+      } else if ( size <= 0xffff ) {
+         frame.push_back( (char)( 0x80 | 126 ) );
+         frame.push_back( (char)( size >> 8 ) );
+         frame.push_back( (char)size );
+      } else {
+         frame.push_back( (char)( 0x80 | 127 ) );
+         for( int shift = 56; shift >= 0; shift -= 8 ) frame.push_back( (char)( (uint64_t)size >> shift ) );
+      }
+      mask_seed ^= mask_seed << 13;
+      mask_seed ^= mask_seed >> 17;
+      mask_seed ^= mask_seed << 5;
+      char mask[4];
+      std::memcpy( mask, &mask_seed, 4 );
+      frame.insert( frame.end(), mask, mask + 4 );
+      for( size_t i = 0; i < size; i++ ) frame.push_back( data[i] ^ mask[i % 4] );
+      if ( !send_all( fd, frame.data(), frame.size() ) ) throw std::runtime_error( "websocket connection lost" );
+   }
+
+   bool ship_client::read_exact( void* buf, size_t size )
+   {
+      char* p = static_cast<char*>( buf );
+      while( size > 0 ) {
+         ssize_t n = ::recv( fd, p, size, 0 );
+         if ( n < 0 && errno == EINTR ) continue;
+         if ( n <= 0 ) return false;
+         p += n;
+         size -= (size_t)n;
+      }
+      return true;
+   }
+
+   replay_source::replay_source( const std::string& path, uint32_t start_block, const ship::block_position& after )
+   : path(path), start_block(start_block), after(after), started(start_block == 0 && after.block_num == 0)
+   {
+      file = std::fopen( path.c_str(), "rb" );
+      uint32_t magic = 0;
+      if ( !file || std::fread( &magic, sizeof(magic), 1, file ) != 1 || magic != recording_magic ) {
+         if ( file ) std::fclose( file );
+         throw std::runtime_error( path + " is not a recorded state history stream" );
+      }
+   }
+
+   replay_source::~replay_source()
+   {
+      std::fclose( file );
+   }
+
+   bool replay_source::next( std::vector<char>& msg )
+   {
+      while( read( msg ) ) {
+         if ( started ) return true;
+         ship::blocks_result r;
+         if ( !ship::decode_result( msg.data(), msg.size(), r ) ) {
+            started = true; //left to the indexer to reject
+            return true;
+         }
+         if ( !r.this_block ) continue;
+         if ( after.block_num ) {
+            started = r.this_block->block_num == after.block_num && r.this_block->block_id == after.block_id;
+            continue;
+         }
+         if ( r.this_block->block_num >= start_block ) {
+            started = true;
+            return true;
+         }
+      }
+      if ( !started && after.block_num && !stopped ) {
+         throw std::runtime_error( path + " does not have block " + std::to_string( after.block_num ) + " to resume after" );
+      }
+      return false;
+   }
+
+   bool replay_source::read( std::vector<char>& msg )
+   {
+      if ( stopped ) return false;
+      uint32_t size = 0;
+      if ( std::fread( &size, sizeof(size), 1, file ) != 1 ) return false;
+      msg.resize( size );
+      if ( size > 0 && std::fread( msg.data(), size, 1, file ) != 1 ) throw std::runtime_error( path + " is truncated" );
+      return true;
+   }
+
+   recorder::recorder( const std::string& path )
+   : path(path)
+   {
+      file = std::fopen( path.c_str(), "wb" );
+      if ( !file || std::fwrite( &recording_magic, sizeof(recording_magic), 1, file ) != 1 ) {
+         if ( file ) std::fclose( file );
+         throw std::runtime_error( "cannot write " + path );
+      }
+   }
+
+   recorder::~recorder()
+   {
+      std::fclose( file );
+   }
+
+   void recorder::write( const std::vector<char>& msg )
+   {
+      uint32_t size = (uint32_t)msg.size();
+      if ( std::fwrite( &size, sizeof(size), 1, file ) != 1 || ( size && std::fwrite( msg.data(), size, 1, file ) != 1 ) ) {
+         throw std::runtime_error( "cannot write " + path );
+      }
+   }
+
+} /// namespace yotta::indexer
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "ship_protocol.hpp"
+#include <csignal>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Sources of state history result messages: a live session with a node and a recorded stream.
+ */
+namespace yotta::indexer {
+
+   class message_source {
+      public:
+         virtual ~message_source() = default;
+
+         /// The next result message, false at the end of the stream.
+         virtual bool next( std::vector<char>& msg ) = 0;
+
+         /// Acknowledges `n` more processed messages, letting the server send as many more.
+         virtual void ack( uint32_t n ) {}
+
+         /// Makes a blocked `next` return false, from any thread or a signal handler.
+         virtual void interrupt() {}
+   };
+
+   /**
+    * A state history session over a websocket to a node, e.g. `127.0.0.1:8080` for a node run
+    * with `--state-history-endpoint` and `--trace-history --chain-state-history`.
+    *
+    * Only what nodeos speaks on its state history endpoint is supported: unencrypted websocket,
+    * binary and text messages possibly fragmented, pings and a close from the server.
+    */
+   class ship_client : public message_source {
+      public:
+         /// Connects and receives the ABI the server sends first. Throws on failure.
+         ship_client( const std::string& host, uint16_t port );
+         ~ship_client() override;
+
+         ship_client( const ship_client& ) = delete;
+         ship_client& operator=( const ship_client& ) = delete;
+
+         /// The ABI of the server, as JSON.
+         const std::string& abi()const { return server_abi; }
+
+         void request( const ship::get_blocks_request& r );
+
+         bool next( std::vector<char>& msg ) override;
+         void ack( uint32_t n ) override;
+         void interrupt() override;
+
+      private:
+         /// The next data message, false when the connection closed.
+         bool read_message( std::vector<char>& msg, bool& text );
+         void send_frame( uint8_t opcode, const char* data, size_t size );
+         bool read_exact( void* buf, size_t size );
+
+         int            fd = -1;
+         std::mutex     send_mutex; //acks are sent by the indexer while another thread reads
+         std::string    server_abi;
+         uint32_t       mask_seed;
+   };
+
+   /**
+    * A stream recorded by `recorder`. It starts at the first block from `start_block` or, when
+    * the number of `after` is not 0, right after the message of block `after`, which a store
+    * resuming the recording last applied; that message must be in the recording.
+    */
+   class replay_source : public message_source {
+      public:
+         explicit replay_source( const std::string& path, uint32_t start_block = 0, const ship::block_position& after = {} );
+         ~replay_source() override;
+
+         replay_source( const replay_source& ) = delete;
+         replay_source& operator=( const replay_source& ) = delete;
+
+         bool next( std::vector<char>& msg ) override;
+         void interrupt() override { stopped = 1; }
+
+      private:
+         bool read( std::vector<char>& msg );
+
+         std::FILE*              file = nullptr;
+         std::string             path;
+         uint32_t                start_block;
+         ship::block_position    after;
+         bool                    started = false;
+         volatile sig_atomic_t   stopped = 0;
+   };
+
+   /**
+    * Writes result messages to a new file: a magic number, then each message as its
+    * little-endian uint32 size and its bytes.
+    */
+   class recorder {
+      public:
+         explicit recorder( const std::string& path );
+         ~recorder();
+
+         recorder( const recorder& ) = delete;
+         recorder& operator=( const recorder& ) = delete;
+
+         void write( const std::vector<char>& msg );
+
+      private:
+         std::FILE*     file = nullptr;
+         std::string    path;
+   };
+
+} /// namespace yotta::indexer
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <yotta.token.client.hpp>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/**
+ * The part of the nodeos state history (SHiP) protocol an indexer of contract tables needs.
+ *
+ * A session starts with the server sending its ABI as a text message. The client then sends a
+ * `get_blocks_request_v0` and the server streams one `get_blocks_result_v0` per block, sending
+ * no more than `max_messages_in_flight` messages the client has not acknowledged with a
+ * `get_blocks_ack_request_v0`.
+ *
+ * The deltas of a block are a packed `table_delta[]`, whose `contract_row` table carries the rows
+ * of contract tables. A row not present was removed by the block; a fork is signalled by a block
+ * whose number is not after the last block sent.
+ */
+namespace yotta::ship {
+
+   /// Variant indexes of `request` and `result` in the state history ABI.
+   constexpr uint32_t get_blocks_request_v0     = 1;
+   constexpr uint32_t get_blocks_ack_request_v0 = 2;
+   constexpr uint32_t get_blocks_result_v0      = 1;
+
+   /// Seconds from the unix epoch to the epoch of block timestamps, which count half seconds.
+   constexpr uint32_t block_timestamp_epoch = 946684800;
+
+   struct block_position {
+      uint32_t       block_num = 0;
+      checksum256_t  block_id{};
+   };
+
+   struct get_blocks_request {
+      uint32_t                      start_block_num = 0;
+      uint32_t                      end_block_num = 0xffffffff;
+      uint32_t                      max_messages_in_flight = 0;
+      std::vector<block_position>   have_positions; //reversible blocks the client has, to resume across a fork
+      bool                          irreversible_only = false;
+      bool                          fetch_block = true; //for the block time
+      bool                          fetch_traces = false;
+      bool                          fetch_deltas = true;
+   };
+
+   /**
+    * A `get_blocks_result_v0`. `block` and `deltas` view the message, empty when absent.
+    */
+   struct blocks_result {
+      block_position                   head;
+      block_position                   last_irreversible;
+      std::optional<block_position>    this_block;
+      std::optional<block_position>    prev_block;
+      std::string_view                 block; //packed signed_block
+      std::string_view                 deltas; //packed table_delta[]
+   };
+
+   /**
+    * A row of `contract_row` deltas. `value` views the deltas.
+    */
+   struct contract_row {
+      bool                 present = false;
+      uint64_t             code = 0;
+      uint64_t             scope = 0;
+      uint64_t             table = 0;
+      uint64_t             primary_key = 0;
+      uint64_t             payer = 0;
+      std::string_view     value;
+   };
+
+   inline void write_position( data_writer& w, const block_position& p )
+   {
+      w.write( p.block_num ).write( p.block_id );
+   }
+
+   inline block_position read_position( row_reader& rd )
+   {
+      block_position p;
+      p.block_num = rd.read<uint32_t>();
+      p.block_id  = rd.read<checksum256_t>();
+      return p;
+   }
+
+   inline std::optional<block_position> read_optional_position( row_reader& rd )
+   {
+      if ( !rd.read<uint8_t>() ) return std::nullopt;
+      return read_position( rd );
+   }
+
+   inline std::vector<char> pack_request( const get_blocks_request& r )
+   {
+      data_writer w;
+      w.write_varuint32( get_blocks_request_v0 );
+      w.write( r.start_block_num ).write( r.end_block_num ).write( r.max_messages_in_flight );
+      w.write_varuint32( (uint32_t)r.have_positions.size() );
+      for( const auto& p : r.have_positions ) write_position( w, p );
+      w.write<uint8_t>( r.irreversible_only ).write<uint8_t>( r.fetch_block );
+      w.write<uint8_t>( r.fetch_traces ).write<uint8_t>( r.fetch_deltas );
+      return w.release();
+   }
+
+   inline std::vector<char> pack_ack( uint32_t num_messages )
+   {
+      return data_writer().write_varuint32( get_blocks_ack_request_v0 ).write( num_messages ).release();
+   }
+
+   /**
+    * Decodes a result message. Returns false when it is not a well-formed `get_blocks_result_v0`.
+    */
+   inline bool decode_result( const char* data, size_t size, blocks_result& r )
+   {
+      row_reader rd( data, size );
+      if ( rd.read_varuint32() != get_blocks_result_v0 ) return false;
+      r.head              = read_position( rd );
+      r.last_irreversible = read_position( rd );
+      r.this_block        = read_optional_position( rd );
+      r.prev_block        = read_optional_position( rd );
+      r.block  = rd.read<uint8_t>() ? rd.read_string() : std::string_view();
+      if ( rd.read<uint8_t>() ) rd.read_string(); //traces, not requested
+      r.deltas = rd.read<uint8_t>() ? rd.read_string() : std::string_view();
+      return rd.done();
+   }
+
+   /**
+    * The time in seconds of a packed signed_block, whose header starts with the block timestamp.
+    */
+   inline bool block_time( std::string_view block, uint32_t& seconds )
+   {
+      row_reader rd( block.data(), block.size() );
+      uint32_t slot = rd.read<uint32_t>();
+      if ( !rd.ok() ) return false;
+      seconds = block_timestamp_epoch + slot / 2;
+      return true;
+   }
+
+   /**
+    * Calls `f( const contract_row& )` on each `contract_row_v0` of packed deltas, skipping the
+    * other tables. Returns false when the deltas are malformed; rows before the error have been
+    * passed to `f`.
+    */
+   template<typename F>
+   bool each_contract_row( std::string_view deltas, F&& f )
+   {
+      row_reader rd( deltas.data(), deltas.size() );
+      uint32_t tables = rd.read_varuint32();
+      for( uint32_t t = 0; t < tables && rd.ok(); t++ ) {
+         if ( rd.read_varuint32() != 0 ) return false; //table_delta_v0
+         bool contract_rows = rd.read_string() == "contract_row";
+         uint32_t rows = rd.read_varuint32();
+         for( uint32_t i = 0; i < rows && rd.ok(); i++ ) {
+            bool present = rd.read<uint8_t>();
+            std::string_view data = rd.read_string();
+            if ( !contract_rows || !rd.ok() ) continue;
+
+            row_reader row( data.data(), data.size() );
+            if ( row.read_varuint32() != 0 ) return false; //contract_row_v0
+            contract_row r;
+            r.present     = present;
+            r.code        = row.read<uint64_t>();
+            r.scope       = row.read<uint64_t>();
+            r.table       = row.read<uint64_t>();
+            r.primary_key = row.read<uint64_t>();
+            r.payer       = row.read<uint64_t>();
+            r.value       = row.read_string();
+            if ( !row.done() ) return false;
+            f( r );
+         }
+      }
+      return rd.done();
+   }
+
+   /**
+    * Writer of the deltas of a block, for tests and tools producing a state history stream.
+    * Rows of one table must be added together.
+    */
+   class delta_writer {
+      public:
+         void add_row( std::string_view table, bool present, std::string_view data ) {
+            if ( tables.empty() || tables.back().name != table ) tables.push_back( { std::string( table ), {} } );
+            auto& rows = tables.back().rows;
+            rows.write<uint8_t>( present ).write_string( data );
+            tables.back().count++;
+         }
+
+         void add_contract_row( const contract_row& r ) {
+            data_writer w;
+            w.write_varuint32( 0 );
+            w.write( r.code ).write( r.scope ).write( r.table ).write( r.primary_key ).write( r.payer );
+            w.write_string( r.value );
+            auto data = w.release();
+            add_row( "contract_row", r.present, std::string_view( data.data(), data.size() ) );
+         }
+
+         std::vector<char> release() {
+            data_writer w;
+            w.write_varuint32( (uint32_t)tables.size() );
+            for( auto& t : tables ) {
+               w.write_varuint32( 0 ).write_string( t.name ).write_varuint32( t.count );
+               auto rows = t.rows.release();
+               for( char c : rows ) w.write( c );
+            }
+            tables.clear();
+            return w.release();
+         }
+
+      private:
+         struct table_rows {
+            std::string    name;
+            data_writer    rows;
+            uint32_t       count = 0;
+         };
+
+         std::vector<table_rows> tables;
+   };
+
+   /**
+    * Packs a `get_blocks_result_v0`, for tests and recordings.
+    */
+   inline std::vector<char> pack_result( const blocks_result& r )
+   {
+      data_writer w;
+      w.write_varuint32( get_blocks_result_v0 );
+      write_position( w, r.head );
+      write_position( w, r.last_irreversible );
+      for( const auto* p : { &r.this_block, &r.prev_block } ) {
+         w.write<uint8_t>( p->has_value() );
+         if ( *p ) write_position( w, **p );
+      }
+      w.write<uint8_t>( !r.block.empty() );
+      if ( !r.block.empty() ) w.write_string( r.block );
+      w.write<uint8_t>( 0 ); //traces
+      w.write<uint8_t>( !r.deltas.empty() );
+      if ( !r.deltas.empty() ) w.write_string( r.deltas );
+      return w.release();
+   }
+
+} /// namespace yotta::ship
@@ -0,0 +1,336 @@
+#include "token_store.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+
+namespace yotta::indexer {
+
+   namespace {
+
+      constexpr uint64_t stat_table      = string_to_name( "stat" );
+      constexpr uint64_t accounts_table  = string_to_name( "accounts" );
+      constexpr uint64_t tokenpool_table = string_to_name( "tokenpool" );
+      constexpr uint64_t lockrule_table  = string_to_name( "lockrule" );
+      constexpr uint64_t lockrule2_table = string_to_name( "lockrule2" );
+      constexpr uint64_t acclock_table   = string_to_name( "acclock" );
+      constexpr uint64_t acclock2_table  = string_to_name( "acclock2" );
+      constexpr uint64_t numlock_table   = string_to_name( "numlock" );
+      constexpr uint64_t numlock2_table  = string_to_name( "numlock2" );
+      constexpr uint64_t loanpool_table  = string_to_name( "loanpool" );
+      constexpr uint64_t loanpool2_table = string_to_name( "loanpool2" );
+      constexpr uint64_t subledger_table = string_to_name( "subledger" );
+
+      constexpr uint32_t store_magic   = 0x59494458; //"XDIY"
+      constexpr uint32_t store_version = 1;
+
+      template<typename Row>
+      bool decodes( const std::vector<char>& value ) {
+         Row r;
+         return decode( value.data(), value.size(), r );
+      }
+
+      std::string symbol_code_to_string( uint64_t code ) {
+         std::string s;
+         for( ; code; code >>= 8 ) s.push_back( (char)( code & 0xff ) );
+         return s;
+      }
+
+      void write_key( data_writer& w, const row_key& key ) {
+         w.write( std::get<0>( key ) ).write( std::get<1>( key ) ).write( std::get<2>( key ) );
+      }
+
+      row_key read_key( row_reader& rd ) {
+         uint64_t table = rd.read<uint64_t>();
+         uint64_t scope = rd.read<uint64_t>();
+         return row_key{ table, scope, rd.read<uint64_t>() };
+      }
+
+      void write_row( data_writer& w, const stored_row& row ) {
+         w.write( row.payer ).write_varuint32( (uint32_t)row.value.size() );
+         for( char c : row.value ) w.write( c );
+      }
+
+      stored_row read_row( row_reader& rd ) {
+         stored_row row;
+         row.payer = rd.read<uint64_t>();
+         auto value = rd.read_string();
+         row.value.assign( value.begin(), value.end() );
+         return row;
+      }
+
+      /// The rows of a store as the `Tables` of `holder_from_tables`.
+      struct row_tables {
+         const std::map<row_key, stored_row>& rows;
+
+         bool find( uint64_t table, uint64_t scope, uint64_t pk, std::string_view& value ) {
+            auto it = rows.find( { table, scope, pk } );
+            if ( it == rows.end() ) return false;
+            value = std::string_view( it->second.value.data(), it->second.value.size() );
+            return true;
+         }
+
+         template<typename F>
+         void each( uint64_t table, uint64_t scope, F&& f ) {
+            for( auto it = rows.lower_bound( { table, scope, 0 } );
+                 it != rows.end() && std::get<0>( it->first ) == table && std::get<1>( it->first ) == scope; ++it ) {
+               f( std::string_view( it->second.value.data(), it->second.value.size() ) );
+            }
+         }
+      };
+
+   } /// namespace
+
+   bool is_followed_table( uint64_t table )
+   {
+      switch( table ) {
+         case stat_table: case accounts_table: case tokenpool_table: case lockrule_table: case lockrule2_table:
+         case acclock_table: case acclock2_table: case numlock_table: case numlock2_table: case loanpool_table:
+         case loanpool2_table: case subledger_table:
+            return true;
+      }
+      return false;
+   }
+
+   bool is_valid_row( uint64_t table, const std::vector<char>& value )
+   {
+      const char* data = value.data();
+      size_t      size = value.size();
+      acclock_row lock;
+      numlock_row num;
+      loanpool_row loan;
+      switch( table ) {
+         case stat_table:      return decodes<currency_stat_row>( value );
+         case accounts_table:  return decodes<account_row>( value );
+         case tokenpool_table: return decodes<tokenpool_row>( value );
+         case lockrule_table:  return decodes<lockrule_row>( value );
+         case lockrule2_table: return decodes<lockrule2_row>( value );
+         case acclock_table:   return decodes<acclock_row>( value );
+         case acclock2_table:  return decode_acclock2( data, size, 0, lock );
+         case numlock_table:   return decodes<numlock_row>( value );
+         case numlock2_table:  return decode_numlock2( data, size, 0, num );
+         case loanpool_table:  return decodes<loanpool_row>( value );
+         case loanpool2_table: return decode_loanpool2( data, size, 0, loan );
+         case subledger_table: return decodes<subledger_row>( value );
+      }
+      return false;
+   }
+
+   void token_store::apply( const block_update& b )
+   {
+      std::unique_lock lock( mutex );
+      if ( b.block.block_num <= head_block.block_num ) {
+         undo_from( b.block.block_num );
+      }
+
+      block_undo u{ b.block, {} };
+      u.old.reserve( b.changes.size() );
+      for( const auto& c : b.changes ) {
+         auto it = rows.find( c.key );
+         if ( it == rows.end() ) {
+            if ( !c.present ) continue;
+            u.old.emplace_back( c.key, std::nullopt );
+            rows.emplace( c.key, c.row );
+         } else {
+            u.old.emplace_back( c.key, std::move( it->second ) );
+            if ( c.present ) it->second = c.row;
+            else rows.erase( it );
+         }
+      }
+      undo.push_back( std::move( u ) );
+      head_block = b.block;
+      lib = b.last_irreversible;
+      time = b.time;
+
+      while( !undo.empty() && undo.front().block.block_num <= lib.block_num ) {
+         irreversible_head = undo.front().block;
+         undo.pop_front();
+      }
+   }
+
+   void token_store::undo_from( uint32_t block_num )
+   {
+      if ( block_num <= irreversible_head.block_num ) {
+         throw std::runtime_error( "fork at block " + std::to_string( block_num ) + ", at or before irreversible block "
+                                   + std::to_string( irreversible_head.block_num ) );
+      }
+      while( !undo.empty() && undo.back().block.block_num >= block_num ) {
+         auto& u = undo.back();
+         for( auto it = u.old.rbegin(); it != u.old.rend(); ++it ) {
+            if ( it->second ) rows[it->first] = std::move( *it->second );
+            else rows.erase( it->first );
+         }
+         undo.pop_back();
+      }
+      head_block = undo.empty() ? irreversible_head : undo.back().block;
+   }
+
+   ship::block_position token_store::head()const
+   {
+      std::shared_lock lock( mutex );
+      return head_block;
+   }
+
+   ship::block_position token_store::last_irreversible()const
+   {
+      std::shared_lock lock( mutex );
+      return lib;
+   }
+
+   uint32_t token_store::head_time()const
+   {
+      std::shared_lock lock( mutex );
+      return time;
+   }
+
+   std::vector<ship::block_position> token_store::reversible_blocks()const
+   {
+      std::shared_lock lock( mutex );
+      std::vector<ship::block_position> out;
+      for( const auto& u : undo ) out.push_back( u.block );
+      return out;
+   }
+
+   size_t token_store::size()const
+   {
+      std::shared_lock lock( mutex );
+      return rows.size();
+   }
+
+   bool token_store::find_row( const row_key& key, stored_row& row )const
+   {
+      std::shared_lock lock( mutex );
+      auto it = rows.find( key );
+      if ( it == rows.end() ) return false;
+      row = it->second;
+      return true;
+   }
+
+   void token_store::each_row( const std::function<void( const row_key&, const stored_row& )>& f )const
+   {
+      std::shared_lock lock( mutex );
+      for( const auto& [key, row] : rows ) f( key, row );
+   }
+
+   bool token_store::holder( uint64_t owner, uint64_t code, uint64_t curtime, holder_state& out )const
+   {
+      std::shared_lock lock( mutex );
+      return holder_locked( owner, code, curtime, out );
+   }
+
+   void token_store::each_holder( uint64_t curtime,
+                                  const std::function<void( uint64_t, const asset_t&, const holder_state& )>& f )const
+   {
+      std::shared_lock lock( mutex );
+      for( auto it = rows.lower_bound( { accounts_table, 0, 0 } );
+           it != rows.end() && std::get<0>( it->first ) == accounts_table; ++it ) {
+         uint64_t     owner = std::get<1>( it->first );
+         uint64_t     code = std::get<2>( it->first );
+         account_row  account;
+         holder_state h;
+         if ( !decode( it->second.value.data(), it->second.value.size(), account ) ) continue;
+         if ( holder_locked( owner, code, curtime, h ) ) f( owner, account.balance, h );
+      }
+   }
+
+   /// The rows of the holder are decoded as views into `rows`, under the caller's lock.
+   bool token_store::holder_locked( uint64_t owner, uint64_t code, uint64_t curtime, holder_state& out )const
+   {
+      row_tables tables{ rows };
+      return holder_from_tables( tables, owner, code, curtime, out );
+   }
+
+   void token_store::save( const std::string& path )const
+   {
+      data_writer w;
+      {
+         std::shared_lock lock( mutex );
+         w.write( store_magic ).write( store_version );
+         ship::write_position( w, head_block );
+         ship::write_position( w, irreversible_head );
+         ship::write_position( w, lib );
+         w.write( time );
+         w.write<uint64_t>( rows.size() );
+         for( const auto& [key, row] : rows ) {
+            write_key( w, key );
+            write_row( w, row );
+         }
+         w.write_varuint32( (uint32_t)undo.size() );
+         for( const auto& u : undo ) {
+            ship::write_position( w, u.block );
+            w.write_varuint32( (uint32_t)u.old.size() );
+            for( const auto& [key, old] : u.old ) {
+               write_key( w, key );
+               w.write<uint8_t>( old.has_value() );
+               if ( old ) write_row( w, *old );
+            }
+         }
+      }
+
+      auto bytes = w.release();
+      std::string tmp = path + ".tmp";
+      {
+         std::ofstream out( tmp, std::ios::binary | std::ios::trunc );
+         out.write( bytes.data(), (std::streamsize)bytes.size() );
+         if ( !out.flush() ) throw std::runtime_error( "cannot write " + tmp );
+      }
+      if ( std::rename( tmp.c_str(), path.c_str() ) != 0 ) throw std::runtime_error( "cannot replace " + path );
+   }
+
+   void token_store::load( const std::string& path )
+   {
+      std::ifstream in( path, std::ios::binary );
+      if ( !in ) throw std::runtime_error( "cannot open " + path );
+      std::vector<char> bytes( ( std::istreambuf_iterator<char>( in ) ), std::istreambuf_iterator<char>() );
+
+      row_reader rd( bytes.data(), bytes.size() );
+      if ( rd.read<uint32_t>() != store_magic || rd.read<uint32_t>() != store_version ) {
+         throw std::runtime_error( path + " is not an indexer store" );
+      }
+      std::map<row_key, stored_row> loaded;
+      std::deque<block_undo>        loaded_undo;
+      auto head  = ship::read_position( rd );
+      auto irrev = ship::read_position( rd );
+      auto last  = ship::read_position( rd );
+      uint32_t t = rd.read<uint32_t>();
+      uint64_t n = rd.read<uint64_t>();
+      for( uint64_t i = 0; i < n && rd.ok(); i++ ) {
+         auto key = read_key( rd );
+         auto row = read_row( rd );
+         if ( !is_valid_row( std::get<0>( key ), row.value ) ) throw std::runtime_error( path + " has a malformed row" );
+         loaded.emplace_hint( loaded.end(), key, std::move( row ) );
+      }
+      uint32_t blocks = rd.read_varuint32();
+      for( uint32_t i = 0; i < blocks && rd.ok(); i++ ) {
+         block_undo u{ ship::read_position( rd ), {} };
+         uint32_t entries = rd.read_varuint32();
+         for( uint32_t j = 0; j < entries && rd.ok(); j++ ) {
+            auto key = read_key( rd );
+            std::optional<stored_row> old;
+            if ( rd.read<uint8_t>() ) old = read_row( rd );
+            u.old.emplace_back( key, std::move( old ) );
+         }
+         loaded_undo.push_back( std::move( u ) );
+      }
+      if ( !rd.done() ) throw std::runtime_error( path + " is truncated or malformed" );
+
+      std::unique_lock lock( mutex );
+      rows = std::move( loaded );
+      undo = std::move( loaded_undo );
+      head_block = head;
+      irreversible_head = irrev;
+      lib = last;
+      time = t;
+   }
+
+   void write_holders_csv( const token_store& store, uint64_t curtime, std::ostream& out )
+   {
+      out << "owner,symbol,precision,balance,locked,loaned,allocated,available\n";
+      store.each_holder( curtime, [&]( uint64_t owner, const asset_t& balance, const holder_state& h ) {
+         out << name_to_string( owner ) << ',' << symbol_code_to_string( balance.code() ) << ',' << (int)balance.precision()
+             << ',' << h.balance << ',' << h.locked << ',' << h.loaned << ',' << h.allocated << ',' << h.available() << '\n';
+      } );
+   }
+
+} /// namespace yotta::indexer
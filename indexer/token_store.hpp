@@ -0,0 +1,130 @@
+#pragma once
+
+#include "ship_protocol.hpp"
+#include <deque>
+#include <functional>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/**
+ * The embedded store of the indexer: the rows of the yotta.token tables it follows, as of the
+ * last block applied, and the holder balances computed from them.
+ *
+ * Rows are kept in the contract's binary format and decoded by the native client when queried,
+ * so spendable balances go through `holder_at`, the vesting walk of `get_lock_asset`. Blocks not
+ * yet irreversible keep the rows they replaced, to undo them when a fork replaces the blocks.
+ *
+ * The store is written by one thread, the indexer's, and can be queried from any other.
+ */
+namespace yotta::indexer {
+
+   using row_key = std::tuple<uint64_t, uint64_t, uint64_t>; //table, scope, primary key
+
+   struct stored_row {
+      uint64_t             payer = 0;
+      std::vector<char>    value;
+
+      bool operator==( const stored_row& o )const { return payer == o.payer && value == o.value; }
+   };
+
+   /**
+    * A row written by a block, removed when not present.
+    */
+   struct row_change {
+      row_key              key;
+      bool                 present = false;
+      stored_row           row;
+   };
+
+   /**
+    * The changes of one block to the followed tables.
+    */
+   struct block_update {
+      ship::block_position       block;
+      ship::block_position       last_irreversible;
+      uint32_t                   time = 0; //of the block, in seconds
+      std::vector<row_change>    changes;
+   };
+
+   /// The tables of yotta.token the indexer follows.
+   bool is_followed_table( uint64_t table );
+
+   /**
+    * Decodes the value of a row of a followed table with the native client. Returns false when
+    * it is not a row of the table.
+    */
+   bool is_valid_row( uint64_t table, const std::vector<char>& value );
+
+   class token_store {
+      public:
+         /**
+          * Applies the changes of a block, first undoing the blocks from its number on when it
+          * replaces them after a fork. Throws when the fork reaches an irreversible block.
+          */
+         void apply( const block_update& b );
+
+         /// The last block applied, number 0 before any.
+         ship::block_position head()const;
+         ship::block_position last_irreversible()const;
+         uint32_t head_time()const;
+
+         /// Blocks applied and not irreversible yet, oldest first, to resume a session across a fork.
+         std::vector<ship::block_position> reversible_blocks()const;
+
+         size_t size()const;
+
+         bool find_row( const row_key& key, stored_row& row )const;
+
+         /// Calls `f( key, row )` on every row, in key order.
+         void each_row( const std::function<void( const row_key&, const stored_row& )>& f )const;
+
+         /**
+          * The state of the balance of `owner` in the token of symbol code `code` at `curtime`.
+          * Returns false when the owner has no balance of the token or the token does not exist.
+          */
+         bool holder( uint64_t owner, uint64_t code, uint64_t curtime, holder_state& out )const;
+
+         /**
+          * Calls `f( owner, balance, state )` on every balance of an existing token, at
+          * `curtime`, ordered by owner then symbol code.
+          */
+         void each_holder( uint64_t curtime,
+                           const std::function<void( uint64_t, const asset_t&, const holder_state& )>& f )const;
+
+         /// Writes the rows and the undo state to `path` atomically, through a temporary file.
+         void save( const std::string& path )const;
+
+         /// Replaces the store with a file written by `save`. Throws when it is malformed.
+         void load( const std::string& path );
+
+      private:
+         struct block_undo {
+            ship::block_position                                           block;
+            std::vector<std::pair<row_key, std::optional<stored_row>>>     old; //none when the row was created
+         };
+
+         bool holder_locked( uint64_t owner, uint64_t code, uint64_t curtime, holder_state& out )const;
+         void undo_from( uint32_t block_num );
+
+         mutable std::shared_mutex        mutex;
+         std::map<row_key, stored_row>    rows;
+         std::deque<block_undo>           undo; //of the reversible blocks, oldest first
+         ship::block_position             head_block;
+         ship::block_position             irreversible_head; //the last block applied that left `undo`
+         ship::block_position             lib; //as last reported by the server
+         uint32_t                         time = 0;
+   };
+
+   /**
+    * Writes every holder of `store` at `curtime` as CSV, with a header line:
+    * owner,symbol,precision,balance,locked,loaned,allocated,available, amounts in the token's
+    * smallest unit.
+    */
+   void write_holders_csv( const token_store& store, uint64_t curtime, std::ostream& out );
+
+} /// namespace yotta::indexer
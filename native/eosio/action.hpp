@@ -0,0 +1,97 @@
+#pragma once
+
+#include <eosio/chain.hpp>
+#include <eosio/serialize.hpp>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace eosio {
+
+   struct permission_level {
+      name  actor;
+      name  permission;
+
+      permission_level() {}
+      permission_level( name a, name p ) : actor(a), permission(p) {}
+
+      void pack_to( std::vector<char>& out )const {
+         actor.pack_to( out );
+         permission.pack_to( out );
+      }
+
+      void unpack_from( datastream<const char*>& ds ) {
+         actor.unpack_from( ds );
+         permission.unpack_from( ds );
+      }
+   };
+
+   inline void require_auth( name n )
+   {
+      check( native::chain::current().has_auth( n ), "missing authority of " + n.to_string() );
+   }
+
+   inline bool has_auth( name n )
+   {
+      return native::chain::current().has_auth( n );
+   }
+
+   inline bool is_account( name n )
+   {
+      return native::chain::current().accounts.count( n.value ) != 0;
+   }
+
+   /// Notifications are not delivered in the native build.
+   inline void require_recipient( name n )
+   {
+      (void)n;
+   }
+
+   /**
+    * An inline action, queued on the native chain by `send`.
+    */
+   struct action {
+      eosio::name                      account;
+      eosio::name                      name;
+      std::vector<permission_level>    authorization;
+      std::vector<char>                data;
+
+      action() {}
+
+      template<typename T>
+      action( std::vector<permission_level> auths, eosio::name a, eosio::name n, const T& value )
+      : account(a), name(n), authorization(std::move(auths)), data(pack(value)) {}
+
+      template<typename T>
+      action( const permission_level& auth, eosio::name a, eosio::name n, const T& value )
+      : action( std::vector<permission_level>{ auth }, a, n, value ) {}
+
+      void send()const {
+         native::inline_action a{ account, name, {}, data };
+         for( const auto& p : authorization ) a.actors.push_back( p.actor );
+         native::chain::current().send( std::move( a ) );
+      }
+   };
+
+   template<name::raw Name, auto Action>
+   struct action_wrapper {
+      static constexpr eosio::name action_name = eosio::name( Name );
+
+      eosio::name                      code_name;
+      std::vector<permission_level>    permissions;
+
+      action_wrapper( eosio::name code, std::vector<permission_level> perms ) : code_name(code), permissions(std::move(perms)) {}
+      action_wrapper( eosio::name code, const permission_level& perm ) : code_name(code), permissions{ perm } {}
+
+      template<typename... Args>
+      action to_action( Args&&... args )const {
+         return action( permissions, code_name, action_name, std::make_tuple( std::forward<Args>( args )... ) );
+      }
+
+      template<typename... Args>
+      void send( Args&&... args )const {
+         to_action( std::forward<Args>( args )... ).send();
+      }
+   };
+
+} /// namespace eosio
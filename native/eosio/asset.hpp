@@ -0,0 +1,162 @@
+#pragma once
+
+#include <eosio/serialize.hpp>
+#include <string>
+#include <string_view>
+
+namespace eosio {
+
+   /**
+    * Up to 7 upper case letters, as in the CDT.
+    */
+   class symbol_code {
+      public:
+         constexpr symbol_code() : value(0) {}
+         constexpr explicit symbol_code( uint64_t raw ) : value(raw) {}
+         constexpr explicit symbol_code( std::string_view str ) : value(0) {
+            for( size_t i = str.size(); i > 0; i-- ) {
+               value <<= 8;
+               value |= (uint8_t)str[i - 1];
+            }
+         }
+
+         constexpr uint64_t raw()const { return value; }
+
+         constexpr uint32_t length()const {
+            uint32_t n = 0;
+            for( uint64_t sym = value; sym & 0xff; sym >>= 8 ) n++;
+            return n;
+         }
+
+         constexpr bool is_valid()const {
+            auto sym = value;
+            for( int i = 0; i < 7; i++ ) {
+               char c = (char)( sym & 0xff );
+               if ( !( 'A' <= c && c <= 'Z' ) ) return false;
+               sym >>= 8;
+               if ( !( sym & 0xff ) ) {
+                  do {
+                     sym >>= 8;
+                     if ( sym & 0xff ) return false;
+                     i++;
+                  } while( i < 7 );
+               }
+            }
+            return true;
+         }
+
+         std::string to_string()const {
+            std::string str;
+            for( uint64_t sym = value; sym & 0xff; sym >>= 8 ) str.push_back( (char)( sym & 0xff ) );
+            return str;
+         }
+
+         void pack_to( std::vector<char>& out )const { eosio::pack_to( out, value ); }
+         void unpack_from( datastream<const char*>& ds ) { eosio::unpack_from( ds, value ); }
+
+         friend constexpr bool operator==( const symbol_code& a, const symbol_code& b ) { return a.value == b.value; }
+         friend constexpr bool operator!=( const symbol_code& a, const symbol_code& b ) { return a.value != b.value; }
+         friend constexpr bool operator<( const symbol_code& a, const symbol_code& b ) { return a.value < b.value; }
+
+      private:
+         uint64_t value;
+   };
+
+   /**
+    * A symbol code and a precision, as in the CDT.
+    */
+   class symbol {
+      public:
+         constexpr symbol() : value(0) {}
+         constexpr explicit symbol( uint64_t raw ) : value(raw) {}
+         constexpr symbol( symbol_code sc, uint8_t precision ) : value( ( sc.raw() << 8 ) | precision ) {}
+         constexpr symbol( std::string_view code, uint8_t precision ) : symbol( symbol_code( code ), precision ) {}
+
+         constexpr uint64_t raw()const { return value; }
+         constexpr symbol_code code()const { return symbol_code( value >> 8 ); }
+         constexpr uint8_t precision()const { return value & 0xff; }
+         constexpr bool is_valid()const { return code().is_valid(); }
+         constexpr explicit operator bool()const { return value != 0; }
+
+         void pack_to( std::vector<char>& out )const { eosio::pack_to( out, value ); }
+         void unpack_from( datastream<const char*>& ds ) { eosio::unpack_from( ds, value ); }
+
+         friend constexpr bool operator==( const symbol& a, const symbol& b ) { return a.value == b.value; }
+         friend constexpr bool operator!=( const symbol& a, const symbol& b ) { return a.value != b.value; }
+         friend constexpr bool operator<( const symbol& a, const symbol& b ) { return a.value < b.value; }
+
+      private:
+         uint64_t value;
+   };
+
+   /**
+    * An amount of a token, with the range checks of the CDT.
+    */
+   struct asset {
+      static constexpr int64_t max_amount = ( 1LL << 62 ) - 1;
+
+      int64_t        amount = 0;
+      eosio::symbol  symbol;
+
+      asset() {}
+      asset( int64_t a, eosio::symbol s ) : amount(a), symbol(s) {
+         check( is_amount_within_range(), "magnitude of asset amount must be less than 2^62" );
+         check( symbol.is_valid(), "invalid symbol name" );
+      }
+
+      bool is_amount_within_range()const { return -max_amount <= amount && amount <= max_amount; }
+      bool is_valid()const { return is_amount_within_range() && symbol.is_valid(); }
+
+      asset operator-()const {
+         asset r = *this;
+         r.amount = -r.amount;
+         return r;
+      }
+
+      asset& operator-=( const asset& a ) {
+         check( a.symbol == symbol, "attempt to subtract asset with different symbol" );
+         amount -= a.amount;
+         check( -max_amount <= amount, "subtraction underflow" );
+         check( amount <= max_amount, "subtraction overflow" );
+         return *this;
+      }
+
+      asset& operator+=( const asset& a ) {
+         check( a.symbol == symbol, "attempt to add asset with different symbol" );
+         amount += a.amount;
+         check( -max_amount <= amount, "addition underflow" );
+         check( amount <= max_amount, "addition overflow" );
+         return *this;
+      }
+
+      friend asset operator+( const asset& a, const asset& b ) {
+         asset r = a;
+         r += b;
+         return r;
+      }
+
+      friend asset operator-( const asset& a, const asset& b ) {
+         asset r = a;
+         r -= b;
+         return r;
+      }
+
+      void pack_to( std::vector<char>& out )const {
+         eosio::pack_to( out, amount );
+         symbol.pack_to( out );
+      }
+
+      void unpack_from( datastream<const char*>& ds ) {
+         eosio::unpack_from( ds, amount );
+         symbol.unpack_from( ds );
+      }
+
+      friend bool operator==( const asset& a, const asset& b ) { return a.symbol == b.symbol && a.amount == b.amount; }
+      friend bool operator!=( const asset& a, const asset& b ) { return !( a == b ); }
+      friend bool operator<( const asset& a, const asset& b ) {
+         check( a.symbol == b.symbol, "comparison of assets with different symbols is not allowed" );
+         return a.amount < b.amount;
+      }
+   };
+
+} /// namespace eosio
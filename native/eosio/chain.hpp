@@ -0,0 +1,250 @@
+#pragma once
+
+#include <eosio/name.hpp>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * The chain state behind the native CDT headers: contract tables, accounts, authorizations of
+ * the running action, the clock and the inline actions sent.
+ *
+ * Contract code runs inside `chain::push`, which makes the chain current for the thread, so that
+ * `multi_index`, `require_auth` or `current_time_point` reach it as they reach nodeos in a wasm
+ * build. A failed `check` rolls the transaction back through the database's undo journal.
+ */
+namespace eosio::native {
+
+   /// code, table, scope
+   struct table_id {
+      uint64_t    code = 0;
+      uint64_t    table = 0;
+      uint64_t    scope = 0;
+
+      friend bool operator<( const table_id& a, const table_id& b ) {
+         return std::tie( a.code, a.table, a.scope ) < std::tie( b.code, b.table, b.scope );
+      }
+      friend bool operator==( const table_id& a, const table_id& b ) {
+         return a.code == b.code && a.table == b.table && a.scope == b.scope;
+      }
+   };
+
+   struct stored_row {
+      uint64_t             payer = 0;
+      std::vector<char>    value;
+   };
+
+   struct table {
+      std::map<uint64_t, stored_row> rows; //by primary key
+   };
+
+   /**
+    * Tables of every contract, with an undo journal of the writes of the running transaction and
+    * the keys written since the owner last took them.
+    */
+   class database {
+      public:
+         using written_key = std::pair<table_id, uint64_t>;
+
+         const table* find( const table_id& id )const {
+            auto it = tables.find( id );
+            return it == tables.end() ? nullptr : &it->second;
+         }
+
+         table* find( const table_id& id ) {
+            auto it = tables.find( id );
+            return it == tables.end() ? nullptr : &it->second;
+         }
+
+         /// The table, created empty when it does not exist.
+         table& get( const table_id& id ) { return tables[id]; }
+
+         void store( table& t, const table_id& id, uint64_t pk, uint64_t payer, std::vector<char> value ) {
+            check( payer != 0, "must specify a valid account to pay for new record" );
+            auto [it, inserted] = t.rows.try_emplace( pk );
+            check( inserted, "could not insert object, most likely a uniqueness constraint was violated" );
+            it->second.payer = payer;
+            it->second.value = std::move( value );
+            undo.push_back( undo_entry{ &t, pk, std::nullopt } );
+            written.emplace_back( id, pk );
+         }
+
+         /// Replaces a row, a payer of 0 keeps the row's payer.
+         void update( table& t, const table_id& id, uint64_t pk, uint64_t payer, std::vector<char> value ) {
+            auto it = t.rows.find( pk );
+            check( it != t.rows.end(), "db_update_i64: object is not in the table" );
+            stored_row row{ payer ? payer : it->second.payer, std::move( value ) };
+            std::swap( row, it->second );
+            undo.push_back( undo_entry{ &t, pk, std::move( row ) } );
+            written.emplace_back( id, pk );
+         }
+
+         void remove( table& t, const table_id& id, uint64_t pk ) {
+            auto it = t.rows.find( pk );
+            check( it != t.rows.end(), "db_remove_i64: object is not in the table" );
+            undo.push_back( undo_entry{ &t, pk, std::move( it->second ) } );
+            t.rows.erase( it );
+            written.emplace_back( id, pk );
+         }
+
+         /// Writes since a savepoint are undone by `rollback` and kept by `commit`.
+         size_t savepoint()const { return undo.size(); }
+
+         void rollback( size_t sp ) {
+            while( undo.size() > sp ) {
+               auto& u = undo.back();
+               if ( u.old ) {
+                  u.t->rows[u.pk] = std::move( *u.old );
+               } else {
+                  u.t->rows.erase( u.pk );
+               }
+               undo.pop_back();
+            }
+         }
+
+         void commit( size_t sp ) { undo.resize( sp ); }
+
+         /// Keys written since the last call, rolled back writes included. The caller clears it.
+         std::vector<written_key>& written_keys() { return written; }
+
+         const std::map<table_id, table>& all()const { return tables; }
+
+         /// Removes every row of the tables of `code`, outside of any transaction.
+         void clear( uint64_t code ) {
+            for( auto& [id, t] : tables ) {
+               if ( id.code == code ) t.rows.clear();
+            }
+            undo.clear();
+            written.clear();
+         }
+
+      private:
+         struct undo_entry {
+            table*                     t;
+            uint64_t                   pk;
+            std::optional<stored_row>  old; //none when the row was created
+         };
+
+         std::map<table_id, table>  tables;
+         std::vector<undo_entry>    undo;
+         std::vector<written_key>   written;
+   };
+
+   /**
+    * An inline action sent by the running action.
+    */
+   struct inline_action {
+      name                 account;
+      name                 action;
+      std::vector<name>    actors; //of its authorization
+      std::vector<char>    data;
+   };
+
+   class chain {
+      public:
+         using handler = std::function<void( chain&, const inline_action& )>;
+
+         database             db;
+         std::set<uint64_t>   accounts; //which exist, for `is_account`
+         uint64_t             time_us = 0; //of the block, returned by `current_time_point`
+
+         static chain& current() {
+            check( current_chain != nullptr, "no native chain is running an action" );
+            return *current_chain;
+         }
+
+         void set_time( uint64_t seconds ) { time_us = seconds * 1000000; }
+
+         /// Runs the inline actions sent to `account::action`; others are dropped.
+         void on_action( name account, name action, handler h ) {
+            handlers[{ account.value, action.value }] = std::move( h );
+         }
+
+         /**
+          * Runs `f` as an action of `receiver` authorized by `actors`, then the inline actions it
+          * sends, as one transaction. Returns false, every change undone, when a check fails.
+          */
+         template<typename F>
+         bool push( name receiver, std::vector<name> actors, F&& f ) {
+            size_t sp = db.savepoint();
+            chain* prev = current_chain;
+            current_chain = this;
+            queue.clear();
+            bool ok = true;
+            try {
+               run( receiver, std::move( actors ), f );
+               for( size_t i = 0; i < queue.size(); i++ ) {
+                  inline_action a = std::move( queue[i] );
+                  auto h = handlers.find( { a.account.value, a.action.value } );
+                  if ( h == handlers.end() ) continue;
+                  run( a.account, a.actors, [&] { h->second( *this, a ); } );
+               }
+               db.commit( sp );
+            } catch( const assertion_failure& ) {
+               db.rollback( sp );
+               ok = false;
+            } catch( ... ) {
+               db.rollback( sp );
+               queue.clear();
+               current_chain = prev;
+               throw;
+            }
+            queue.clear();
+            current_chain = prev;
+            return ok;
+         }
+
+         /// Runs `f` with the chain current outside of any transaction, e.g. to read tables with contract code.
+         template<typename F>
+         void call( F&& f ) {
+            chain* prev = current_chain;
+            current_chain = this;
+            try {
+               f();
+            } catch( ... ) {
+               current_chain = prev;
+               throw;
+            }
+            current_chain = prev;
+         }
+
+         name receiver()const { return running_receiver; }
+
+         bool has_auth( name n )const {
+            for( const auto& a : running_actors ) {
+               if ( a == n ) return true;
+            }
+            return false;
+         }
+
+         void send( inline_action a ) { queue.push_back( std::move( a ) ); }
+
+      private:
+         template<typename F>
+         void run( name receiver, std::vector<name> actors, F&& f ) {
+            std::swap( running_receiver, receiver );
+            std::swap( running_actors, actors );
+            try {
+               f();
+            } catch( ... ) {
+               running_receiver = receiver;
+               running_actors = std::move( actors );
+               throw;
+            }
+            running_receiver = receiver;
+            running_actors = std::move( actors );
+         }
+
+         name                                                  running_receiver;
+         std::vector<name>                                     running_actors;
+         std::vector<inline_action>                            queue;
+         std::map<std::pair<uint64_t, uint64_t>, handler>      handlers;
+
+         static inline thread_local chain* current_chain = nullptr;
+   };
+
+} /// namespace eosio::native
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace eosio {
+
+   namespace native {
+
+      /**
+       * A failed `check` or chain assertion, which aborts the transaction.
+       */
+      struct assertion_failure : std::runtime_error {
+         using std::runtime_error::runtime_error;
+      };
+
+   } /// namespace native
+
+   inline void check( bool pred, const char* msg )
+   {
+      if ( !pred ) throw native::assertion_failure( msg );
+   }
+
+   inline void check( bool pred, const std::string& msg )
+   {
+      if ( !pred ) throw native::assertion_failure( msg );
+   }
+
+} /// namespace eosio
@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * Native stand-in for the CDT headers, to build contract code with a host compiler.
+ *
+ * It covers what yotta.token uses, with the CDT's interface and the chain's checks, over the
+ * in-memory chain of `eosio/chain.hpp`. Only the chain state is emulated: there is no wasm, no
+ * resource billing, no notification delivery and no signature recovery.
+ */
+#include <eosio/action.hpp>
+#include <eosio/asset.hpp>
+#include <eosio/chain.hpp>
+#include <eosio/check.hpp>
+#include <eosio/contract.hpp>
+#include <eosio/crypto.hpp>
+#include <eosio/multi_index.hpp>
+#include <eosio/name.hpp>
+#include <eosio/serialize.hpp>
+#include <eosio/singleton.hpp>
+#include <eosio/system.hpp>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <string>
+#include <vector>
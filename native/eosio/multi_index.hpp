@@ -0,0 +1,349 @@
+#pragma once
+
+#include <eosio/chain.hpp>
+#include <eosio/serialize.hpp>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace eosio {
+
+   static constexpr name same_payer{};
+
+   template<name::raw IndexName, typename Extractor>
+   struct indexed_by {
+      static constexpr name index_name = name( IndexName );
+      using secondary_extractor_type = Extractor;
+   };
+
+   template<class Class, typename Type, Type (Class::*PtrToMemberFunction)()const>
+   struct const_mem_fun {
+      using result_type = std::remove_reference_t<Type>;
+
+      Type operator()( const Class& x )const { return ( x.*PtrToMemberFunction )(); }
+   };
+
+   namespace native::detail {
+
+      template<name::raw IndexName, typename... Indices>
+      struct find_index;
+
+      template<name::raw IndexName, typename First, typename... Rest>
+      struct find_index<IndexName, First, Rest...> {
+         using type = std::conditional_t<First::index_name == name( IndexName ), First,
+                                         typename find_index<IndexName, Rest...>::type>;
+      };
+
+      template<name::raw IndexName>
+      struct find_index<IndexName> {
+         using type = void;
+      };
+
+   } /// namespace native::detail
+
+   /**
+    * A table of the native chain with the interface and the semantics of the CDT's multi_index:
+    * rows are cached per instance, so a reference to a row stays valid until it is erased, and
+    * writes are checked against the running contract.
+    *
+    * Secondary indices are not stored: each step of an index walk scans the rows of the scope,
+    * which is enough for the small scopes contracts walk this way.
+    */
+   template<name::raw TableName, typename T, typename... Indices>
+   class multi_index {
+      public:
+         class const_iterator {
+            public:
+               using iterator_category = std::bidirectional_iterator_tag;
+               using value_type = const T;
+               using difference_type = std::ptrdiff_t;
+               using pointer = const T*;
+               using reference = const T&;
+
+               const_iterator() {}
+
+               const T& operator*()const {
+                  check( _item != nullptr, "cannot dereference end iterator" );
+                  return *_item;
+               }
+               const T* operator->()const { return &**this; }
+
+               const_iterator& operator++() {
+                  check( _item != nullptr, "cannot increment end iterator" );
+                  _item = _multidx->next( _item->primary_key() );
+                  return *this;
+               }
+               const_iterator operator++( int ) {
+                  const_iterator r = *this;
+                  ++*this;
+                  return r;
+               }
+
+               const_iterator& operator--() {
+                  _item = _multidx->prev( _item, "cannot decrement iterator at beginning of table" );
+                  return *this;
+               }
+               const_iterator operator--( int ) {
+                  const_iterator r = *this;
+                  --*this;
+                  return r;
+               }
+
+               friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a._item == b._item; }
+               friend bool operator!=( const const_iterator& a, const const_iterator& b ) { return a._item != b._item; }
+
+            private:
+               friend class multi_index;
+               const_iterator( const multi_index* idx, const T* item ) : _multidx(idx), _item(item) {}
+
+               const multi_index*   _multidx = nullptr;
+               const T*             _item = nullptr;
+         };
+
+         /**
+          * A secondary index, read from the rows of the scope when it is walked.
+          */
+         template<name::raw IndexName, typename Extractor>
+         class index {
+            public:
+               using secondary_key_type = std::decay_t<decltype( Extractor()( std::declval<const T&>() ) )>;
+
+               class const_iterator {
+                  public:
+                     using iterator_category = std::bidirectional_iterator_tag;
+                     using value_type = const T;
+                     using difference_type = std::ptrdiff_t;
+                     using pointer = const T*;
+                     using reference = const T&;
+
+                     const_iterator() {}
+
+                     const T& operator*()const {
+                        check( _item != nullptr, "cannot dereference end iterator" );
+                        return *_item;
+                     }
+                     const T* operator->()const { return &**this; }
+
+                     const_iterator& operator++() {
+                        check( _item != nullptr, "cannot increment end iterator" );
+                        _item = _idx->next( *_item );
+                        return *this;
+                     }
+                     const_iterator operator++( int ) {
+                        const_iterator r = *this;
+                        ++*this;
+                        return r;
+                     }
+
+                     friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a._item == b._item; }
+                     friend bool operator!=( const const_iterator& a, const const_iterator& b ) { return a._item != b._item; }
+
+                  private:
+                     friend class index;
+                     const_iterator( const index* idx, const T* item ) : _idx(idx), _item(item) {}
+
+                     const index*   _idx = nullptr;
+                     const T*       _item = nullptr;
+               };
+
+               explicit index( const multi_index* multidx ) : _multidx(multidx) {}
+
+               const_iterator begin()const { return lower_bound( secondary_key_type{} ); }
+               const_iterator end()const { return const_iterator( this, nullptr ); }
+
+               const_iterator lower_bound( const secondary_key_type& secondary )const {
+                  return const_iterator( this, first_after( secondary, 0, true ) );
+               }
+
+               const_iterator find( const secondary_key_type& secondary )const {
+                  auto lb = lower_bound( secondary );
+                  if ( lb == end() || Extractor()( *lb ) != secondary ) return end();
+                  return lb;
+               }
+
+               const_iterator erase( const_iterator itr ) {
+                  check( itr != end(), "cannot pass end iterator to erase" );
+                  const T& obj = *itr;
+                  ++itr;
+                  const_cast<multi_index*>( _multidx )->erase( obj );
+                  return itr;
+               }
+
+            private:
+               /// The row of the least (secondary, primary) after `(secondary, pk)`, or at it if `inclusive`.
+               const T* first_after( const secondary_key_type& secondary, uint64_t pk, bool inclusive )const {
+                  const T* best = nullptr;
+                  _multidx->each_row( [&]( const T& obj ) {
+                     auto s = Extractor()( obj );
+                     uint64_t p = obj.primary_key();
+                     bool after = secondary < s || ( s == secondary && ( inclusive ? p >= pk : p > pk ) );
+                     if ( !after ) return;
+                     if ( !best ) {
+                        best = &obj;
+                        return;
+                     }
+                     auto bs = Extractor()( *best );
+                     if ( s < bs || ( s == bs && p < (uint64_t)best->primary_key() ) ) best = &obj;
+                  } );
+                  return best;
+               }
+
+               const T* next( const T& obj )const {
+                  return first_after( Extractor()( obj ), obj.primary_key(), false );
+               }
+
+               const multi_index* _multidx;
+         };
+
+         multi_index( name code, uint64_t scope ) : _code(code), _scope(scope) {}
+
+         name get_code()const { return _code; }
+         uint64_t get_scope()const { return _scope; }
+
+         const_iterator begin()const { return lower_bound( 0 ); }
+         const_iterator end()const { return const_iterator( this, nullptr ); }
+
+         const_iterator lower_bound( uint64_t pk )const {
+            const native::table* t = find_table();
+            if ( !t ) return end();
+            auto it = t->rows.lower_bound( pk );
+            return const_iterator( this, it == t->rows.end() ? nullptr : load( it->first, it->second ) );
+         }
+
+         const_iterator upper_bound( uint64_t pk )const {
+            return const_iterator( this, next( pk ) );
+         }
+
+         const_iterator find( uint64_t pk )const {
+            const native::table* t = find_table();
+            if ( !t ) return end();
+            auto it = t->rows.find( pk );
+            return const_iterator( this, it == t->rows.end() ? nullptr : load( it->first, it->second ) );
+         }
+
+         const T& get( uint64_t pk, const char* error_msg = "unable to find key" )const {
+            auto it = find( pk );
+            check( it != end(), error_msg );
+            return *it;
+         }
+
+         uint64_t available_primary_key()const {
+            const native::table* t = find_table();
+            if ( !t || t->rows.empty() ) return 0;
+            uint64_t last = t->rows.rbegin()->first;
+            check( last < std::numeric_limits<uint64_t>::max() - 1, "next primary key in table is at autoincrement limit" );
+            return last + 1;
+         }
+
+         template<typename Lambda>
+         const_iterator emplace( name payer, Lambda&& constructor ) {
+            check( _code == native::chain::current().receiver(), "cannot create objects in table of another contract" );
+            auto obj = std::make_unique<T>();
+            constructor( *obj );
+            uint64_t pk = obj->primary_key();
+            auto& db = native::chain::current().db;
+            native::table& t = db.get( id() );
+            db.store( t, id(), pk, payer.value, pack( *obj ) );
+            _table = &t;
+            const T* item = obj.get();
+            _cache[pk] = std::move( obj );
+            return const_iterator( this, item );
+         }
+
+         template<typename Lambda>
+         void modify( const_iterator itr, name payer, Lambda&& updater ) {
+            check( itr != end(), "cannot pass end iterator to modify" );
+            modify( *itr, payer, std::forward<Lambda>( updater ) );
+         }
+
+         template<typename Lambda>
+         void modify( const T& obj, name payer, Lambda&& updater ) {
+            check( _code == native::chain::current().receiver(), "cannot modify objects in table of another contract" );
+            uint64_t pk = obj.primary_key();
+            auto c = _cache.find( pk );
+            check( c != _cache.end() && c->second.get() == &obj, "object passed to modify is not in multi_index" );
+            T& mutable_obj = *c->second;
+            updater( mutable_obj );
+            check( pk == (uint64_t)mutable_obj.primary_key(), "updater cannot change primary key when modifying an object" );
+            auto& db = native::chain::current().db;
+            db.update( db.get( id() ), id(), pk, payer.value, pack( mutable_obj ) );
+         }
+
+         const_iterator erase( const_iterator itr ) {
+            check( itr != end(), "cannot pass end iterator to erase" );
+            const T& obj = *itr;
+            ++itr;
+            erase( obj );
+            return itr;
+         }
+
+         void erase( const T& obj ) {
+            check( _code == native::chain::current().receiver(), "cannot erase objects in table of another contract" );
+            uint64_t pk = obj.primary_key();
+            auto c = _cache.find( pk );
+            check( c != _cache.end() && c->second.get() == &obj, "object passed to erase is not in multi_index" );
+            auto& db = native::chain::current().db;
+            db.remove( db.get( id() ), id(), pk );
+            _cache.erase( c );
+         }
+
+         template<name::raw IndexName>
+         auto get_index()const {
+            using index_t = typename native::detail::find_index<IndexName, Indices...>::type;
+            static_assert( !std::is_void_v<index_t>, "name provided is not the name of any secondary index within multi_index" );
+            return index<IndexName, typename index_t::secondary_extractor_type>( this );
+         }
+
+      private:
+         native::table_id id()const { return native::table_id{ _code.value, static_cast<uint64_t>( TableName ), _scope }; }
+
+         const native::table* find_table()const {
+            if ( !_table ) _table = native::chain::current().db.find( id() );
+            return _table;
+         }
+
+         const T* load( uint64_t pk, const native::stored_row& row )const {
+            auto c = _cache.find( pk );
+            if ( c != _cache.end() ) return c->second.get();
+            auto obj = std::make_unique<T>();
+            datastream<const char*> ds( row.value.data(), row.value.size() );
+            unpack_from( ds, *obj );
+            const T* item = obj.get();
+            _cache.emplace( pk, std::move( obj ) );
+            return item;
+         }
+
+         const T* next( uint64_t pk )const {
+            const native::table* t = find_table();
+            if ( !t ) return nullptr;
+            auto it = t->rows.upper_bound( pk );
+            return it == t->rows.end() ? nullptr : load( it->first, it->second );
+         }
+
+         const T* prev( const T* item, const char* error_msg )const {
+            const native::table* t = find_table();
+            check( t != nullptr && !t->rows.empty(), error_msg );
+            auto it = item ? t->rows.lower_bound( item->primary_key() ) : t->rows.end();
+            check( it != t->rows.begin(), error_msg );
+            --it;
+            return load( it->first, it->second );
+         }
+
+         template<typename F>
+         void each_row( F&& f )const {
+            const native::table* t = find_table();
+            if ( !t ) return;
+            for( const auto& [pk, row] : t->rows ) f( *load( pk, row ) );
+         }
+
+         name                                            _code;
+         uint64_t                                        _scope;
+         mutable native::table*                          _table = nullptr;
+         mutable std::map<uint64_t, std::unique_ptr<T>>  _cache;
+   };
+
+} /// namespace eosio
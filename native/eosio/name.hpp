@@ -0,0 +1,66 @@
+#pragma once
+
+#include <eosio/serialize.hpp>
+#include <string>
+#include <string_view>
+
+namespace eosio {
+
+   /**
+    * An account, table, scope or action name, as in the CDT.
+    */
+   struct name {
+      enum class raw : uint64_t {};
+
+      uint64_t value = 0;
+
+      constexpr name() : value(0) {}
+      constexpr explicit name( uint64_t v ) : value(v) {}
+      constexpr explicit name( raw r ) : value(static_cast<uint64_t>(r)) {}
+      constexpr explicit name( std::string_view str ) : value(0) {
+         for( size_t i = 0; i < 13 && i < str.size(); i++ ) {
+            uint64_t c = char_to_value( str[i] );
+            if ( i < 12 ) {
+               value |= ( c & 0x1f ) << ( 64 - 5 * ( i + 1 ) );
+            } else {
+               value |= c & 0x0f;
+            }
+         }
+      }
+
+      static constexpr uint64_t char_to_value( char c ) {
+         if ( c >= '1' && c <= '5' ) return (c - '1') + 1;
+         if ( c >= 'a' && c <= 'z' ) return (c - 'a') + 6;
+         return 0;
+      }
+
+      constexpr operator raw()const { return raw(value); }
+      constexpr explicit operator bool()const { return value != 0; }
+
+      std::string to_string()const {
+         static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+         std::string str( 13, '.' );
+         uint64_t tmp = value;
+         for( uint32_t i = 0; i <= 12; ++i ) {
+            str[12 - i] = charmap[tmp & ( i == 0 ? 0x0f : 0x1f )];
+            tmp >>= ( i == 0 ? 4 : 5 );
+         }
+         size_t last = str.find_last_not_of( '.' );
+         str.resize( last == std::string::npos ? 0 : last + 1 );
+         return str;
+      }
+
+      void pack_to( std::vector<char>& out )const { eosio::pack_to( out, value ); }
+      void unpack_from( datastream<const char*>& ds ) { eosio::unpack_from( ds, value ); }
+
+      friend constexpr bool operator==( const name& a, const name& b ) { return a.value == b.value; }
+      friend constexpr bool operator!=( const name& a, const name& b ) { return a.value != b.value; }
+      friend constexpr bool operator<( const name& a, const name& b ) { return a.value < b.value; }
+   };
+
+} /// namespace eosio
+
+constexpr eosio::name operator""_n( const char* s, std::size_t n )
+{
+   return eosio::name( std::string_view( s, n ) );
+}
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <eosio/check.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+typedef __int128          int128_t;
+typedef unsigned __int128 uint128_t;
+
+/**
+ * The eosio binary serialization of the native build.
+ *
+ * Structs are serialized field by field in declaration order like the CDT does, without
+ * `EOSLIB_SERIALIZE`: a struct of up to 20 public fields is reflected with structured bindings.
+ * Types which are not aggregates (`name`, `asset`, ...) serialize themselves with `pack_to` and
+ * `unpack_from` members.
+ */
+namespace eosio {
+
+   template<typename T>
+   class datastream;
+
+   /**
+    * Reading stream over a serialized buffer.
+    */
+   template<>
+   class datastream<const char*> {
+      public:
+         datastream( const char* start, size_t size ) : _start(start), _pos(start), _end(start + size) {}
+
+         void read( char* d, size_t n ) {
+            check( n <= remaining(), "datastream attempted to read past the end" );
+            if ( n ) std::memcpy( d, _pos, n );
+            _pos += n;
+         }
+
+         const char* pos()const { return _pos; }
+         size_t tellp()const { return _pos - _start; }
+         size_t remaining()const { return _end - _pos; }
+
+      private:
+         const char* _start;
+         const char* _pos;
+         const char* _end;
+   };
+
+   namespace native::detail {
+
+      template<typename T> struct is_vector : std::false_type {};
+      template<typename T> struct is_vector<std::vector<T>> : std::true_type {};
+      template<typename T> struct is_array : std::false_type {};
+      template<typename T, size_t N> struct is_array<std::array<T, N>> : std::true_type {};
+      template<typename T> struct is_tuple : std::false_type {};
+      template<typename... T> struct is_tuple<std::tuple<T...>> : std::true_type {};
+      template<typename A, typename B> struct is_tuple<std::pair<A, B>> : std::true_type {};
+
+      template<typename T, typename = void> struct has_pack_member : std::false_type {};
+      template<typename T>
+      struct has_pack_member<T, std::void_t<decltype( std::declval<const T&>().pack_to( std::declval<std::vector<char>&>() ) )>>
+         : std::true_type {};
+
+      template<typename T>
+      constexpr bool is_scalar = std::is_arithmetic_v<T> || std::is_same_v<T, int128_t> || std::is_same_v<T, uint128_t>;
+
+      /// Converts to any field type, to count the fields of an aggregate.
+      struct any_field {
+         template<typename T> operator T()const;
+      };
+
+      template<typename T, typename Seq, typename = void>
+      struct braces_constructible : std::false_type {};
+      template<typename T, size_t... I>
+      struct braces_constructible<T, std::index_sequence<I...>, std::void_t<decltype( T{ ( (void)I, any_field{} )... } )>>
+         : std::true_type {};
+
+      template<typename T, size_t N = 20>
+      constexpr size_t field_count()
+      {
+         if constexpr ( N == 0 ) {
+            return 0;
+         } else if constexpr ( braces_constructible<T, std::make_index_sequence<N>>::value ) {
+            return N;
+         } else {
+            return field_count<T, N - 1>();
+         }
+      }
+
+      /// The fields of an aggregate as a tuple of references.
+      template<typename T>
+      auto fields( T& v )
+      {
+         constexpr size_t n = field_count<std::remove_const_t<T>>();
+         static_assert( n > 0, "type cannot be reflected, it needs pack_to and unpack_from members" );
+         if constexpr ( n == 1 ) {
+            auto& [a] = v;
+            return std::tie( a );
+         } else if constexpr ( n == 2 ) {
+            auto& [a, b] = v;
+            return std::tie( a, b );
+         } else if constexpr ( n == 3 ) {
+            auto& [a, b, c] = v;
+            return std::tie( a, b, c );
+         } else if constexpr ( n == 4 ) {
+            auto& [a, b, c, d] = v;
+            return std::tie( a, b, c, d );
+         } else if constexpr ( n == 5 ) {
+            auto& [a, b, c, d, e] = v;
+            return std::tie( a, b, c, d, e );
+         } else if constexpr ( n == 6 ) {
+            auto& [a, b, c, d, e, f] = v;
+            return std::tie( a, b, c, d, e, f );
+         } else if constexpr ( n == 7 ) {
+            auto& [a, b, c, d, e, f, g] = v;
+            return std::tie( a, b, c, d, e, f, g );
+         } else if constexpr ( n == 8 ) {
+            auto& [a, b, c, d, e, f, g, h] = v;
+            return std::tie( a, b, c, d, e, f, g, h );
+         } else if constexpr ( n == 9 ) {
+            auto& [a, b, c, d, e, f, g, h, i] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i );
+         } else if constexpr ( n == 10 ) {
+            auto& [a, b, c, d, e, f, g, h, i, j] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j );
+         } else if constexpr ( n == 11 ) {
+            auto& [a, b, c, d, e, f, g, h, i, j, k] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j, k );
+         } else if constexpr ( n == 12 ) {
+            auto& [a, b, c, d, e, f, g, h, i, j, k, l] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j, k, l );
+         } else if constexpr ( n == 13 ) {
+            auto& [a, b, c, d, e, f, g, h, i, j, k, l, m] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j, k, l, m );
+         } else if constexpr ( n == 14 ) {
+            auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j, k, l, m, o );
+         } else if constexpr ( n == 15 ) {
+            auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j, k, l, m, o, p );
+         } else if constexpr ( n == 16 ) {
+            auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q );
+         } else if constexpr ( n == 17 ) {
+            auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r );
+         } else if constexpr ( n == 18 ) {
+            auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s );
+         } else if constexpr ( n == 19 ) {
+            auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t );
+         } else {
+            auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u] = v;
+            return std::tie( a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q, r, s, t, u );
+         }
+      }
+
+   } /// namespace native::detail
+
+   inline void pack_varuint32( std::vector<char>& out, uint32_t v )
+   {
+      do {
+         uint8_t b = v & 0x7f;
+         v >>= 7;
+         b |= ( v > 0 ) << 7;
+         out.push_back( (char)b );
+      } while( v );
+   }
+
+   inline uint32_t unpack_varuint32( datastream<const char*>& ds )
+   {
+      uint32_t v = 0;
+      uint8_t  b = 0;
+      int      by = 0;
+      do {
+         check( by < 35, "varuint32 is too long" );
+         ds.read( (char*)&b, 1 );
+         v |= uint32_t(b & 0x7f) << by;
+         by += 7;
+      } while( b & 0x80 );
+      return v;
+   }
+
+   template<typename T>
+   void pack_to( std::vector<char>& out, const T& v )
+   {
+      using namespace native::detail;
+      if constexpr ( is_scalar<T> ) {
+         const char* p = reinterpret_cast<const char*>( &v );
+         out.insert( out.end(), p, p + sizeof(T) );
+      } else if constexpr ( std::is_same_v<T, std::string> ) {
+         pack_varuint32( out, (uint32_t)v.size() );
+         out.insert( out.end(), v.begin(), v.end() );
+      } else if constexpr ( is_vector<T>::value ) {
+         pack_varuint32( out, (uint32_t)v.size() );
+         for( const auto& e : v ) pack_to( out, e );
+      } else if constexpr ( is_array<T>::value ) {
+         for( const auto& e : v ) pack_to( out, e );
+      } else if constexpr ( is_tuple<T>::value ) {
+         std::apply( [&]( const auto&... e ) { ( pack_to( out, e ), ... ); }, v );
+      } else if constexpr ( has_pack_member<T>::value ) {
+         v.pack_to( out );
+      } else {
+         pack_to( out, fields( v ) );
+      }
+   }
+
+   template<typename T>
+   void unpack_from( datastream<const char*>& ds, T& v )
+   {
+      using namespace native::detail;
+      if constexpr ( is_scalar<T> ) {
+         ds.read( reinterpret_cast<char*>( &v ), sizeof(T) );
+      } else if constexpr ( std::is_same_v<T, std::string> ) {
+         uint32_t n = unpack_varuint32( ds );
+         check( n <= ds.remaining(), "datastream attempted to read past the end" );
+         v.resize( n );
+         ds.read( v.data(), n );
+      } else if constexpr ( is_vector<T>::value ) {
+         uint32_t n = unpack_varuint32( ds );
+         check( n <= ds.remaining(), "datastream attempted to read past the end" );
+         v.clear();
+         v.resize( n );
+         for( auto& e : v ) unpack_from( ds, e );
+      } else if constexpr ( is_array<T>::value ) {
+         for( auto& e : v ) unpack_from( ds, e );
+      } else if constexpr ( is_tuple<T>::value ) {
+         std::apply( [&]( auto&... e ) { ( unpack_from( ds, e ), ... ); }, v );
+      } else if constexpr ( has_pack_member<T>::value ) {
+         v.unpack_from( ds );
+      } else {
+         auto f = fields( v );
+         unpack_from( ds, f );
+      }
+   }
+
+   template<typename T>
+   std::vector<char> pack( const T& v )
+   {
+      std::vector<char> out;
+      pack_to( out, v );
+      return out;
+   }
+
+   template<typename T>
+   T unpack( const char* data, size_t size )
+   {
+      T v{};
+      datastream<const char*> ds( data, size );
+      unpack_from( ds, v );
+      return v;
+   }
+
+   template<typename T>
+   T unpack( const std::vector<char>& bytes )
+   {
+      return unpack<T>( bytes.data(), bytes.size() );
+   }
+
+} /// namespace eosio
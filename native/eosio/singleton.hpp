@@ -0,0 +1,58 @@
+#pragma once
+
+#include <eosio/chain.hpp>
+#include <eosio/serialize.hpp>
+
+namespace eosio {
+
+   /**
+    * One row of `T` in the table `SingletonName`, stored like the CDT's singleton: the primary
+    * key is the table name and the row is `T` serialized.
+    */
+   template<name::raw SingletonName, typename T>
+   class singleton {
+      public:
+         singleton( name code, uint64_t scope ) : _code(code), _scope(scope) {}
+
+         bool exists()const {
+            const native::table* t = native::chain::current().db.find( id() );
+            return t && t->rows.count( pk_value );
+         }
+
+         T get()const {
+            const native::table* t = native::chain::current().db.find( id() );
+            check( t && t->rows.count( pk_value ), "singleton does not exist" );
+            const auto& row = t->rows.at( pk_value );
+            return unpack<T>( row.value );
+         }
+
+         T get_or_default( const T& def = T() )const { return exists() ? get() : def; }
+
+         void set( const T& value, name bill_to_account ) {
+            check( _code == native::chain::current().receiver(), "cannot create objects in table of another contract" );
+            auto& db = native::chain::current().db;
+            native::table& t = db.get( id() );
+            if ( t.rows.count( pk_value ) ) {
+               db.update( t, id(), pk_value, bill_to_account.value, pack( value ) );
+            } else {
+               db.store( t, id(), pk_value, bill_to_account.value, pack( value ) );
+            }
+         }
+
+         void remove() {
+            check( _code == native::chain::current().receiver(), "cannot erase objects in table of another contract" );
+            auto& db = native::chain::current().db;
+            native::table& t = db.get( id() );
+            if ( t.rows.count( pk_value ) ) db.remove( t, id(), pk_value );
+         }
+
+      private:
+         static constexpr uint64_t pk_value = static_cast<uint64_t>( SingletonName );
+
+         native::table_id id()const { return native::table_id{ _code.value, pk_value, _scope }; }
+
+         name        _code;
+         uint64_t    _scope;
+   };
+
+} /// namespace eosio
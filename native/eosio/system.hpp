@@ -0,0 +1,32 @@
+#pragma once
+
+#include <eosio/chain.hpp>
+
+namespace eosio {
+
+   class microseconds {
+      public:
+         explicit microseconds( int64_t c = 0 ) : _count(c) {}
+         int64_t count()const { return _count; }
+
+      private:
+         int64_t _count;
+   };
+
+   class time_point {
+      public:
+         explicit time_point( microseconds e = microseconds() ) : elapsed(e) {}
+         const microseconds& time_since_epoch()const { return elapsed; }
+         uint32_t sec_since_epoch()const { return uint32_t( elapsed.count() / 1000000 ); }
+
+      private:
+         microseconds elapsed;
+   };
+
+   /// The time of the block of the native chain, see `native::chain::set_time`.
+   inline time_point current_time_point()
+   {
+      return time_point( microseconds( (int64_t)native::chain::current().time_us ) );
+   }
+
+} /// namespace eosio
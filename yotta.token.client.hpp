@@ -0,0 +1,911 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <yotta.vesting.hpp>
+
+/**
+ * Native client for yotta.token.
+ *
+ * Decodes the binary rows of the contract tables straight from a buffer (as returned by
+ * `get_table_rows` with `json=false`, state history or snapshots) and builds the binary data
+ * of the contract actions. It has no eosio dependency.
+ *
+ * Decoded rows are views: `string` and `vector` fields point into the source buffer, which
+ * must outlive the row.
+ */
+namespace yotta {
+
+   /**
+    * Converts an eosio name string to its 64-bit value.
+    */
+   constexpr uint64_t string_to_name( std::string_view str )
+   {
+      auto char_to_value = []( char c ) -> uint64_t {
+         if ( c == '.' ) return 0;
+         if ( c >= '1' && c <= '5' ) return (c - '1') + 1;
+         if ( c >= 'a' && c <= 'z' ) return (c - 'a') + 6;
+         return 0;
+      };
+      uint64_t value = 0;
+      for( size_t i = 0; i < 13 && i < str.size(); i++ ) {
+         if ( i < 12 ) {
+            value |= ( char_to_value( str[i] ) & 0x1f ) << ( 64 - 5 * ( i + 1 ) );
+         } else {
+            value |= char_to_value( str[i] ) & 0x0f;
+         }
+      }
+      return value;
+   }
+
+   /**
+    * Converts a symbol code string and precision to the 64-bit symbol value.
+    */
+   constexpr uint64_t string_to_symbol( uint8_t precision, std::string_view code )
+   {
+      uint64_t value = 0;
+      for( size_t i = code.size(); i > 0; i-- ) {
+         value <<= 8;
+         value |= (uint8_t)code[i - 1];
+      }
+      return ( value << 8 ) | precision;
+   }
+
+   using checksum256_t = std::array<uint8_t, 32>;
+
+   struct asset_t {
+      int64_t     amount = 0;
+      uint64_t    symbol = 0;
+
+      uint64_t code()const { return symbol >> 8; }
+      uint8_t  precision()const { return symbol & 0xff; }
+   };
+
+   /**
+    * A packed array inside a row buffer. Elements are copied out on access, since the
+    * serialization format does not align them.
+    */
+   template<typename T>
+   struct array_view {
+      const char* data = nullptr;
+      uint32_t    count = 0;
+
+      uint32_t size()const { return count; }
+      bool     empty()const { return count == 0; }
+      T operator[]( size_t i )const {
+         T v;
+         std::memcpy( &v, data + i * sizeof(T), sizeof(T) );
+         return v;
+      }
+      std::vector<T> to_vector()const {
+         std::vector<T> v( count );
+         if ( count ) std::memcpy( v.data(), data, count * sizeof(T) );
+         return v;
+      }
+   };
+
+   /**
+    * Sequential reader over a serialized row. Any read past the end marks the reader as failed
+    * and yields zero values.
+    */
+   class row_reader {
+      public:
+         row_reader( const char* data, size_t size ) : pos(data), end(data + size) {}
+
+         bool ok()const { return good; }
+         bool done()const { return good && pos == end; }
+
+         template<typename T>
+         T read() {
+            T v{};
+            if ( !need( sizeof(T) ) ) return v;
+            std::memcpy( &v, pos, sizeof(T) );
+            pos += sizeof(T);
+            return v;
+         }
+
+         uint32_t read_varuint32() {
+            uint32_t v = 0;
+            uint8_t  b = 0;
+            int      by = 0;
+            do {
+               if ( !need( 1 ) || by >= 35 ) { good = false; return 0; }
+               b = (uint8_t)*pos++;
+               v |= uint32_t(b & 0x7f) << by;
+               by += 7;
+            } while( b & 0x80 );
+            return v;
+         }
+
+         asset_t read_asset() {
+            asset_t a;
+            a.amount = read<int64_t>();
+            a.symbol = read<uint64_t>();
+            return a;
+         }
+
+         std::string_view read_string() {
+            uint32_t n = read_varuint32();
+            if ( !need( n ) ) return {};
+            std::string_view s( pos, n );
+            pos += n;
+            return s;
+         }
+
+         template<typename T>
+         array_view<T> read_array() {
+            array_view<T> a;
+            uint32_t n = read_varuint32();
+            if ( !need( (size_t)n * sizeof(T) ) ) return a;
+            a.data = pos;
+            a.count = n;
+            pos += (size_t)n * sizeof(T);
+            return a;
+         }
+
+         /// Skips `n` bytes, e.g. rows of a fixed size the caller does not decode.
+         void skip( size_t n ) {
+            if ( need( n ) ) pos += n;
+         }
+
+      private:
+         bool need( size_t n ) {
+            if ( !good || (size_t)(end - pos) < n ) {
+               good = false;
+               return false;
+            }
+            return true;
+         }
+
+         const char* pos;
+         const char* end;
+         bool        good = true;
+   };
+
+   /**
+    * Sequential writer of action data.
+    */
+   class data_writer {
+      public:
+         template<typename T>
+         data_writer& write( const T& v ) {
+            const char* p = reinterpret_cast<const char*>( &v );
+            buf.insert( buf.end(), p, p + sizeof(T) );
+            return *this;
+         }
+
+         data_writer& write_varuint32( uint32_t v ) {
+            do {
+               uint8_t b = v & 0x7f;
+               v >>= 7;
+               b |= ( v > 0 ) << 7;
+               buf.push_back( (char)b );
+            } while( v );
+            return *this;
+         }
+
+         data_writer& write_asset( const asset_t& a ) {
+            return write( a.amount ).write( a.symbol );
+         }
+
+         data_writer& write_string( std::string_view s ) {
+            write_varuint32( (uint32_t)s.size() );
+            buf.insert( buf.end(), s.begin(), s.end() );
+            return *this;
+         }
+
+         template<typename T>
+         data_writer& write_array( const std::vector<T>& v ) {
+            write_varuint32( (uint32_t)v.size() );
+            for( const auto& e : v ) write( e );
+            return *this;
+         }
+
+         size_t size()const { return buf.size(); }
+         std::vector<char> release() { return std::move( buf ); }
+
+      private:
+         std::vector<char> buf;
+   };
+
+   /// Rows of the contract tables, in the same field order as `yotta.token.hpp`.
+
+   struct account_row {
+      asset_t              balance;
+   };
+
+   struct tokenpool_row {
+      uint64_t             user = 0;
+      std::string_view     pool_name;
+      std::string_view     memo;
+   };
+
+   struct currency_stat_row {
+      asset_t              supply;
+      asset_t              max_supply;
+      uint64_t             issuer = 0;
+      uint64_t             poolsetter = 0;
+      uint64_t             unlocker = 0;
+      uint64_t             time = 0; //exchanging time
+      uint32_t             tokenno = 0;
+   };
+
+   struct lockrule_row {
+      uint32_t             lockruleid = 0;
+      array_view<uint64_t> times;
+      array_view<uint16_t> pcts;
+      uint32_t             base = 0;
+      uint32_t             period = 0;
+      std::string_view     desc;
+   };
+
+   struct lockrule2_row {
+      uint32_t             lockruleid = 0;
+      array_view<uint32_t> times;
+      array_view<uint16_t> pcts;
+      uint32_t             base = 0;
+      uint32_t             period = 0;
+      std::string_view     desc;
+   };
+
+   struct acclock_row {
+      uint64_t             no_ruleid = 0;
+      asset_t              quantity;
+      uint64_t             user = 0;
+      uint64_t             time = 0;
+
+      uint32_t lockruleid()const { return no_ruleid & 0xffffffff; }
+      uint32_t tokenno()const { return no_ruleid >> 32; }
+   };
+
+   struct numlock_row {
+      uint64_t             user = 0;
+      asset_t              quantity;
+   };
+
+   struct loanpool_row {
+      uint64_t             from = 0;
+      uint64_t             manager = 0;
+      asset_t              quantity;
+   };
+
+   struct subledger_row {
+      uint64_t             owner = 0;
+      int64_t              allocated = 0; //sum of the sub-account balances
+   };
+
+   struct airdrop_row {
+      uint32_t             dropid = 0;
+      uint64_t             owner = 0;
+      checksum256_t        root{};
+      asset_t              remaining;
+      uint32_t             deadline = 0;
+   };
+
+   /// Row decoders. Each returns false when the buffer is not exactly one row of the table.
+
+   inline bool decode( const char* data, size_t size, account_row& r )
+   {
+      row_reader rd( data, size );
+      r.balance = rd.read_asset();
+      return rd.done();
+   }
+
+   inline bool decode( const char* data, size_t size, tokenpool_row& r )
+   {
+      row_reader rd( data, size );
+      r.user      = rd.read<uint64_t>();
+      r.pool_name = rd.read_string();
+      r.memo      = rd.read_string();
+      return rd.done();
+   }
+
+   inline bool decode( const char* data, size_t size, currency_stat_row& r )
+   {
+      row_reader rd( data, size );
+      r.supply     = rd.read_asset();
+      r.max_supply = rd.read_asset();
+      r.issuer     = rd.read<uint64_t>();
+      r.poolsetter = rd.read<uint64_t>();
+      r.unlocker   = rd.read<uint64_t>();
+      r.time       = rd.read<uint64_t>();
+      r.tokenno    = rd.read<uint32_t>();
+      return rd.done();
+   }
+
+   inline bool decode( const char* data, size_t size, lockrule_row& r )
+   {
+      row_reader rd( data, size );
+      r.lockruleid = rd.read<uint32_t>();
+      r.times      = rd.read_array<uint64_t>();
+      r.pcts       = rd.read_array<uint16_t>();
+      r.base       = rd.read<uint32_t>();
+      r.period     = rd.read<uint32_t>();
+      r.desc       = rd.read_string();
+      return rd.done();
+   }
+
+   inline bool decode( const char* data, size_t size, lockrule2_row& r )
+   {
+      row_reader rd( data, size );
+      r.lockruleid = rd.read<uint32_t>();
+      r.times      = rd.read_array<uint32_t>();
+      r.pcts       = rd.read_array<uint16_t>();
+      r.base       = rd.read<uint32_t>();
+      r.period     = rd.read<uint32_t>();
+      r.desc       = rd.read_string();
+      return rd.done();
+   }
+
+   inline bool decode( const char* data, size_t size, acclock_row& r )
+   {
+      row_reader rd( data, size );
+      r.no_ruleid = rd.read<uint64_t>();
+      r.quantity  = rd.read_asset();
+      r.user      = rd.read<uint64_t>();
+      r.time      = rd.read<uint64_t>();
+      return rd.done();
+   }
+
+   inline bool decode( const char* data, size_t size, numlock_row& r )
+   {
+      row_reader rd( data, size );
+      r.user     = rd.read<uint64_t>();
+      r.quantity = rd.read_asset();
+      return rd.done();
+   }
+
+   inline bool decode( const char* data, size_t size, loanpool_row& r )
+   {
+      row_reader rd( data, size );
+      r.from     = rd.read<uint64_t>();
+      r.manager  = rd.read<uint64_t>();
+      r.quantity = rd.read_asset();
+      return rd.done();
+   }
+
+   /// Decoders of the compact v2 tables. Fields dropped by v2 (the scope and the symbol) are
+   /// given by the caller, so that v1 and v2 rows end up in the same structs. acclock2 rows of
+   /// all tokens share the user's scope, so their symbol is left 0; use `tokenno()` instead.
+
+   inline bool decode_acclock2( const char* data, size_t size, uint64_t user, acclock_row& r )
+   {
+      row_reader rd( data, size );
+      r.no_ruleid       = rd.read<uint64_t>();
+      r.quantity.amount = rd.read<int64_t>();
+      r.quantity.symbol = 0;
+      r.user            = user;
+      r.time            = rd.read<uint32_t>();
+      return rd.done();
+   }
+
+   inline bool decode_numlock2( const char* data, size_t size, uint64_t symbol, numlock_row& r )
+   {
+      row_reader rd( data, size );
+      r.user            = rd.read<uint64_t>();
+      r.quantity.amount = rd.read<int64_t>();
+      r.quantity.symbol = symbol;
+      return rd.done();
+   }
+
+   inline bool decode_loanpool2( const char* data, size_t size, uint64_t symbol, loanpool_row& r )
+   {
+      row_reader rd( data, size );
+      r.from            = rd.read<uint64_t>();
+      r.manager         = rd.read<uint64_t>();
+      r.quantity.amount = rd.read<int64_t>();
+      r.quantity.symbol = symbol;
+      return rd.done();
+   }
+
+   inline bool decode( const char* data, size_t size, subledger_row& r )
+   {
+      row_reader rd( data, size );
+      r.owner     = rd.read<uint64_t>();
+      r.allocated = rd.read<int64_t>();
+      return rd.done();
+   }
+
+   inline bool decode( const char* data, size_t size, airdrop_row& r )
+   {
+      row_reader rd( data, size );
+      r.dropid    = rd.read<uint32_t>();
+      r.owner     = rd.read<uint64_t>();
+      r.root      = rd.read<checksum256_t>();
+      r.remaining = rd.read_asset();
+      r.deadline  = rd.read<uint32_t>();
+      return rd.done();
+   }
+
+   /**
+    * Bytes of an airdrop leaf; the leaf hash committed in the merkle tree is their sha256.
+    * Parent nodes hash the concatenation of the left and right child.
+    */
+   inline std::vector<char> airdrop_leaf( uint32_t index, uint64_t account, int64_t amount, uint32_t lockruleid )
+   {
+      return data_writer().write( index ).write( account ).write( amount ).write( lockruleid ).release();
+   }
+
+   /**
+    * A state change carried by the `changelog` action. See `yottatoken::change`.
+    */
+   struct change_record {
+      static constexpr uint8_t balance_change   = 1;
+      static constexpr uint8_t numlock_change   = 2;
+      static constexpr uint8_t acclock_change   = 3;
+      static constexpr uint8_t loan_change      = 4;
+      static constexpr uint8_t supply_change    = 5;
+      static constexpr uint8_t skipped_credit   = 6;
+      static constexpr uint8_t subledger_change = 7;
+
+      uint8_t              kind = 0;
+      uint64_t             account = 0;
+      uint64_t             sym = 0; //symbol code
+      uint64_t             key = 0;
+      int64_t              before = 0;
+      int64_t              after = 0;
+   };
+
+   /**
+    * Decodes the data of a `changelog` action, calling `apply` on each change in order.
+    * Returns false when the data is malformed; changes before the error have been applied.
+    */
+   template<typename Apply>
+   bool decode_changelog( const char* data, size_t size, Apply&& apply )
+   {
+      row_reader rd( data, size );
+      uint32_t n = rd.read_varuint32();
+      for( uint32_t i = 0; i < n && rd.ok(); i++ ) {
+         change_record c;
+         c.kind    = rd.read<uint8_t>();
+         c.account = rd.read<uint64_t>();
+         c.sym     = rd.read<uint64_t>();
+         c.key     = rd.read<uint64_t>();
+         c.before  = rd.read<int64_t>();
+         c.after   = rd.read<int64_t>();
+         if ( !rd.ok() ) break;
+         apply( c );
+      }
+      return rd.done();
+   }
+
+   /**
+    * Balance of a holder split the way `sub_balance` sees it.
+    */
+   struct holder_state {
+      int64_t              balance = 0;
+      int64_t              locked = 0; //numlock and the locked part of acclock tranches
+      int64_t              loaned = 0; //approved to a loan manager
+      int64_t              allocated = 0; //sub-account balances of a sub-ledger owner
+
+      int64_t available()const { return balance - locked - loaned - allocated; }
+      bool    can_spend( int64_t amount )const { return yotta::can_spend( balance, locked, loaned + allocated, amount ); }
+   };
+
+   /**
+    * The decoded rows of a holder in one token, from the v2 tables and the old ones not converted yet.
+    * Pointers are null when there is no row.
+    */
+   struct holder_rows {
+      account_row                account;
+      const numlock_row*         numlock2 = nullptr;
+      const numlock_row*         numlock = nullptr;
+      std::vector<acclock_row>   acclocks2; //the holder's acclock2 scope, rows of other tokens are ignored
+      std::vector<acclock_row>   acclocks; //the holder's acclock scope, rows of other tokens are ignored
+      const loanpool_row*        loanpool2 = nullptr;
+      const loanpool_row*        loanpool = nullptr;
+      const subledger_row*       subledger = nullptr;
+   };
+
+   /**
+    * `holder_rows` as the `Store` of `yotta::locked_balance`, filtering acclock rows the way the
+    * contract reads them.
+    */
+   template<typename FindRule2, typename FindRule>
+   struct holder_rows_store {
+      const holder_rows&         rows;
+      const currency_stat_row&   st;
+      FindRule2&                 find_rule2;
+      FindRule&                  find_rule;
+
+      bool numlock( int64_t& amount ) {
+         if ( !rows.numlock2 ) return false;
+         amount = rows.numlock2->quantity.amount;
+         return true;
+      }
+
+      bool numlock_v1( int64_t& amount ) {
+         if ( !rows.numlock ) return false;
+         amount = rows.numlock->quantity.amount;
+         return true;
+      }
+
+      template<typename F>
+      void each_acclock( F&& f ) {
+         for( const auto& lock : rows.acclocks2 ) {
+            if ( lock.tokenno() == st.tokenno ) f( lock.no_ruleid, lock.quantity.amount );
+         }
+      }
+
+      template<typename F>
+      void each_acclock_v1( F&& f ) {
+         for( const auto& lock : rows.acclocks ) {
+            if ( lock.quantity.code() == st.supply.code() ) f( lock.no_ruleid, lock.quantity.amount );
+         }
+      }
+
+      template<typename F>
+      bool rule( uint32_t lockruleid, F&& f ) {
+         const lockrule2_row* r = find_rule2( lockruleid );
+         if ( !r ) return false;
+         f( r->times, r->pcts, r->base, r->period );
+         return true;
+      }
+
+      template<typename F>
+      bool rule_v1( uint32_t lockruleid, F&& f ) {
+         const lockrule_row* r = find_rule( lockruleid );
+         if ( !r ) return false;
+         f( r->times, r->pcts, r->base, r->period );
+         return true;
+      }
+   };
+
+   /**
+    * Computes the state of a holder at `curtime` from its decoded rows, for exports and audits.
+    *
+    * @param rows - the holder's rows of the token,
+    * @param st - the stat row of the token,
+    * @param find_rule2 - returns the lockrule2 row of an id in the token's scope, or null,
+    * @param find_rule - returns the lockrule row of an id in the token's scope, or null,
+    * @param curtime - the time in seconds, e.g. the snapshot's block time.
+    */
+   template<typename FindRule2, typename FindRule>
+   holder_state holder_at( const holder_rows& rows, const currency_stat_row& st,
+                           FindRule2&& find_rule2, FindRule&& find_rule, uint64_t curtime )
+   {
+      holder_rows_store<FindRule2, FindRule> store{ rows, st, find_rule2, find_rule };
+      holder_state h;
+      h.balance = rows.account.balance.amount;
+      h.locked = locked_balance( store, st.time, curtime );
+      if ( rows.loanpool2 ) h.loaned = rows.loanpool2->quantity.amount;
+      else if ( rows.loanpool ) h.loaned = rows.loanpool->quantity.amount;
+      if ( rows.subledger ) h.allocated = rows.subledger->allocated;
+      return h;
+   }
+
+   /**
+    * Computes the state of the balance of `owner` in the token of symbol code `code` at `curtime`
+    * from the binary rows of the contract tables, as an indexer or a snapshot holds them.
+    *
+    * `Tables` gives the rows of a table by scope:
+    * - `bool find( uint64_t table, uint64_t scope, uint64_t pk, std::string_view& value )`, false
+    *   when there is no row,
+    * - `void each( uint64_t table, uint64_t scope, F&& f )`, calling `f( std::string_view value )`
+    *   on each row of the scope.
+    *
+    * Returns false when the owner has no balance of the token or the token has no stat row.
+    */
+   template<typename Tables>
+   bool holder_from_tables( Tables& tables, uint64_t owner, uint64_t code, uint64_t curtime, holder_state& out )
+   {
+      std::string_view v;
+      auto find = [&]( const char* table, uint64_t scope, uint64_t pk ) {
+         return tables.find( string_to_name( table ), scope, pk, v );
+      };
+
+      currency_stat_row st;
+      holder_rows       h;
+      if ( !find( "stat", code, code ) || !decode( v.data(), v.size(), st ) ) return false;
+      if ( !find( "accounts", owner, code ) || !decode( v.data(), v.size(), h.account ) ) return false;
+      uint64_t symbol = st.supply.symbol;
+
+      numlock_row    numlock2, numlock;
+      loanpool_row   loanpool2, loanpool;
+      subledger_row  subledger;
+      if ( find( "numlock2", code, owner ) && decode_numlock2( v.data(), v.size(), symbol, numlock2 ) ) {
+         h.numlock2 = &numlock2;
+      }
+      if ( find( "numlock", code, owner ) && decode( v.data(), v.size(), numlock ) ) {
+         h.numlock = &numlock;
+      }
+      if ( find( "loanpool2", code, owner ) && decode_loanpool2( v.data(), v.size(), symbol, loanpool2 ) ) {
+         h.loanpool2 = &loanpool2;
+      }
+      if ( find( "loanpool", code, owner ) && decode( v.data(), v.size(), loanpool ) ) {
+         h.loanpool = &loanpool;
+      }
+      if ( find( "subledger", code, owner ) && decode( v.data(), v.size(), subledger ) ) {
+         h.subledger = &subledger;
+      }
+
+      acclock_row lock;
+      tables.each( string_to_name( "acclock2" ), owner, [&]( std::string_view row ) {
+         if ( decode_acclock2( row.data(), row.size(), owner, lock ) ) h.acclocks2.push_back( lock );
+      } );
+      tables.each( string_to_name( "acclock" ), owner, [&]( std::string_view row ) {
+         if ( decode( row.data(), row.size(), lock ) ) h.acclocks.push_back( lock );
+      } );
+
+      lockrule2_row rule2;
+      lockrule_row  rule;
+      auto find_rule2 = [&]( uint32_t lockruleid ) -> const lockrule2_row* {
+         return find( "lockrule2", code, lockruleid ) && decode( v.data(), v.size(), rule2 ) ? &rule2 : nullptr;
+      };
+      auto find_rule = [&]( uint32_t lockruleid ) -> const lockrule_row* {
+         return find( "lockrule", code, lockruleid ) && decode( v.data(), v.size(), rule ) ? &rule : nullptr;
+      };
+      out = holder_at( h, st, find_rule2, find_rule, curtime );
+      return true;
+   }
+
+   /**
+    * Converts a 64-bit name value to its string.
+    */
+   inline std::string name_to_string( uint64_t value )
+   {
+      static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+      std::string str( 13, '.' );
+      uint64_t tmp = value;
+      for( uint32_t i = 0; i <= 12; ++i ) {
+         char c = charmap[tmp & ( i == 0 ? 0x0f : 0x1f )];
+         str[12 - i] = c;
+         tmp >>= ( i == 0 ? 4 : 5 );
+      }
+      size_t last = str.find_last_not_of( '.' );
+      str.resize( last == std::string::npos ? 0 : last + 1 );
+      return str;
+   }
+
+   /**
+    * Converts an asset to the `1.0000 SYM` form used by the contract's JSON.
+    */
+   inline std::string asset_to_string( const asset_t& a )
+   {
+      uint8_t  precision = a.precision();
+      bool     negative = a.amount < 0;
+      uint64_t abs = negative ? 0 - (uint64_t)a.amount : (uint64_t)a.amount;
+      std::string digits = std::to_string( abs );
+      if ( precision > 0 ) {
+         if ( digits.size() <= precision ) digits.insert( 0, precision + 1 - digits.size(), '0' );
+         digits.insert( digits.size() - precision, 1, '.' );
+      }
+      std::string str = negative ? "-" + digits : digits;
+      str.push_back( ' ' );
+      for( uint64_t code = a.code(); code; code >>= 8 ) {
+         str.push_back( (char)( code & 0xff ) );
+      }
+      return str;
+   }
+
+   /**
+    * Bytes of a relayed transfer; the relay key signs their sha256. See `yottatoken::transfer_intent`.
+    */
+   inline std::vector<char> transfer_intent_digest_data( const checksum256_t& chain_id, uint64_t contract,
+                                                         uint64_t from, uint64_t to, const asset_t& quantity,
+                                                         uint64_t nonce, uint32_t expiry )
+   {
+      return data_writer().write( chain_id ).write( contract ).write( from ).write( to ).write_asset( quantity )
+                          .write( nonce ).write( expiry ).release();
+   }
+
+   /**
+    * A signed transfer for `relay`. `sig` is the packed eosio signature, starting with its key type.
+    */
+   struct transfer_intent {
+      uint64_t             from = 0;
+      uint64_t             to = 0;
+      asset_t              quantity;
+      uint64_t             nonce = 0;
+      uint32_t             expiry = 0;
+      std::vector<char>    sig;
+   };
+
+   /**
+    * Binary data of a contract action, ready to be put into a transaction.
+    */
+   struct action_data {
+      uint64_t             account = 0;
+      uint64_t             name = 0;
+      std::vector<char>    data;
+   };
+
+   /**
+    * Builders of the contract actions. Authorizations are left to the caller.
+    */
+   class action_builder {
+      public:
+         explicit action_builder( uint64_t contract ) : contract(contract) {}
+
+         action_data setunicheck( uint64_t account )const {
+            return make( "setunicheck", data_writer().write( account ) );
+         }
+
+         action_data create( uint64_t issuer, const asset_t& maximum_supply,
+                             std::string_view token_name, std::string_view memo )const {
+            return make( "create", data_writer().write( issuer ).write_asset( maximum_supply )
+                                                .write_string( token_name ).write_string( memo ) );
+         }
+
+         action_data issue( uint64_t to, const asset_t& quantity, std::string_view memo )const {
+            return make( "issue", data_writer().write( to ).write_asset( quantity ).write_string( memo ) );
+         }
+
+         action_data setextime( uint64_t time, const asset_t& value )const {
+            return make( "setextime", data_writer().write( time ).write_asset( value ) );
+         }
+
+         action_data open( uint64_t owner, const asset_t& value, uint64_t ram_payer )const {
+            return make( "open", data_writer().write( owner ).write_asset( value ).write( ram_payer ) );
+         }
+
+         action_data close( uint64_t acc, const asset_t& value )const {
+            return make( "close", data_writer().write( acc ).write_asset( value ) );
+         }
+
+         action_data transfer( uint64_t from, uint64_t to, const asset_t& quantity, std::string_view memo )const {
+            return make( "transfer", data_writer().write( from ).write( to ).write_asset( quantity ).write_string( memo ) );
+         }
+
+         action_data yrctransfer( uint64_t from, uint64_t to, const asset_t& quantity,
+                                  bool bcreate, std::string_view memo )const {
+            return make( "yrctransfer", data_writer().write( from ).write( to ).write_asset( quantity )
+                                                     .write( bcreate ).write_string( memo ) );
+         }
+
+         action_data approve( uint64_t from, uint64_t manager, const asset_t& quantity )const {
+            return make( "approve", data_writer().write( from ).write( manager ).write_asset( quantity ) );
+         }
+
+         action_data loantrans( uint64_t manager, uint64_t from, uint64_t to, const asset_t& quantity,
+                                bool bcreate, std::string_view memo )const {
+            return make( "loantrans", data_writer().write( manager ).write( from ).write( to ).write_asset( quantity )
+                                                   .write( bcreate ).write_string( memo ) );
+         }
+
+         action_data addtknpool( uint64_t user, const asset_t& value, std::string_view pool_name,
+                                 std::string_view memo )const {
+            return make( "addtknpool", data_writer().write( user ).write_asset( value )
+                                                    .write_string( pool_name ).write_string( memo ) );
+         }
+
+         action_data rmvtknpool( uint64_t user, const asset_t& value )const {
+            return make( "rmvtknpool", data_writer().write( user ).write_asset( value ) );
+         }
+
+         action_data addrule( uint64_t user, uint32_t lockruleid, const std::vector<uint64_t>& times,
+                              const std::vector<uint16_t>& pcts, uint32_t base, uint32_t period,
+                              const asset_t& value, std::string_view desc )const {
+            return make( "addrule", data_writer().write( user ).write( lockruleid ).write_array( times )
+                                                 .write_array( pcts ).write( base ).write( period )
+                                                 .write_asset( value ).write_string( desc ) );
+         }
+
+         action_data batchtrans( uint64_t from, const std::vector<uint64_t>& accs,
+                                 const std::vector<int64_t>& amounts, const asset_t& value,
+                                 std::string_view memo )const {
+            return make( "batchtrans", data_writer().write( from ).write_array( accs ).write_array( amounts )
+                                                    .write_asset( value ).write_string( memo ) );
+         }
+
+         action_data locktransfer( uint32_t lockruleid, uint64_t from, uint64_t to, const asset_t& quantity,
+                                   std::string_view memo )const {
+            return make( "locktransfer", data_writer().write( lockruleid ).write( from ).write( to )
+                                                      .write_asset( quantity ).write_string( memo ) );
+         }
+
+         action_data unlockasset( uint64_t acc, const asset_t& value, std::string_view memo )const {
+            return make( "unlockasset", data_writer().write( acc ).write_asset( value ).write_string( memo ) );
+         }
+
+         action_data newairdrop( uint64_t owner, uint32_t dropid, const checksum256_t& root, const asset_t& total,
+                                 uint32_t deadline, std::string_view memo )const {
+            return make( "newairdrop", data_writer().write( owner ).write( dropid ).write( root ).write_asset( total )
+                                                    .write( deadline ).write_string( memo ) );
+         }
+
+         action_data claim( uint64_t user, uint32_t dropid, uint32_t index, const asset_t& quantity,
+                            uint32_t lockruleid, const std::vector<checksum256_t>& proof )const {
+            return make( "claim", data_writer().write( user ).write( dropid ).write( index ).write_asset( quantity )
+                                               .write( lockruleid ).write_array( proof ) );
+         }
+
+         action_data reclaim( uint32_t dropid, const asset_t& value )const {
+            return make( "reclaim", data_writer().write( dropid ).write_asset( value ) );
+         }
+
+         action_data setckpt( const asset_t& value, uint32_t interval, uint32_t max_count )const {
+            return make( "setckpt", data_writer().write_asset( value ).write( interval ).write( max_count ) );
+         }
+
+         action_data balanceat( uint64_t owner, const asset_t& value, uint32_t time )const {
+            return make( "balanceat", data_writer().write( owner ).write_asset( value ).write( time ) );
+         }
+
+         action_data newstream( uint64_t sender, uint64_t recipient, const asset_t& quantity,
+                                uint32_t start, uint32_t end, std::string_view memo )const {
+            return make( "newstream", data_writer().write( sender ).write( recipient ).write_asset( quantity )
+                                                   .write( start ).write( end ).write_string( memo ) );
+         }
+
+         action_data withdraw( uint64_t streamid, const asset_t& value )const {
+            return make( "withdraw", data_writer().write( streamid ).write_asset( value ) );
+         }
+
+         action_data cancelstream( uint64_t streamid, const asset_t& value )const {
+            return make( "cancelstream", data_writer().write( streamid ).write_asset( value ) );
+         }
+
+         action_data migrate( uint64_t table, uint64_t scope, uint32_t max_rows )const {
+            return make( "migrate", data_writer().write( table ).write( scope ).write( max_rows ) );
+         }
+
+         action_data setreward( const asset_t& value )const {
+            return make( "setreward", data_writer().write_asset( value ) );
+         }
+
+         action_data addreward( uint64_t pool, const asset_t& quantity )const {
+            return make( "addreward", data_writer().write( pool ).write_asset( quantity ) );
+         }
+
+         action_data claimreward( uint64_t owner, const asset_t& value )const {
+            return make( "claimreward", data_writer().write( owner ).write_asset( value ) );
+         }
+
+         action_data regsubledger( uint64_t owner, const asset_t& value )const {
+            return make( "regsubledger", data_writer().write( owner ).write_asset( value ) );
+         }
+
+         action_data subtransfer( uint64_t from, uint64_t to, uint32_t subid, const asset_t& quantity,
+                                  std::string_view memo )const {
+            return make( "subtransfer", data_writer().write( from ).write( to ).write( subid )
+                                                     .write_asset( quantity ).write_string( memo ) );
+         }
+
+         action_data submove( uint64_t owner, uint32_t from_subid, uint32_t to_subid, const asset_t& quantity )const {
+            return make( "submove", data_writer().write( owner ).write( from_subid ).write( to_subid )
+                                                 .write_asset( quantity ) );
+         }
+
+         action_data subwithdraw( uint64_t owner, uint32_t subid, uint64_t to, const asset_t& quantity,
+                                  std::string_view memo )const {
+            return make( "subwithdraw", data_writer().write( owner ).write( subid ).write( to )
+                                                     .write_asset( quantity ).write_string( memo ) );
+         }
+
+         action_data setchainid( const checksum256_t& chain_id )const {
+            return make( "setchainid", data_writer().write( chain_id ) );
+         }
+
+         //packed_key is the packed eosio public key, starting with its key type
+         action_data setrelaykey( uint64_t account, const std::vector<char>& packed_key )const {
+            data_writer w;
+            w.write( account );
+            for( char c : packed_key ) w.write( c );
+            return make( "setrelaykey", w );
+         }
+
+         action_data relay( uint64_t relayer, const std::vector<transfer_intent>& intents )const {
+            data_writer w;
+            w.write( relayer ).write_varuint32( (uint32_t)intents.size() );
+            for( const auto& in : intents ) {
+               w.write( in.from ).write( in.to ).write_asset( in.quantity ).write( in.nonce ).write( in.expiry );
+               for( char c : in.sig ) w.write( c );
+            }
+            return make( "relay", w );
+         }
+
+      private:
+         action_data make( std::string_view act, data_writer& w )const {
+            return action_data{ contract, string_to_name( act ), w.release() };
+         }
+
+         uint64_t contract;
+   };
+
+} /// namespace yotta
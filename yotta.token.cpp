@@ -74,6 +74,7 @@ void yottatoken::issue( const name& to, const asset& quantity, const string& mem
    statstable.modify( st, same_payer, [&]( auto& s ) {
       s.supply += quantity;
    });
+   log_change( supply_change, st.issuer, sym.code(), 0, st.supply.amount - quantity.amount, st.supply.amount );
 
    add_balance( to.value, sym.code().raw(), quantity, st.issuer, true );
 
@@ -148,7 +149,7 @@ void yottatoken::transfer( const name&    from,
    check( quantity.symbol == st.supply.symbol, "symbol or precision mismatch" );
    check( memo.size() <= 256, "memo has more than 256 bytes" );
 
-   sub_balance( from, quantity );
+   sub_balance( from, quantity, from );
    add_balance( to.value, sym.code().raw(), quantity, from, true );
 }
 
@@ -175,27 +176,25 @@ void yottatoken::yrctransfer( const name&    from,
    check( quantity.symbol == st.supply.symbol, "symbol or precision mismatch" );
    check( memo.size() <= 256, "memo has more than 256 bytes" );
 
-   sub_balance( from, quantity );
+   sub_balance( from, quantity, from );
    add_balance( to.value, sym.code().raw(), quantity, from, bcreate );
 }
 
-void yottatoken::sub_balance( const name& owner, const asset& value ) {
+void yottatoken::sub_balance( const name& owner, const asset& value, const name& ram_payer ) {
    accounts from_acnts( get_self(), owner.value );
    const auto& from_token = from_acnts.get( value.symbol.code().raw(), "Payer's token is not existed" );
    auto lock_asset = get_lock_asset(owner, value);
    check( lock_asset.symbol == value.symbol, "symbol or precision mismatch" );
    
-   loanpools _loanpool( get_self(), value.symbol.code().raw() );
-   auto loan = _loanpool.find( owner.value );
-   if( loan == _loanpool.end() ) {
-      check( from_token.balance.amount - lock_asset.amount >= value.amount, "overdrawn balance" );
-   } else {
-      check( from_token.balance.amount - lock_asset.amount - loan->quantity.amount  >= value.amount, "overdrawn balance" );
-   }
+   //sub-account balances of a sub-ledger owner stay reserved like a loan
+   auto reserved = get_loan_amount( owner, value.symbol ) + get_allocated( owner, value.symbol );
+   check( yotta::can_spend( from_token.balance.amount, lock_asset.amount, reserved, value.amount ), "overdrawn balance" );
 
-   from_acnts.modify( from_token, owner, [&]( auto& a ) {
+   //the row keeps its payer unless the owner authorized the action itself
+   from_acnts.modify( from_token, owner == ram_payer ? owner : same_payer, [&]( auto& a ) {
       a.balance -= value;
    });
+   balance_changed( owner, from_token.balance.amount + value.amount, from_token.balance, ram_payer );
 }
 
 void yottatoken::add_balance( uint64_t namevalue, uint64_t symbol, const asset& value, const name& ram_payer, bool bcreate )
@@ -206,10 +205,12 @@ void yottatoken::add_balance( uint64_t namevalue, uint64_t symbol, const asset&
       to_acnts.modify( to, same_payer, [&]( auto& a ) {
          a.balance.amount += value.amount;
       });
+      balance_changed( name(namevalue), to->balance.amount - value.amount, to->balance, ram_payer );
    } else if( bcreate ){
       to_acnts.emplace( ram_payer, [&]( auto& a ){
         a.balance = value;
       });
+      balance_changed( name(namevalue), 0, value, ram_payer );
    } else {
       check( false, "Payee's token is not existed" );
    }
@@ -230,21 +231,27 @@ void yottatoken::approve( const name& from, const name& manager, const asset& qu
    auto lock_asset = get_lock_asset(from, quantity);
    check( lock_asset.symbol == sym, "symbol or precision mismatch" );
 
-   loanpools _loanpool( get_self(), sym.code().raw() );
+   auto allocated = get_allocated( from, sym );
+
+   upgrade_loan( sym.code(), from );
+   loanpools2 _loanpool( get_self(), sym.code().raw() );
    auto loan = _loanpool.find( from.value );
    if( loan == _loanpool.end() ) {
-      check( from_token.balance.amount - lock_asset.amount >= quantity.amount, "overdrawn balance" );
+      check( yotta::can_spend( from_token.balance.amount, lock_asset.amount, allocated, quantity.amount ), "overdrawn balance" );
       _loanpool.emplace(from, [&](auto &row) {
          row.from = from;
          row.manager = manager;
-         row.quantity = quantity;
+         row.amount = quantity.amount;
       });
+      log_change( loan_change, from, sym.code(), manager.value, 0, quantity.amount );
    } else {
       check( loan->manager == manager, "manager should be the same as before");
-      check( from_token.balance.amount - lock_asset.amount - loan->quantity.amount  >= quantity.amount, "overdrawn balance" );
+      check( yotta::can_spend( from_token.balance.amount, lock_asset.amount, loan->amount + allocated, quantity.amount ),
+             "overdrawn balance" );
       _loanpool.modify(loan, from, [&](auto &row) {
-         row.quantity += quantity;
+         row.amount += quantity.amount;
       });
+      log_change( loan_change, from, sym.code(), manager.value, loan->amount - quantity.amount, loan->amount );
    }
 }
 
@@ -255,19 +262,21 @@ void yottatoken::loantrans( const name& manager, const name& from, const name& t
    check( quantity.amount > 0, "must loantrans positive quantity" );
    check( memo.size() <= 256, "memo has more than 256 bytes" );
    require_auth( manager );
-   loanpools _loanpool( get_self(), sym.code().raw() );
+   upgrade_loan( sym.code(), from );
+   loanpools2 _loanpool( get_self(), sym.code().raw() );
    const auto& loan = _loanpool.get( from.value, "loan is null" );
-   check( loan.quantity.amount  >= quantity.amount, "overdrawn balance" );
+   check( loan.amount  >= quantity.amount, "overdrawn balance" );
    check( loan.manager == manager, "only manager can loantrans" );
 
-   sub_balance( from, quantity );
-   add_balance( to.value, sym.code().raw(), quantity, from, bcreate );
+   sub_balance( from, quantity, manager );
+   add_balance( to.value, sym.code().raw(), quantity, manager, bcreate );
 
-   if( loan.quantity.amount == quantity.amount ) {
+   log_change( loan_change, from, sym.code(), manager.value, loan.amount, loan.amount - quantity.amount );
+   if( loan.amount == quantity.amount ) {
       _loanpool.erase( loan );
    } else {
       _loanpool.modify(loan, same_payer, [&](auto &row) {
-         row.quantity -= quantity;
+         row.amount -= quantity.amount;
       });
    }
 }
@@ -323,11 +332,14 @@ void yottatoken::addrule( const name& user, uint32_t lockruleid, const std::vect
       check( period > 0, "period must be a positive number" );
    }
 
-   lockrules _lockrule( get_self(), sym.code().raw() );
+   lockrules2 _lockrule( get_self(), sym.code().raw() );
    auto itrule = _lockrule.find(lockruleid);
    check( itrule == _lockrule.end(), "the id already existed in rule table" ); 
+   lockrules _lockrule1( get_self(), sym.code().raw() );
+   check( _lockrule1.find(lockruleid) == _lockrule1.end(), "the id already existed in rule table" );
 
    for( size_t i = 0; i < times.size(); i++ ) {
+      check( times[i] <= std::numeric_limits<uint32_t>::max(), "times is out of range" );
       if( i == 0 ){
          check( pcts[i] >= 0 && pcts[i] <= base, "invalidate lock percentage" );
       } else {
@@ -338,7 +350,7 @@ void yottatoken::addrule( const name& user, uint32_t lockruleid, const std::vect
 
    _lockrule.emplace(user, [&](auto &row) {
       row.lockruleid   = lockruleid;
-      row.times        = times;
+      row.times        = std::vector<uint32_t>( times.begin(), times.end() );
       row.pcts         = pcts;
       row.base         = base;
       row.period       = period;
@@ -367,11 +379,14 @@ void yottatoken::batchtrans(const name& from, const std::vector<name>& accs,
          to_acnts.modify( to, same_payer, [&]( auto& a ) {
             a.balance.amount += amounts[no];
          });
+         balance_changed( accs[no], to->balance.amount - amounts[no], to->balance, from );
          all_amount += amounts[no];
+      } else {
+         log_change( skipped_credit, accs[no], sym.code(), no, amounts[no], 0 );
       }
    }
    asset subasset( all_amount, sym );
-   sub_balance( from, subasset );
+   sub_balance( from, subasset, from );
 }
 
 void yottatoken::locktransfer(uint32_t lockruleid, const name& from, const name& to, const asset& quantity, const string& memo) 
@@ -385,137 +400,857 @@ void yottatoken::locktransfer(uint32_t lockruleid, const name& from, const name&
    const auto& poolacc = _tokenpool.get( from.value, "only token pool account can locktransfer" );
 
    transfer( from, to, quantity, memo );
+   add_lock( from, to, quantity, lockruleid );
+}
+
+void yottatoken::unlockasset( const name& acc, const asset& value, const string& memo )
+{
+   auto sym = value.symbol;
+   check( sym.is_valid(), "invalid symbol when unlockasset" );
+   check( memo.size() <= 256, "memo has more than 256 bytes" );
+   check( value.amount >= 0, "cannot lock negative quantity" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed when unlockasset" );
+   require_auth( st.unlocker );
+
+   accounts _acnts( get_self(), acc.value );
+   const auto& to = _acnts.get( sym.code().raw(),  "Account does not have this token");
+
+   upgrade_numlock( sym.code(), acc );
+   numlocks2 _numlock( get_self(), sym.code().raw() );
+   const auto& it = _numlock.get( acc.value, "lockasset isn't existed" );
+   check( it.amount >= value.amount, "locking asset should less than before" );
+   log_change( numlock_change, acc, sym.code(), 0, it.amount, it.amount - value.amount );
+   if ( it.amount == value.amount ) {
+      _numlock.erase( it );
+   } else {
+      _numlock.modify(it, st.unlocker, [&](auto &row) {
+         row.amount -= value.amount;
+      });
+   }
+}
+
+void yottatoken::newairdrop( const name& owner, uint32_t dropid, const checksum256& root, const asset& total,
+                             uint32_t deadline, const string& memo )
+{
+   require_auth( owner );
+   auto sym = total.symbol;
+   check( sym.is_valid(), "invalid symbol when newairdrop" );
+   check( total.is_valid(), "invalid quantity" );
+   check( total.amount > 0, "must airdrop positive quantity" );
+   check( memo.size() <= 256, "memo has more than 256 bytes" );
+   check( deadline > current_time_point().sec_since_epoch(), "deadline should be in the future" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed when newairdrop" );
+   check( sym == st.supply.symbol, "symbol or precision mismatch" );
+
+   airdrops _airdrop( get_self(), sym.code().raw() );
+   auto itdrop = _airdrop.find( dropid );
+   check( itdrop == _airdrop.end(), "the id already existed in airdrop table" );
+
+   sub_balance( owner, total, owner );
+   add_balance( get_self().value, sym.code().raw(), total, owner, true );
+
+   _airdrop.emplace(owner, [&](auto &row) {
+      row.dropid       = dropid;
+      row.owner        = owner;
+      row.root         = root;
+      row.remaining    = total;
+      row.deadline     = deadline;
+   });
+}
+
+void yottatoken::claim( const name& user, uint32_t dropid, uint32_t index, const asset& quantity,
+                        uint32_t lockruleid, const std::vector<checksum256>& proof )
+{
+   require_auth( user );
+   auto sym = quantity.symbol;
+   check( sym.is_valid(), "invalid symbol when claim" );
+   check( quantity.amount > 0, "must claim positive quantity" );
+   check( proof.size() <= 32, "proof is too long" );
+
+   airdrops _airdrop( get_self(), sym.code().raw() );
+   const auto& drop = _airdrop.get( dropid, "airdrop is not existed" );
+   check( current_time_point().sec_since_epoch() <= drop.deadline, "airdrop has expired" );
+   check( drop.remaining.symbol == sym, "symbol or precision mismatch" );
+   check( drop.remaining.amount >= quantity.amount, "overdrawn airdrop" );
+
+   auto leaf = eosio::pack( std::make_tuple( index, user, quantity.amount, lockruleid ) );
+   auto node = sha256( leaf.data(), leaf.size() );
+   uint32_t path = index;
+   for( const auto& sibling : proof ) {
+      auto a = node.extract_as_byte_array();
+      auto b = sibling.extract_as_byte_array();
+      std::array<uint8_t, 64> pair;
+      if( path & 1 ) {
+         std::copy( b.begin(), b.end(), pair.begin() );
+         std::copy( a.begin(), a.end(), pair.begin() + 32 );
+      } else {
+         std::copy( a.begin(), a.end(), pair.begin() );
+         std::copy( b.begin(), b.end(), pair.begin() + 32 );
+      }
+      node = sha256( (const char*)pair.data(), pair.size() );
+      path >>= 1;
+   }
+   check( node == drop.root, "invalid merkle proof" );
+
+   claimbitmaps _claimbitmap( get_self(), sym.code().raw() );
+   uint64_t word = ((uint64_t)dropid << 32) + index / 64;
+   uint64_t bit = 1ULL << (index % 64);
+   auto itbits = _claimbitmap.find( word );
+   if( itbits == _claimbitmap.end() ) {
+      _claimbitmap.emplace(user, [&](auto &row) {
+         row.word = word;
+         row.bits = bit;
+      });
+   } else {
+      check( (itbits->bits & bit) == 0, "airdrop has already been claimed" );
+      _claimbitmap.modify(itbits, same_payer, [&](auto &row) {
+         row.bits |= bit;
+      });
+   }
+
+   _airdrop.modify(drop, same_payer, [&](auto &row) {
+      row.remaining -= quantity;
+   });
+
+   sub_balance( get_self(), quantity, get_self() );
+   add_balance( user.value, sym.code().raw(), quantity, user, true );
+   if( lockruleid != no_lock_ruleid ) {
+      tokenpools _tokenpool( get_self(), sym.code().raw() );
+      const auto& poolacc = _tokenpool.get( drop.owner.value, "only token pool account can airdrop locked asset" );
+      add_lock( user, user, quantity, lockruleid );
+   }
+}
+
+void yottatoken::reclaim( uint32_t dropid, const asset& value )
+{
+   auto sym = value.symbol;
+   check( sym.is_valid(), "invalid symbol when reclaim" );
+   airdrops _airdrop( get_self(), sym.code().raw() );
+   const auto& drop = _airdrop.get( dropid, "airdrop is not existed" );
+   require_auth( drop.owner );
+   check( current_time_point().sec_since_epoch() > drop.deadline, "airdrop has not expired" );
+   check( drop.remaining.amount > 0, "nothing to reclaim" );
+
+   auto remaining = drop.remaining;
+   //the row is kept so that its id, and so its claim bitmap, cannot be reused
+   _airdrop.modify(drop, same_payer, [&](auto &row) {
+      row.remaining.amount = 0;
+   });
+
+   sub_balance( get_self(), remaining, get_self() );
+   add_balance( drop.owner.value, sym.code().raw(), remaining, drop.owner, true );
+}
+
+void yottatoken::setckpt( const asset& value, uint32_t interval, uint32_t max_count )
+{
+   auto sym = value.symbol;
+   check( sym.is_valid(), "invalid symbol when setckpt" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed when setckpt" );
+   check( sym == st.supply.symbol, "symbol or precision mismatch" );
+   require_auth( st.issuer );
+
+   ckptconfigs _ckptconfig( get_self(), sym.code().raw() );
+   auto cfg = _ckptconfig.find( sym.code().raw() );
+   if( interval == 0 ) {
+      check( cfg != _ckptconfig.end(), "checkpoint is not enabled" );
+      _ckptconfig.erase( cfg );
+      return;
+   }
+   check( max_count > 0, "max_count must be a positive number" );
+   //history starts at the next interval boundary, so it never mixes with checkpoints written before
+   uint32_t curtime = current_time_point().sec_since_epoch(); //seconds
+   uint32_t start = curtime - curtime % interval + interval;
+   if( cfg == _ckptconfig.end() ) {
+      _ckptconfig.emplace(st.issuer, [&](auto &row) {
+         row.sym         = sym;
+         row.tokenno     = st.tokenno;
+         row.interval    = interval;
+         row.max_count   = max_count;
+         row.start       = start;
+      });
+   } else {
+      _ckptconfig.modify(cfg, same_payer, [&](auto &row) {
+         row.interval    = interval;
+         row.max_count   = max_count;
+         row.start       = start;
+      });
+   }
+}
+
+asset yottatoken::balanceat( const name& owner, const asset& value, uint32_t time )
+{
+   auto sym = value.symbol;
+   check( sym.is_valid(), "invalid symbol when balanceat" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed when balanceat" );
+   check( sym == st.supply.symbol, "symbol or precision mismatch" );
+   ckptconfigs _ckptconfig( get_self(), sym.code().raw() );
+   const auto& cfg = _ckptconfig.get( sym.code().raw(), "checkpoint is not enabled" );
+
+   uint64_t curtime = current_time_point().sec_since_epoch(); //seconds
+   uint64_t bound = time - time % cfg.interval;
+   check( time <= curtime, "time should not be in the future" );
+   check( bound >= cfg.start, "time is before checkpoint history" );
+   check( bound + (uint64_t)cfg.interval * cfg.max_count >= curtime, "checkpoint history has been pruned" );
+
+   //each checkpoint holds the balance at its interval's start and no balance changed in between
+   uint64_t prefix = (uint64_t)cfg.tokenno << 32;
+   balckpts _balckpt( get_self(), owner.value );
+   auto it = _balckpt.lower_bound( prefix + bound );
+   if( it != _balckpt.end() && it->no_time < prefix + ((uint64_t)1 << 32) ) {
+      return asset( it->balance, sym );
+   }
+   accounts _acnts( get_self(), owner.value );
+   auto acc = _acnts.find( sym.code().raw() );
+   return asset( acc == _acnts.end() ? 0 : acc->balance.amount, sym );
+}
 
+void yottatoken::newstream( const name& sender, const name& recipient, const asset& quantity,
+                            uint32_t start, uint32_t end, const string& memo )
+{
+   require_auth( sender );
+   check( sender != recipient, "cannot stream to self" );
+   check( is_account( recipient ), "recipient account does not exist" );
+   auto sym = quantity.symbol;
+   check( sym.is_valid(), "invalid symbol when newstream" );
+   check( quantity.is_valid(), "invalid quantity" );
+   check( quantity.amount > 0, "must stream positive quantity" );
+   check( memo.size() <= 256, "memo has more than 256 bytes" );
+   check( end > start, "end should be later than start" );
+   check( end > current_time_point().sec_since_epoch(), "end should be in the future" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed when newstream" );
+   check( sym == st.supply.symbol, "symbol or precision mismatch" );
+
+   require_recipient( recipient );
+
+   sub_balance( sender, quantity, sender );
+   add_balance( get_self().value, sym.code().raw(), quantity, sender, true );
+
+   streams _stream( get_self(), sym.code().raw() );
+   _stream.emplace(sender, [&](auto &row) {
+      row.streamid     = _stream.available_primary_key();
+      row.sender       = sender;
+      row.recipient    = recipient;
+      row.quantity     = quantity;
+      row.withdrawn    = 0;
+      row.start        = start;
+      row.end          = end;
+   });
+}
+
+void yottatoken::withdraw( uint64_t streamid, const asset& value )
+{
+   auto sym = value.symbol;
+   check( sym.is_valid(), "invalid symbol when withdraw" );
+   streams _stream( get_self(), sym.code().raw() );
+   const auto& it = _stream.get( streamid, "stream is not existed" );
+   require_auth( it.recipient );
+
+   asset payable( it.accrued( current_time_point().sec_since_epoch() ) - it.withdrawn, sym );
+   check( payable.amount > 0, "nothing to withdraw" );
+
+   auto recipient = it.recipient;
+   if( it.withdrawn + payable.amount == it.quantity.amount ) {
+      _stream.erase( it );
+   } else {
+      _stream.modify(it, same_payer, [&](auto &row) {
+         row.withdrawn += payable.amount;
+      });
+   }
+
+   sub_balance( get_self(), payable, get_self() );
+   add_balance( recipient.value, sym.code().raw(), payable, recipient, true );
+}
+
+void yottatoken::cancelstream( uint64_t streamid, const asset& value )
+{
+   auto sym = value.symbol;
+   check( sym.is_valid(), "invalid symbol when cancelstream" );
+   streams _stream( get_self(), sym.code().raw() );
+   const auto& it = _stream.get( streamid, "stream is not existed" );
+   require_auth( it.sender );
+
+   auto sender = it.sender;
+   auto recipient = it.recipient;
+   int64_t accrued = it.accrued( current_time_point().sec_since_epoch() );
+   asset payable( accrued - it.withdrawn, sym );
+   asset refund( it.quantity.amount - accrued, sym );
+   _stream.erase( it );
+
+   require_recipient( recipient );
+
+   if( payable.amount > 0 ) {
+      sub_balance( get_self(), payable, get_self() );
+      add_balance( recipient.value, sym.code().raw(), payable, sender, true );
+   }
+   if( refund.amount > 0 ) {
+      sub_balance( get_self(), refund, get_self() );
+      add_balance( sender.value, sym.code().raw(), refund, sender, true );
+   }
+}
+
+uint32_t yottatoken::migrate( const name& table, uint64_t scope, uint32_t max_rows )
+{
+   require_auth( get_self() );
+   check( max_rows > 0, "max_rows must be a positive number" );
+
+   //converted rows are erased from the old table, so its first row is always the cursor
+   uint32_t moved = 0;
+   if( table == "acclock"_n ) {
+      acclocks _acclock1( get_self(), scope );
+      for( auto it = _acclock1.begin(); moved < max_rows && it != _acclock1.end(); it = _acclock1.begin() ) {
+         moved += upgrade_acclock( it->quantity.symbol.code(), name(scope) );
+      }
+   } else if( table == "numlock"_n ) {
+      numlocks _numlock1( get_self(), scope );
+      for( auto it = _numlock1.begin(); moved < max_rows && it != _numlock1.end(); it = _numlock1.begin() ) {
+         upgrade_numlock( symbol_code(scope), it->user );
+         moved++;
+      }
+   } else if( table == "loanpool"_n ) {
+      loanpools _loanpool1( get_self(), scope );
+      for( auto it = _loanpool1.begin(); moved < max_rows && it != _loanpool1.end(); it = _loanpool1.begin() ) {
+         upgrade_loan( symbol_code(scope), it->from );
+         moved++;
+      }
+   } else if( table == "lockrule"_n ) {
+      lockrules _lockrule1( get_self(), scope );
+      for( auto it = _lockrule1.begin(); moved < max_rows && it != _lockrule1.end(); it = _lockrule1.begin() ) {
+         upgrade_lockrule( symbol_code(scope), it->lockruleid );
+         moved++;
+      }
+   } else {
+      check( false, "unknown table to migrate" );
+   }
+   return moved;
+}
+
+void yottatoken::changelog( const std::vector<change>& changes )
+{
+   require_auth( get_self() );
+}
+
+yottatoken::~yottatoken()
+{
+   if( _changes.empty() )
+      return;
+   auto acc_self = get_self();
+   changelog_action( acc_self, permission_level{acc_self, "active"_n} ).send( _changes );
+}
+
+void yottatoken::setreward( const asset& value )
+{
+   auto sym = value.symbol;
+   check( sym.is_valid(), "invalid symbol when setreward" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed when setreward" );
+   check( sym == st.supply.symbol, "symbol or precision mismatch" );
+   require_auth( st.issuer );
+
+   rewardstates _rewardstate( get_self(), sym.code().raw() );
+   check( _rewardstate.find( sym.code().raw() ) == _rewardstate.end(), "reward has already been enabled" );
+   _rewardstate.emplace(st.issuer, [&](auto &row) {
+      row.sym     = sym;
+      row.index   = 0;
+   });
+}
+
+void yottatoken::addreward( const name& pool, const asset& quantity )
+{
+   require_auth( pool );
+   auto sym = quantity.symbol;
+   check( sym.is_valid(), "invalid symbol when addreward" );
+   check( quantity.is_valid(), "invalid quantity" );
+   check( quantity.amount > 0, "must add positive reward" );
+   tokenpools _tokenpool( get_self(), sym.code().raw() );
+   const auto& poolacc = _tokenpool.get( pool.value, "only token pool account can addreward" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed when addreward" );
+   check( sym == st.supply.symbol, "symbol or precision mismatch" );
+   rewardstates _rewardstate( get_self(), sym.code().raw() );
+   const auto& rs = _rewardstate.get( sym.code().raw(), "reward is not enabled" );
+
+   sub_balance( pool, quantity, pool );
+   add_balance( get_self().value, sym.code().raw(), quantity, pool, true );
+
+   accounts self_acnts( get_self(), get_self().value );
+   const auto& self_token = self_acnts.get( sym.code().raw() );
+   int64_t eligible = st.supply.amount - self_token.balance.amount;
+   check( eligible > 0, "no balance to reward" );
+
+   _rewardstate.modify(rs, same_payer, [&](auto &row) {
+      row.index += (uint128_t)quantity.amount * reward_scale / (uint128_t)eligible;
+   });
+}
+
+void yottatoken::claimreward( const name& owner, const asset& value )
+{
+   require_auth( owner );
+   auto sym = value.symbol;
+   check( sym.is_valid(), "invalid symbol when claimreward" );
+   accounts _acnts( get_self(), owner.value );
+   const auto& acc = _acnts.get( sym.code().raw(), "Account does not have this token" );
+
+   settle_reward( owner, acc.balance.amount, sym, owner );
+   rewardaccs _rewardacc( get_self(), owner.value );
+   const auto& ra = _rewardacc.get( sym.code().raw(), "no reward to claim" );
+   check( ra.pending > 0, "no reward to claim" );
+
+   asset reward( ra.pending, sym );
+   _rewardacc.modify(ra, same_payer, [&](auto &row) {
+      row.pending = 0;
+   });
+
+   sub_balance( get_self(), reward, get_self() );
+   add_balance( owner.value, sym.code().raw(), reward, owner, true );
+}
+
+void yottatoken::regsubledger( const name& owner, const asset& value )
+{
+   require_auth( owner );
+   auto sym = value.symbol;
+   check( sym.is_valid(), "invalid symbol when regsubledger" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed when regsubledger" );
+   check( sym == st.supply.symbol, "symbol or precision mismatch" );
+
+   subledgers _subledger( get_self(), sym.code().raw() );
+   check( _subledger.find( owner.value ) == _subledger.end(), "user has already registered as sub-ledger owner" );
+   _subledger.emplace(owner, [&](auto &row) {
+      row.owner       = owner;
+      row.allocated   = 0;
+   });
+}
+
+void yottatoken::subtransfer( const name& from, const name& to, uint32_t subid, const asset& quantity, const string& memo )
+{
+   check( from != to, "cannot transfer to self" );
+   auto sym = quantity.symbol;
+   check( sym.is_valid(), "invalid symbol when subtransfer" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed." );
+
+   require_auth( from );
+
+   require_recipient( from );
+   require_recipient( to );
+
+   check( quantity.is_valid(), "invalid quantity" );
+   check( quantity.amount > 0, "must transfer positive quantity" );
+   check( quantity.symbol == st.supply.symbol, "symbol or precision mismatch" );
+   check( memo.size() <= 256, "memo has more than 256 bytes" );
+
+   subledgers _subledger( get_self(), sym.code().raw() );
+   const auto& ledger = _subledger.get( to.value, "to account is not a sub-ledger owner" );
+   _subledger.modify(ledger, same_payer, [&](auto &row) {
+      row.allocated += quantity.amount;
+   });
+   add_sub_balance( to, sym.code(), ((uint64_t)st.tokenno << 32) + subid, quantity.amount, from );
+
+   sub_balance( from, quantity, from );
+   add_balance( to.value, sym.code().raw(), quantity, from, true );
+}
+
+void yottatoken::submove( const name& owner, uint32_t from_subid, uint32_t to_subid, const asset& quantity )
+{
+   require_auth( owner );
+   check( from_subid != to_subid, "cannot move to the same sub-account" );
+   auto sym = quantity.symbol;
+   check( sym.is_valid(), "invalid symbol when submove" );
+   check( quantity.amount > 0, "must move positive quantity" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed." );
+   check( quantity.symbol == st.supply.symbol, "symbol or precision mismatch" );
+
+   uint64_t prefix = (uint64_t)st.tokenno << 32;
+   sub_sub_balance( owner, sym.code(), prefix + from_subid, quantity.amount );
+   add_sub_balance( owner, sym.code(), prefix + to_subid, quantity.amount, owner );
+}
+
+void yottatoken::subwithdraw( const name& owner, uint32_t subid, const name& to, const asset& quantity, const string& memo )
+{
+   check( owner != to, "cannot transfer to self" );
+   check( is_account( to ), "to account does not exist");
+   auto sym = quantity.symbol;
+   check( sym.is_valid(), "invalid symbol when subwithdraw" );
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed." );
+
+   require_auth( owner );
+
+   require_recipient( owner );
+   require_recipient( to );
+
+   check( quantity.is_valid(), "invalid quantity" );
+   check( quantity.amount > 0, "must transfer positive quantity" );
+   check( quantity.symbol == st.supply.symbol, "symbol or precision mismatch" );
+   check( memo.size() <= 256, "memo has more than 256 bytes" );
+
+   subledgers _subledger( get_self(), sym.code().raw() );
+   const auto& ledger = _subledger.get( owner.value, "owner is not a sub-ledger owner" );
+   _subledger.modify(ledger, same_payer, [&](auto &row) {
+      row.allocated -= quantity.amount;
+   });
+   sub_sub_balance( owner, sym.code(), ((uint64_t)st.tokenno << 32) + subid, quantity.amount );
+
+   sub_balance( owner, quantity, owner );
+   add_balance( to.value, sym.code().raw(), quantity, owner, true );
+}
+
+void yottatoken::setchainid( const checksum256& chain_id )
+{
+   require_auth( get_self() );
+   chaininfo_singleton _chaininfo( get_self(), get_self().value );
+   check( !_chaininfo.exists(), "chain id has already been set" );
+   chaininfo info = chaininfo{};
+   info.chain_id = chain_id;
+   _chaininfo.set( info, get_self() );
+}
+
+void yottatoken::setrelaykey( const name& account, const public_key& key )
+{
+   require_auth( account );
+   relaykeys _relaykey( get_self(), get_self().value );
+   auto it = _relaykey.find( account.value );
+   if( it == _relaykey.end() ) {
+      _relaykey.emplace(account, [&](auto &row) {
+         row.account = account;
+         row.key     = key;
+      });
+   } else {
+      _relaykey.modify(it, account, [&](auto &row) {
+         row.key     = key;
+      });
+   }
+}
+
+void yottatoken::relay( const name& relayer, const std::vector<transfer_intent>& intents )
+{
+   require_auth( relayer );
+   check( intents.size() > 0, "no transfer to relay" );
+   check( intents.size() <= 500, "too many transfers to relay" );
+
+   chaininfo_singleton _chaininfo( get_self(), get_self().value );
+   check( _chaininfo.exists(), "chain id has not been set" );
+   auto chain_id = _chaininfo.get().chain_id;
+   relaykeys _relaykey( get_self(), get_self().value );
+   uint64_t curtime = current_time_point().sec_since_epoch(); //seconds
+   for( const auto& in : intents ) {
+      check( in.from != in.to, "cannot transfer to self" );
+      check( is_account( in.to ), "to account does not exist");
+      check( curtime <= in.expiry, "transfer has expired" );
+      auto sym = in.quantity.symbol;
+      check( sym.is_valid(), "invalid symbol when relay" );
+      check( in.quantity.is_valid(), "invalid quantity" );
+      check( in.quantity.amount > 0, "must transfer positive quantity" );
+      stats statstable( get_self(), sym.code().raw() );
+      const auto& st = statstable.get( sym.code().raw(), "token is not existed." );
+      check( sym == st.supply.symbol, "symbol or precision mismatch" );
+
+      const auto& rk = _relaykey.get( in.from.value, "relay key is not set" );
+      auto data = eosio::pack( std::make_tuple( chain_id, get_self(), in.from, in.to, in.quantity, in.nonce, in.expiry ) );
+      assert_recover_key( sha256( data.data(), data.size() ), in.sig, rk.key );
+
+      noncebitmaps _noncebitmap( get_self(), in.from.value );
+      uint64_t word = in.nonce / 64;
+      uint64_t bit = 1ULL << (in.nonce % 64);
+      auto itbits = _noncebitmap.find( word );
+      if( itbits == _noncebitmap.end() ) {
+         _noncebitmap.emplace(relayer, [&](auto &row) {
+            row.word = word;
+            row.bits = bit;
+         });
+      } else {
+         check( (itbits->bits & bit) == 0, "nonce has already been used" );
+         _noncebitmap.modify(itbits, same_payer, [&](auto &row) {
+            row.bits |= bit;
+         });
+      }
+
+      require_recipient( in.from );
+      require_recipient( in.to );
+
+      sub_balance( in.from, in.quantity, relayer );
+      add_balance( in.to.value, sym.code().raw(), in.quantity, relayer, true );
+   }
+}
+
+asset yottatoken::get_lock_asset( const name& user, const asset& value )
+{
+   auto sym = value.symbol;
+   stats statstable( get_self(), sym.code().raw() );
+   const auto& st = statstable.get( sym.code().raw(), "token is not existed" );
+   check( sym == st.supply.symbol, "symbol or precision mismatch" );
+   uint64_t curtime = current_time_point().sec_since_epoch(); //seconds
+
+   lock_store store( get_self(), user, sym.code(), st.tokenno );
+   return asset( yotta::locked_balance( store, st.time, curtime ), sym );
+}
+
+void yottatoken::add_lock( const name& ram_payer, const name& to, const asset& quantity, uint32_t lockruleid )
+{
+   auto sym = quantity.symbol;
    if (lockruleid == 0) {
-      numlocks _numlock( get_self(), sym.code().raw() );
+      upgrade_numlock( sym.code(), to );
+      numlocks2 _numlock( get_self(), sym.code().raw() );
       auto it = _numlock.find( to.value );
       if( it == _numlock.end() ) {
-         _numlock.emplace(from, [&](auto &row) {
+         _numlock.emplace(ram_payer, [&](auto &row) {
             row.user = to;
-            row.quantity = quantity;
+            row.amount = quantity.amount;
          });
+         log_change( numlock_change, to, sym.code(), 0, 0, quantity.amount );
       } else {
-         _numlock.modify(it, from, [&](auto &row) {
-            row.quantity += quantity;
+         _numlock.modify(it, ram_payer, [&](auto &row) {
+            row.amount += quantity.amount;
          });
+         log_change( numlock_change, to, sym.code(), 0, it->amount - quantity.amount, it->amount );
       }
       return;
    }
-   lockrules _lockrule( get_self(), sym.code().raw() );
-   const auto& itrule = _lockrule.get( lockruleid, "lockruleid not existed in rule table" );
+   lockrules2 _lockrule( get_self(), sym.code().raw() );
+   if( _lockrule.find( lockruleid ) == _lockrule.end() ) {
+      lockrules _lockrule1( get_self(), sym.code().raw() );
+      const auto& itrule = _lockrule1.get( lockruleid, "lockruleid not existed in rule table" );
+   }
    stats statstable( get_self(), sym.code().raw() );
    const auto& st = statstable.get( sym.code().raw(), "token is not existed" );
-   uint64_t no_ruleid = lockruleid + ((uint64_t)st.tokenno << 32);
-   acclocks _acclock( get_self(), to.value );
-   auto _sym_lock = _acclock.get_index<"symbol"_n>();
-   auto it = _sym_lock.find( sym.code().raw() );
+   uint64_t prefix = (uint64_t)st.tokenno << 32;
+   uint64_t no_ruleid = lockruleid + prefix;
+   upgrade_acclock( sym.code(), to );
+   acclocks2 _acclock( get_self(), to.value );
 
    size_t rules_no = 0;
-   while(it != _sym_lock.end() && it->quantity.symbol.code().raw() == sym.code().raw() ) {
+   for( auto it = _acclock.lower_bound( prefix ); it != _acclock.end() && it->no_ruleid < prefix + ((uint64_t)1 << 32); it++ ) {
       rules_no++;
       if (it->no_ruleid == no_ruleid) {
-         _sym_lock.modify(it, same_payer, [&](auto &row) {
+         _acclock.modify(it, same_payer, [&](auto &row) {
             row.time = current_time_point().sec_since_epoch();
-            row.quantity.amount += quantity.amount;
+            row.amount += quantity.amount;
          });
+         log_change( acclock_change, to, sym.code(), no_ruleid, it->amount - quantity.amount, it->amount );
          return;
       }
-      it++;
    }
    check( rules_no <= 100, "lock rules of account is too many" );
-   auto itlc = _acclock.find(no_ruleid);
-   if(itlc == _acclock.end()) {
-      _acclock.emplace(from, [&](auto &row) {
-         row.no_ruleid       = no_ruleid;
-         row.quantity        = quantity;
-         row.user            = to;
-         row.time            = current_time_point().sec_since_epoch();
-      });
-   }
+   _acclock.emplace(ram_payer, [&](auto &row) {
+      row.no_ruleid       = no_ruleid;
+      row.amount          = quantity.amount;
+      row.time            = current_time_point().sec_since_epoch();
+   });
+   log_change( acclock_change, to, sym.code(), no_ruleid, 0, quantity.amount );
 }
 
-void yottatoken::unlockasset( const name& acc, const asset& value, const string& memo )
+void yottatoken::record_checkpoint( const name& owner, int64_t before, const symbol& sym, const name& ram_payer )
 {
-   auto sym = value.symbol;
-   check( sym.is_valid(), "invalid symbol when unlockasset" );
-   check( memo.size() <= 256, "memo has more than 256 bytes" );
-   check( value.amount >= 0, "cannot lock negative quantity" );
-   stats statstable( get_self(), sym.code().raw() );
-   const auto& st = statstable.get( sym.code().raw(), "token is not existed when unlockasset" );
-   require_auth( st.unlocker );
+   ckptconfigs _ckptconfig( get_self(), sym.code().raw() );
+   auto cfg = _ckptconfig.find( sym.code().raw() );
+   if( cfg == _ckptconfig.end() )
+      return;
+   uint64_t curtime = current_time_point().sec_since_epoch(); //seconds
+   if( curtime < cfg->start )
+      return;
 
-   accounts _acnts( get_self(), acc.value );
-   const auto& to = _acnts.get( sym.code().raw(),  "Account does not have this token");
+   //only the first change of an interval is kept, with the balance before it
+   uint64_t prefix = (uint64_t)cfg->tokenno << 32;
+   uint64_t bound = curtime - curtime % cfg->interval;
+   balckpts _balckpt( get_self(), owner.value );
+   auto last = _balckpt.lower_bound( prefix + ((uint64_t)1 << 32) );
+   if( last != _balckpt.begin() ) {
+      last--;
+      if( last->no_time >= prefix + bound )
+         return;
+   }
 
-   numlocks _numlock( get_self(), sym.code().raw() );
-   const auto& it = _numlock.get( acc.value, "lockasset isn't existed" );
-   check( it.quantity.amount >= value.amount, "locking asset should less than before" );
-   if ( it.quantity.amount == value.amount ) {
-      _numlock.erase( it );
-   } else {
-      _numlock.modify(it, st.unlocker, [&](auto &row) {
-         row.quantity.amount -= value.amount;
-      });
+   _balckpt.emplace(ram_payer, [&](auto &row) {
+      row.no_time = prefix + bound;
+      row.balance = before;
+   });
+
+   uint64_t keep = (uint64_t)cfg->interval * cfg->max_count;
+   if( bound > keep ) {
+      auto it = _balckpt.lower_bound( prefix );
+      while( it != _balckpt.end() && it->no_time < prefix + (bound - keep) ) {
+         it = _balckpt.erase( it );
+      }
    }
 }
 
-asset yottatoken::get_lock_asset( const name& user, const asset& value )
+int64_t yottatoken::get_loan_amount( const name& from, const symbol& sym )
 {
-   auto sym = value.symbol;
-   asset lockasset( 0, sym );
-
-   numlocks _numlock( get_self(), sym.code().raw() );
-   auto il = _numlock.find( user.value );
-   if( il != _numlock.end() )
-      lockasset.amount = il->quantity.amount;
+   loanpools2 _loanpool( get_self(), sym.code().raw() );
+   auto loan = _loanpool.find( from.value );
+   if( loan != _loanpool.end() )
+      return loan->amount;
+   loanpools _loanpool1( get_self(), sym.code().raw() );
+   auto loan1 = _loanpool1.find( from.value );
+   return loan1 == _loanpool1.end() ? 0 : loan1->quantity.amount;
+}
 
-   stats statstable( get_self(), sym.code().raw() );
-   const auto& st = statstable.get( sym.code().raw(), "token is not existed" );
-   check( sym == st.supply.symbol, "symbol or precision mismatch" );
-   acclocks _acclock( get_self(), user.value );
-   uint64_t curtime = current_time_point().sec_since_epoch(); //seconds
+int64_t yottatoken::get_allocated( const name& owner, const symbol& sym )
+{
+   subledgers _subledger( get_self(), sym.code().raw() );
+   auto ledger = _subledger.find( owner.value );
+   return ledger == _subledger.end() ? 0 : ledger->allocated;
+}
 
-   auto _sym_lock = _acclock.get_index<"symbol"_n>();
-   auto it = _sym_lock.find( sym.code().raw() );
+void yottatoken::upgrade_numlock( const symbol_code& code, const name& user )
+{
+   numlocks _numlock1( get_self(), code.raw() );
+   auto it = _numlock1.find( user.value );
+   if( it == _numlock1.end() )
+      return;
+   numlocks2 _numlock( get_self(), code.raw() );
+   _numlock.emplace(get_self(), [&](auto &row) {
+      row.user = user;
+      row.amount = it->quantity.amount;
+   });
+   _numlock1.erase( it );
+}
 
-   while(it != _sym_lock.end() && it->quantity.symbol.code().raw() == sym.code().raw() ) {
-      int64_t amount = it->quantity.amount;
-      uint64_t extime = st.time; //exchanging time
+void yottatoken::upgrade_loan( const symbol_code& code, const name& from )
+{
+   loanpools _loanpool1( get_self(), code.raw() );
+   auto it = _loanpool1.find( from.value );
+   if( it == _loanpool1.end() )
+      return;
+   loanpools2 _loanpool( get_self(), code.raw() );
+   _loanpool.emplace(get_self(), [&](auto &row) {
+      row.from = from;
+      row.manager = it->manager;
+      row.amount = it->quantity.amount;
+   });
+   _loanpool1.erase( it );
+}
 
-      lockrules _lockrule( get_self(), sym.code().raw() );
-      auto itrule = _lockrule.find(it->no_ruleid & 0xffffffff);
-      if ( extime == 0 || itrule == _lockrule.end() || curtime <= extime) {
-         lockasset.amount += amount;
+uint32_t yottatoken::upgrade_acclock( const symbol_code& code, const name& user )
+{
+   acclocks _acclock1( get_self(), user.value );
+   auto _sym_lock = _acclock1.get_index<"symbol"_n>();
+   auto it = _sym_lock.find( code.raw() );
+   if( it == _sym_lock.end() || it->quantity.symbol.code().raw() != code.raw() )
+      return 0;
+
+   acclocks2 _acclock( get_self(), user.value );
+   uint32_t moved = 0;
+   while(it != _sym_lock.end() && it->quantity.symbol.code().raw() == code.raw() ) {
+      auto no_ruleid = it->no_ruleid;
+      auto itlc = _acclock.find( no_ruleid );
+      if( itlc == _acclock.end() ) {
+         _acclock.emplace(get_self(), [&](auto &row) {
+            row.no_ruleid = no_ruleid;
+            row.amount    = it->quantity.amount;
+            row.time      = (uint32_t)it->time;
+         });
       } else {
-         uint32_t percent = 0;
-         if ( itrule->times.size() == 1 ) { //lock by period
-            int64_t numerator = (int64_t)curtime - (int64_t)extime - (int64_t)itrule->times[0];
-            int64_t periods = numerator / (int64_t)itrule->period;
-            if (numerator > 0 && periods >= 1) {
-               percent = itrule->pcts[0] * periods;
-               if (percent < itrule->base) {
-                  percent = itrule->base - percent;
-                  lockasset.amount += (int64_t)( (double)amount * percent / itrule->base);
-               }
-            } else {
-               lockasset.amount += amount;
-            }
-         } else {
-            size_t n = 0;
-            for(auto itt = itrule->times.begin(); itt != itrule->times.end(); itt++) {
-               if( extime + *itt > curtime ) {
-                     break;
-               }
-               percent = itrule->pcts[n];
-               n++;
-            }
-            percent = itrule->base - percent;
-            lockasset.amount += (int64_t)( (double)amount * percent / itrule->base);
-         }
+         _acclock.modify(itlc, same_payer, [&](auto &row) {
+            row.amount += it->quantity.amount;
+         });
       }
+      it = _sym_lock.erase( it );
+      moved++;
+   }
+   return moved;
+}
+
+void yottatoken::upgrade_lockrule( const symbol_code& code, uint32_t lockruleid )
+{
+   lockrules _lockrule1( get_self(), code.raw() );
+   auto it = _lockrule1.find( lockruleid );
+   if( it == _lockrule1.end() )
+      return;
+   lockrules2 _lockrule( get_self(), code.raw() );
+   _lockrule.emplace(get_self(), [&](auto &row) {
+      row.lockruleid   = it->lockruleid;
+      for( auto t : it->times ) {
+         //times beyond uint32 never unlock, which stays true after clamping
+         row.times.push_back( (uint32_t)std::min<uint64_t>( t, std::numeric_limits<uint32_t>::max() ) );
+      }
+      row.pcts         = it->pcts;
+      row.base         = it->base;
+      row.period       = it->period;
+      row.desc         = it->desc;
+   });
+   _lockrule1.erase( it );
+}
+
+void yottatoken::balance_changed( const name& owner, int64_t before, const asset& balance, const name& ram_payer )
+{
+   log_change( balance_change, owner, balance.symbol.code(), 0, before, balance.amount );
+   record_checkpoint( owner, before, balance.symbol, ram_payer );
+   settle_reward( owner, before, balance.symbol, ram_payer );
+}
+
+void yottatoken::settle_reward( const name& owner, int64_t balance, const symbol& sym, const name& ram_payer )
+{
+   if( owner == get_self() )
+      return;
+   rewardstates _rewardstate( get_self(), sym.code().raw() );
+   auto rs = _rewardstate.find( sym.code().raw() );
+   if( rs == _rewardstate.end() )
+      return;
 
-      it++;
+   rewardaccs _rewardacc( get_self(), owner.value );
+   auto ra = _rewardacc.find( sym.code().raw() );
+   uint128_t paid_index = ra == _rewardacc.end() ? 0 : ra->paid_index;
+   if( paid_index == rs->index )
+      return;
+
+   int64_t earned = (int64_t)( (uint128_t)balance * (rs->index - paid_index) / reward_scale );
+   if( ra == _rewardacc.end() ) {
+      _rewardacc.emplace(ram_payer, [&](auto &row) {
+         row.sym          = sym;
+         row.paid_index   = rs->index;
+         row.pending      = earned;
+      });
+   } else {
+      _rewardacc.modify(ra, same_payer, [&](auto &row) {
+         row.paid_index   = rs->index;
+         row.pending     += earned;
+      });
+   }
+}
+
+void yottatoken::log_change( uint8_t kind, const name& account, const symbol_code& code, uint64_t key,
+                             int64_t before, int64_t after )
+{
+   _changes.push_back( change{ kind, account, code, key, before, after } );
+}
+
+void yottatoken::add_sub_balance( const name& owner, const symbol_code& code, uint64_t no_subid, int64_t amount,
+                                  const name& ram_payer )
+{
+   subbalances _subbalance( get_self(), owner.value );
+   auto it = _subbalance.find( no_subid );
+   if( it == _subbalance.end() ) {
+      _subbalance.emplace(ram_payer, [&](auto &row) {
+         row.no_subid = no_subid;
+         row.balance  = amount;
+      });
+      log_change( subledger_change, owner, code, no_subid, 0, amount );
+   } else {
+      _subbalance.modify(it, same_payer, [&](auto &row) {
+         row.balance += amount;
+      });
+      log_change( subledger_change, owner, code, no_subid, it->balance - amount, it->balance );
    }
+}
 
-   return lockasset;
+void yottatoken::sub_sub_balance( const name& owner, const symbol_code& code, uint64_t no_subid, int64_t amount )
+{
+   subbalances _subbalance( get_self(), owner.value );
+   const auto& it = _subbalance.get( no_subid, "sub-account is not existed" );
+   check( it.balance >= amount, "overdrawn sub-account balance" );
+   log_change( subledger_change, owner, code, no_subid, it.balance, it.balance - amount );
+   if( it.balance == amount ) {
+      _subbalance.erase( it );
+   } else {
+      _subbalance.modify(it, same_payer, [&](auto &row) {
+         row.balance -= amount;
+      });
+   }
 }
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <eosio/asset.hpp>
+#include <eosio/crypto.hpp>
 #include <eosio/eosio.hpp>
 #include <eosio/system.hpp>
 #include <eosio/singleton.hpp>
+#include <yotta.vesting.hpp>
 #include <string>
 using namespace eosio;
 using std::string;
@@ -16,6 +18,48 @@ class [[eosio::contract("yotta.token")]] yottatoken : public contract {
    public:
       using contract::contract;
 
+      ~yottatoken();
+
+      /**
+       * One state change made by an action, sent to `changelog` at the end of the action.
+       *
+       * `kind` is one of the `*_change` constants. `key` is the no_ruleid for acclock changes, the
+       * no_subid for sub-ledger changes, the manager for loan changes, the index in `accs` for
+       * skipped batchtrans credits and 0 otherwise. A skipped credit has the requested amount as
+       * `before` and 0 as `after`. For supply changes `account` is the issuer.
+       */
+      struct change {
+         uint8_t         kind;
+         name            account;
+         symbol_code     sym;
+         uint64_t        key;
+         int64_t         before;
+         int64_t         after;
+      };
+
+      static constexpr uint8_t balance_change   = 1;
+      static constexpr uint8_t numlock_change   = 2;
+      static constexpr uint8_t acclock_change   = 3;
+      static constexpr uint8_t loan_change      = 4;
+      static constexpr uint8_t supply_change    = 5;
+      static constexpr uint8_t skipped_credit   = 6;
+      static constexpr uint8_t subledger_change = 7;
+
+      /**
+       * A transfer signed off-chain by `from` with its relay key, see `relay`.
+       *
+       * The signed digest is sha256 of the packed (chain id, contract account, from, to, quantity, nonce,
+       * expiry), the chain id being the one set by `setchainid`.
+       */
+      struct transfer_intent {
+         name            from;
+         name            to;
+         asset           quantity;
+         uint64_t        nonce;
+         uint32_t        expiry; //seconds
+         signature       sig;
+      };
+
       //static constexpr symbol token_symbol = symbol(symbol_code(TOKEN_SYMBOL), 4);
 
       /**
@@ -42,8 +86,8 @@ class [[eosio::contract("yotta.token")]] yottatoken : public contract {
       [[eosio::action]]
       void create( const name&   issuer,
                    const asset&  maximum_supply,
-                   const string& token_name,
-                   const string& memo );
+                   const string& token_name,
+                   const string& memo );
 
       /**
        *  This action issues to `to` account a `quantity` of tokens.
@@ -238,6 +282,258 @@ class [[eosio::contract("yotta.token")]] yottatoken : public contract {
                       const asset&   value,
                       const string&  memo );
 
+      /**
+       * This action will escrow `total` for a claimable airdrop committed by a merkle root.
+       *
+       * Each leaf of the tree is sha256 of the packed (index, account, amount, lockruleid), where
+       * index is the position of the leaf and lockruleid follows `locktransfer` (0 for numlock),
+       * except `no_lock_ruleid` which gives unlocked asset.
+       *
+       * @param owner - the account which escrows the asset,
+       * @param dropid - id of the airdrop,
+       * @param root - merkle root of the leaves,
+       * @param total - the asset to escrow,
+       * @param deadline - after this time the owner can reclaim the unclaimed asset,
+       * @param memo - the memo.
+       */
+      [[eosio::action]]
+      void newairdrop( const name&        owner,
+                       uint32_t           dropid,
+                       const checksum256& root,
+                       const asset&       total,
+                       uint32_t           deadline,
+                       const string&      memo );
+
+      /**
+       * This action will claim a leaf of an airdrop.
+       *
+       * @param user - the account in the leaf,
+       * @param dropid - id of the airdrop,
+       * @param index - position of the leaf,
+       * @param quantity - the amount in the leaf,
+       * @param lockruleid - the lock rule in the leaf,
+       * @param proof - sibling hashes from the leaf up to the root.
+       */
+      [[eosio::action]]
+      void claim( const name&                     user,
+                  uint32_t                        dropid,
+                  uint32_t                        index,
+                  const asset&                    quantity,
+                  uint32_t                        lockruleid,
+                  const std::vector<checksum256>& proof );
+
+      /**
+       * This action will return the unclaimed asset of an airdrop to its owner after the deadline.
+       *
+       * @param dropid - id of the airdrop,
+       * @param value - in order to get the symbol of currency.
+       */
+      [[eosio::action]]
+      void reclaim( uint32_t dropid, const asset& value );
+
+      /**
+       * This action will set balance checkpointing of a token.
+       *
+       * When enabled, the first balance change of an account in each `interval` keeps a checkpoint
+       * with the balance at the start of that interval. Checkpoints older than `interval * max_count`
+       * are pruned. History starts at the next interval boundary, and setting it again restarts it.
+       *
+       * @param value - in order to get the symbol of currency,
+       * @param interval - seconds between checkpoints, 0 to disable,
+       * @param max_count - how many intervals of history are kept.
+       */
+      [[eosio::action]]
+      void setckpt( const asset& value, uint32_t interval, uint32_t max_count );
+
+      /**
+       * This action will return the balance of an account at `time` rounded down to a multiple of the
+       * checkpoint interval, i.e. before any change made later in that interval. It is read-only, so it can
+       * be sent with `send_read_only_transaction` without a signature.
+       *
+       * @param owner - which account,
+       * @param value - in order to get the symbol of currency,
+       * @param time - the time in seconds.
+       *
+       * @pre Checkpointing must be enabled and the rounded `time` must be within its kept history.
+       */
+      [[eosio::action, eosio::read_only]]
+      asset balanceat( const name& owner, const asset& value, uint32_t time );
+
+      /**
+       * This action will escrow `quantity` which accrues to `recipient` linearly from `start` to `end`.
+       *
+       * @param sender - the account which pays the stream,
+       * @param recipient - the account which receives the stream,
+       * @param quantity - the total of the stream,
+       * @param start - the time in seconds when accruing starts,
+       * @param end - the time in seconds when everything has accrued,
+       * @param memo - the memo.
+       */
+      [[eosio::action]]
+      void newstream( const name&    sender,
+                      const name&    recipient,
+                      const asset&   quantity,
+                      uint32_t       start,
+                      uint32_t       end,
+                      const string&  memo );
+
+      /**
+       * This action will pay the accrued and not yet withdrawn asset of a stream to its recipient.
+       *
+       * @param streamid - id of the stream,
+       * @param value - in order to get the symbol of currency.
+       */
+      [[eosio::action]]
+      void withdraw( uint64_t streamid, const asset& value );
+
+      /**
+       * This action will cancel a stream, the accrued asset goes to the recipient and the rest back to the sender.
+       *
+       * @param streamid - id of the stream,
+       * @param value - in order to get the symbol of currency.
+       */
+      [[eosio::action]]
+      void cancelstream( uint64_t streamid, const asset& value );
+
+      /**
+       * This action will convert up to `max_rows` rows of an old table to its compact v2 table.
+       * It can be called repeatedly until it returns 0 for every scope. Rows not converted yet are
+       * still read from the old tables.
+       *
+       * @param table - acclock (scoped by account), numlock, loanpool or lockrule (scoped by symbol code),
+       * @param scope - scope of the table,
+       * @param max_rows - the most rows to convert in this call.
+       *
+       * @return how many rows were converted.
+       */
+      [[eosio::action]]
+      uint32_t migrate( const name& table, uint64_t scope, uint32_t max_rows );
+
+      /**
+       * This action carries the changes made by an action of this contract, it is sent by the contract
+       * to itself and does nothing.
+       *
+       * @param changes - the changes in the order they were made.
+       */
+      [[eosio::action]]
+      void changelog( const std::vector<change>& changes );
+
+      /**
+       * This action will enable reward distribution of a token.
+       *
+       * Token pools deposit rewards with `addreward`, which raises a reward-per-token index. Every
+       * account earns its balance times the rise of the index, settled when its balance changes and
+       * paid by `claimreward`. Balances held by this contract (escrows and unpaid rewards) do not earn.
+       *
+       * @param value - in order to get the symbol of currency.
+       */
+      [[eosio::action]]
+      void setreward( const asset& value );
+
+      /**
+       * This action will deposit rewards for all holders of a token.
+       *
+       * @param pool - the token pool account which pays the rewards,
+       * @param quantity - the rewards.
+       */
+      [[eosio::action]]
+      void addreward( const name& pool, const asset& quantity );
+
+      /**
+       * This action will pay the rewards earned by an account.
+       *
+       * @param owner - which account,
+       * @param value - in order to get the symbol of currency.
+       */
+      [[eosio::action]]
+      void claimreward( const name& owner, const asset& value );
+
+      /**
+       * This action will register an account as a sub-ledger owner, e.g. an exchange hot account.
+       *
+       * Asset sent with `subtransfer` stays in the owner's balance and is also credited to a sub-account
+       * of the owner, so depositors do not need accounts rows of their own. The sum of the sub-account
+       * balances is reserved in the owner's balance like a loan: only `subwithdraw` can spend it.
+       *
+       * @param owner - which account,
+       * @param value - in order to get the symbol of currency.
+       */
+      [[eosio::action]]
+      void regsubledger( const name& owner, const asset& value );
+
+      /**
+       * Allows `from` account to transfer to a sub-account of `to` account the `quantity` tokens.
+       *
+       * @param from - transfer from which account,
+       * @param to - the sub-ledger owner,
+       * @param subid - id of the sub-account,
+       * @param quantity - the quantity of tokens to be transferred,
+       * @param memo - the memo string to accompany the transaction.
+       */
+      [[eosio::action]]
+      void subtransfer( const name&    from,
+                        const name&    to,
+                        uint32_t       subid,
+                        const asset&   quantity,
+                        const string&  memo );
+
+      /**
+       * This action will move asset between two sub-accounts of an owner.
+       *
+       * @param owner - the sub-ledger owner,
+       * @param from_subid - move from which sub-account,
+       * @param to_subid - move to which sub-account,
+       * @param quantity - the quantity of tokens to be moved.
+       */
+      [[eosio::action]]
+      void submove( const name&    owner,
+                    uint32_t       from_subid,
+                    uint32_t       to_subid,
+                    const asset&   quantity );
+
+      /**
+       * This action will withdraw asset of a sub-account to `to` account.
+       *
+       * @param owner - the sub-ledger owner,
+       * @param subid - withdraw from which sub-account,
+       * @param to - transfer to which account,
+       * @param quantity - the quantity of tokens to be withdrawn,
+       * @param memo - the memo string to accompany the transaction.
+       */
+      [[eosio::action]]
+      void subwithdraw( const name&    owner,
+                        uint32_t       subid,
+                        const name&    to,
+                        const asset&   quantity,
+                        const string&  memo );
+
+      /**
+       * This action set the id of the chain, which relayed transfers sign. It can be set only once.
+       *
+       * @param chain_id - the chain id.
+       */
+      [[eosio::action]]
+      void setchainid( const checksum256& chain_id );
+
+      /**
+       * This action will set the key with which an account signs relayed transfers.
+       *
+       * @param account - which account,
+       * @param key - the public key.
+       */
+      [[eosio::action]]
+      void setrelaykey( const name& account, const public_key& key );
+
+      /**
+       * This action will apply a batch of transfers signed off-chain, the relayer pays CPU, NET and RAM.
+       * Each nonce of an account can be used once.
+       *
+       * @param relayer - the account which submits the batch,
+       * @param intents - the signed transfers.
+       */
+      [[eosio::action]]
+      void relay( const name& relayer, const std::vector<transfer_intent>& intents );
+
       static asset get_supply( const name& token_contract_account, const symbol_code& sym_code )
       {
          stats statstable( token_contract_account, sym_code.raw() );
@@ -268,8 +564,32 @@ class [[eosio::contract("yotta.token")]] yottatoken : public contract {
       using batchtrans_action = eosio::action_wrapper<"batchtrans"_n, &yottatoken::batchtrans>;
       using locktransfer_action = eosio::action_wrapper<"locktransfer"_n, &yottatoken::locktransfer>;
       using unlockasset_action = eosio::action_wrapper<"unlockasset"_n, &yottatoken::unlockasset>;
+      using newairdrop_action = eosio::action_wrapper<"newairdrop"_n, &yottatoken::newairdrop>;
+      using claim_action = eosio::action_wrapper<"claim"_n, &yottatoken::claim>;
+      using reclaim_action = eosio::action_wrapper<"reclaim"_n, &yottatoken::reclaim>;
+      using setckpt_action = eosio::action_wrapper<"setckpt"_n, &yottatoken::setckpt>;
+      using balanceat_action = eosio::action_wrapper<"balanceat"_n, &yottatoken::balanceat>;
+      using newstream_action = eosio::action_wrapper<"newstream"_n, &yottatoken::newstream>;
+      using withdraw_action = eosio::action_wrapper<"withdraw"_n, &yottatoken::withdraw>;
+      using cancelstream_action = eosio::action_wrapper<"cancelstream"_n, &yottatoken::cancelstream>;
+      using migrate_action = eosio::action_wrapper<"migrate"_n, &yottatoken::migrate>;
+      using changelog_action = eosio::action_wrapper<"changelog"_n, &yottatoken::changelog>;
+      using setreward_action = eosio::action_wrapper<"setreward"_n, &yottatoken::setreward>;
+      using addreward_action = eosio::action_wrapper<"addreward"_n, &yottatoken::addreward>;
+      using claimreward_action = eosio::action_wrapper<"claimreward"_n, &yottatoken::claimreward>;
+      using regsubledger_action = eosio::action_wrapper<"regsubledger"_n, &yottatoken::regsubledger>;
+      using subtransfer_action = eosio::action_wrapper<"subtransfer"_n, &yottatoken::subtransfer>;
+      using submove_action = eosio::action_wrapper<"submove"_n, &yottatoken::submove>;
+      using subwithdraw_action = eosio::action_wrapper<"subwithdraw"_n, &yottatoken::subwithdraw>;
+      using setchainid_action = eosio::action_wrapper<"setchainid"_n, &yottatoken::setchainid>;
+      using setrelaykey_action = eosio::action_wrapper<"setrelaykey"_n, &yottatoken::setrelaykey>;
+      using relay_action = eosio::action_wrapper<"relay"_n, &yottatoken::relay>;
+
+      static constexpr uint32_t no_lock_ruleid = 1; //reserved lock rule id for unlocked airdrop leaves
 
    private:
+      std::vector<change> _changes;
+
       struct [[eosio::table]] reginfo {
          uint32_t    next_tokenno;
          uint32_t    tokens_count;
@@ -331,6 +651,18 @@ class [[eosio::contract("yotta.token")]] yottatoken : public contract {
       };
       typedef eosio::multi_index< "lockrule"_n, lockrule> lockrules;
 
+      struct [[eosio::table]] lockrule2 {
+         uint32_t                lockruleid;
+         std::vector<uint32_t>   times;
+         std::vector<uint16_t>   pcts; //lock percentage's numerator
+         uint32_t                base; //lock percentage's denominator
+         uint32_t                period;
+         string                  desc;
+
+         uint32_t                primary_key()const { return lockruleid; }
+      };
+      typedef eosio::multi_index< "lockrule2"_n, lockrule2> lockrules2;
+
       struct [[eosio::table]] acclock {
          uint64_t        no_ruleid;
          asset           quantity;
@@ -344,6 +676,16 @@ class [[eosio::contract("yotta.token")]] yottatoken : public contract {
                                   eosio::indexed_by< "symbol"_n, eosio::const_mem_fun<acclock, uint64_t, &acclock::get_symbol> >
                                 > acclocks;
 
+      //scope is the user, the symbol is given by tokenno in no_ruleid
+      struct [[eosio::table]] acclock2 {
+         uint64_t        no_ruleid; //(tokenno << 32) + lockruleid
+         int64_t         amount;
+         uint32_t        time;
+
+         uint64_t primary_key()const { return no_ruleid; }
+      };
+      typedef eosio::multi_index< "acclock2"_n, acclock2> acclocks2;
+
       struct [[eosio::table]] numlock {
          name            user;
          asset           quantity;
@@ -352,6 +694,14 @@ class [[eosio::contract("yotta.token")]] yottatoken : public contract {
       };
       typedef eosio::multi_index< "numlock"_n, numlock> numlocks;
 
+      struct [[eosio::table]] numlock2 {
+         name            user;
+         int64_t         amount;
+
+         uint64_t        primary_key()const { return user.value; }
+      };
+      typedef eosio::multi_index< "numlock2"_n, numlock2> numlocks2;
+
       struct [[eosio::table]] tokeninfo {
          uint32_t    tokenno;
          string      tokenname;
@@ -401,6 +751,15 @@ class [[eosio::contract("yotta.token")]] yottatoken : public contract {
       };
       typedef eosio::multi_index< "loanpool"_n, loanpool> loanpools;
 
+      struct [[eosio::table]] loanpool2 {
+         name            from;
+         name            manager;
+         int64_t         amount;
+
+         uint64_t        primary_key()const { return from.value; }
+      };
+      typedef eosio::multi_index< "loanpool2"_n, loanpool2> loanpools2;
+
       struct [[eosio::table]] userreg {
          name        user;
          uint32_t    reg_count;
@@ -411,7 +770,203 @@ class [[eosio::contract("yotta.token")]] yottatoken : public contract {
       };
       typedef eosio::multi_index< "userreg"_n, userreg> userregs;
 
-      void sub_balance( const name& owner, const asset& value );
+      struct [[eosio::table]] airdrop {
+         uint32_t        dropid;
+         name            owner;
+         checksum256     root;
+         asset           remaining; //escrowed asset not claimed yet
+         uint32_t        deadline;
+
+         uint64_t        primary_key()const { return dropid; }
+      };
+      typedef eosio::multi_index< "airdrop"_n, airdrop> airdrops;
+
+      struct [[eosio::table]] claimbitmap {
+         uint64_t        word; //(dropid << 32) + index / 64
+         uint64_t        bits;
+
+         uint64_t        primary_key()const { return word; }
+      };
+      typedef eosio::multi_index< "claimbitmap"_n, claimbitmap> claimbitmaps;
+
+      struct [[eosio::table]] ckptconfig {
+         symbol          sym;
+         uint32_t        tokenno;
+         uint32_t        interval; //seconds
+         uint32_t        max_count;
+         uint32_t        start; //first interval boundary after enabling, history begins here
+
+         uint64_t        primary_key()const { return sym.code().raw(); }
+      };
+      typedef eosio::multi_index< "ckptconfig"_n, ckptconfig> ckptconfigs;
+
+      struct [[eosio::table]] balckpt {
+         uint64_t        no_time; //(tokenno << 32) + start of an interval
+         int64_t         balance; //balance at that time
+
+         uint64_t        primary_key()const { return no_time; }
+      };
+      typedef eosio::multi_index< "balckpt"_n, balckpt> balckpts;
+
+      struct [[eosio::table]] stream {
+         uint64_t        streamid;
+         name            sender;
+         name            recipient;
+         asset           quantity;
+         int64_t         withdrawn; //amount already paid to the recipient
+         uint32_t        start;
+         uint32_t        end;
+
+         uint64_t        primary_key()const { return streamid; }
+         int64_t         accrued( uint64_t curtime )const {
+            if( curtime <= start ) return 0;
+            if( curtime >= end ) return quantity.amount;
+            return (int64_t)( (uint128_t)quantity.amount * (curtime - start) / (end - start) );
+         }
+      };
+      typedef eosio::multi_index< "stream"_n, stream> streams;
+
+      static constexpr uint128_t reward_scale = 1000000000000000000ULL; //precision of reward index
+
+      struct [[eosio::table]] rewardstate {
+         symbol          sym;
+         uint128_t       index; //rewards per token, multiplied by reward_scale
+
+         uint64_t        primary_key()const { return sym.code().raw(); }
+      };
+      typedef eosio::multi_index< "rewardstate"_n, rewardstate> rewardstates;
+
+      //scope is the account, without a row the account has not changed balance since rewards were enabled
+      struct [[eosio::table]] rewardacc {
+         symbol          sym;
+         uint128_t       paid_index; //index the balance has been settled to
+         int64_t         pending; //rewards earned and not claimed
+
+         uint64_t        primary_key()const { return sym.code().raw(); }
+      };
+      typedef eosio::multi_index< "rewardacc"_n, rewardacc> rewardaccs;
+
+      struct [[eosio::table]] subledger {
+         name            owner;
+         int64_t         allocated; //sum of the sub-account balances
+
+         uint64_t        primary_key()const { return owner.value; }
+      };
+      typedef eosio::multi_index< "subledger"_n, subledger> subledgers;
+
+      //scope is the sub-ledger owner
+      struct [[eosio::table]] subbalance {
+         uint64_t        no_subid; //(tokenno << 32) + subid
+         int64_t         balance;
+
+         uint64_t        primary_key()const { return no_subid; }
+      };
+      typedef eosio::multi_index< "subbalance"_n, subbalance> subbalances;
+
+      struct [[eosio::table]] chaininfo {
+         checksum256     chain_id;
+      };
+      typedef eosio::singleton< "chaininfo"_n, chaininfo > chaininfo_singleton;
+
+      struct [[eosio::table]] relaykey {
+         name            account;
+         public_key      key;
+
+         uint64_t        primary_key()const { return account.value; }
+      };
+      typedef eosio::multi_index< "relaykey"_n, relaykey> relaykeys;
+
+      //scope is the account which signs
+      struct [[eosio::table]] noncebitmap {
+         uint64_t        word; //nonce / 64
+         uint64_t        bits;
+
+         uint64_t        primary_key()const { return word; }
+      };
+      typedef eosio::multi_index< "noncebitmap"_n, noncebitmap> noncebitmaps;
+
+      /**
+       * The lock rows of a holder in one token, read by `yotta::locked_balance`.
+       */
+      struct lock_store {
+         name        user;
+         symbol_code code;
+         uint64_t    prefix; //tokenno << 32
+         numlocks2   numlock2_table;
+         numlocks    numlock_table;
+         acclocks2   acclock2_table;
+         acclocks    acclock_table;
+         lockrules2  lockrule2_table;
+         lockrules   lockrule_table;
+
+         lock_store( const name& self, const name& user, const symbol_code& code, uint32_t tokenno )
+         : user(user), code(code), prefix((uint64_t)tokenno << 32),
+           numlock2_table(self, code.raw()), numlock_table(self, code.raw()),
+           acclock2_table(self, user.value), acclock_table(self, user.value),
+           lockrule2_table(self, code.raw()), lockrule_table(self, code.raw()) {}
+
+         bool numlock( int64_t& amount ) {
+            auto it = numlock2_table.find( user.value );
+            if( it == numlock2_table.end() ) return false;
+            amount = it->amount;
+            return true;
+         }
+
+         bool numlock_v1( int64_t& amount ) {
+            auto it = numlock_table.find( user.value );
+            if( it == numlock_table.end() ) return false;
+            amount = it->quantity.amount;
+            return true;
+         }
+
+         template<typename F>
+         void each_acclock( F&& f ) {
+            for( auto it = acclock2_table.lower_bound( prefix ); it != acclock2_table.end() && it->no_ruleid < prefix + ((uint64_t)1 << 32); it++ ) {
+               f( it->no_ruleid, it->amount );
+            }
+         }
+
+         template<typename F>
+         void each_acclock_v1( F&& f ) {
+            auto _sym_lock = acclock_table.get_index<"symbol"_n>();
+            for( auto it = _sym_lock.find( code.raw() ); it != _sym_lock.end() && it->quantity.symbol.code() == code; it++ ) {
+               f( it->no_ruleid, it->quantity.amount );
+            }
+         }
+
+         template<typename F>
+         bool rule( uint32_t lockruleid, F&& f ) {
+            auto it = lockrule2_table.find( lockruleid );
+            if( it == lockrule2_table.end() ) return false;
+            f( it->times, it->pcts, it->base, it->period );
+            return true;
+         }
+
+         template<typename F>
+         bool rule_v1( uint32_t lockruleid, F&& f ) {
+            auto it = lockrule_table.find( lockruleid );
+            if( it == lockrule_table.end() ) return false;
+            f( it->times, it->pcts, it->base, it->period );
+            return true;
+         }
+      };
+
+      void sub_balance( const name& owner, const asset& value, const name& ram_payer );
       void add_balance( uint64_t namevalue, uint64_t symbol, const asset& value, const name& ram_payer, bool bcreate );
       asset get_lock_asset( const name& user, const asset& value );
+      void add_lock( const name& ram_payer, const name& to, const asset& quantity, uint32_t lockruleid );
+      void record_checkpoint( const name& owner, int64_t before, const symbol& sym, const name& ram_payer );
+      void balance_changed( const name& owner, int64_t before, const asset& balance, const name& ram_payer );
+      void settle_reward( const name& owner, int64_t balance, const symbol& sym, const name& ram_payer );
+      void add_sub_balance( const name& owner, const symbol_code& code, uint64_t no_subid, int64_t amount,
+                            const name& ram_payer );
+      void sub_sub_balance( const name& owner, const symbol_code& code, uint64_t no_subid, int64_t amount );
+      void log_change( uint8_t kind, const name& account, const symbol_code& code, uint64_t key,
+                       int64_t before, int64_t after );
+      int64_t get_loan_amount( const name& from, const symbol& sym );
+      int64_t get_allocated( const name& owner, const symbol& sym );
+      void upgrade_numlock( const symbol_code& code, const name& user );
+      void upgrade_loan( const symbol_code& code, const name& from );
+      uint32_t upgrade_acclock( const symbol_code& code, const name& user );
+      void upgrade_lockrule( const symbol_code& code, uint32_t lockruleid );
 };
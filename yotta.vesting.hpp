@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Vesting math of yotta.token lock rules, the walk over a holder's lock rows and the balance
+ * encumbrance check.
+ *
+ * This header has no eosio dependency so that the contract and off-chain consumers (indexers,
+ * exporters, client libraries, differential tests) compute locked and spendable balances with
+ * exactly the same arithmetic.
+ */
+namespace yotta {
+
+   /**
+    * Returns how much of a tranche of `amount` locked by a rule is still locked at `curtime`.
+    *
+    * @param amount - the locked quantity of the tranche,
+    * @param extime - the exchanging time of the token (`currency_stat.time`),
+    * @param curtime - the current time in seconds,
+    * @param times - unlock times relative to `extime`, one element means lock by period,
+    * @param pcts - unlocked percentage's numerator for each time,
+    * @param base - percentage's denominator,
+    * @param period - unlock period when locking by period.
+    *
+    * `Times` and `Pcts` only need `size()` and `operator[]`.
+    */
+   template<typename Times, typename Pcts>
+   int64_t locked_amount( int64_t amount, uint64_t extime, uint64_t curtime,
+                          const Times& times, const Pcts& pcts, uint32_t base, uint32_t period )
+   {
+      if ( extime == 0 || curtime <= extime ) {
+         return amount;
+      }
+
+      uint32_t percent = 0;
+      if ( times.size() == 1 ) { //lock by period
+         int64_t numerator = (int64_t)curtime - (int64_t)extime - (int64_t)times[0];
+         int64_t periods = numerator / (int64_t)period;
+         if (numerator > 0 && periods >= 1) {
+            percent = pcts[0] * periods;
+            if (percent < base) {
+               percent = base - percent;
+               return (int64_t)( (double)amount * percent / base);
+            }
+            return 0;
+         }
+         return amount;
+      }
+
+      for( size_t n = 0; n < times.size(); n++ ) {
+         if( extime + times[n] > curtime ) {
+            break;
+         }
+         percent = pcts[n];
+      }
+      percent = base - percent;
+      return (int64_t)( (double)amount * percent / base);
+   }
+
+   /**
+    * Returns the locked part of a holder's balance of one token, the table walk of `get_lock_asset`.
+    *
+    * `Store` gives the holder's rows of the token, each new v2 table falling back to the old one:
+    * - `bool numlock( int64_t& amount )` and `numlock_v1`, false when there is no row,
+    * - `void each_acclock( F&& f )` and `each_acclock_v1`, calling `f( no_ruleid, amount )` on each tranche,
+    * - `bool rule( uint32_t lockruleid, F&& f )` and `rule_v1`, calling `f( times, pcts, base, period )`,
+    *   false when the rule does not exist.
+    *
+    * @param extime - the exchanging time of the token (`currency_stat.time`),
+    * @param curtime - the current time in seconds.
+    */
+   template<typename Store>
+   int64_t locked_balance( Store& store, uint64_t extime, uint64_t curtime )
+   {
+      int64_t locked = 0;
+      if ( !store.numlock( locked ) ) {
+         store.numlock_v1( locked );
+      }
+
+      auto tranche = [&]( uint64_t no_ruleid, int64_t amount ) {
+         uint32_t lockruleid = no_ruleid & 0xffffffff;
+         int64_t  left = amount; //a tranche whose rule does not exist stays locked
+         auto vest = [&]( const auto& times, const auto& pcts, uint32_t base, uint32_t period ) {
+            left = locked_amount( amount, extime, curtime, times, pcts, base, period );
+         };
+         if ( !store.rule( lockruleid, vest ) ) {
+            store.rule_v1( lockruleid, vest );
+         }
+         locked += left;
+      };
+      store.each_acclock( tranche );
+      store.each_acclock_v1( tranche );
+      return locked;
+   }
+
+   /**
+    * Returns whether `amount` can leave a balance, the check of `sub_balance` and `approve`.
+    *
+    * @param balance - the balance of the account,
+    * @param locked - the locked part, see `get_lock_asset`,
+    * @param loaned - the part approved to a loan manager, plus the sub-account balances of a sub-ledger owner,
+    * @param amount - the amount to spend or approve.
+    */
+   inline bool can_spend( int64_t balance, int64_t locked, int64_t loaned, int64_t amount )
+   {
+      return balance - locked - loaned >= amount;
+   }
+
+} /// namespace yotta